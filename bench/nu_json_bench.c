@@ -0,0 +1,697 @@
+// NOTE: Benchmark of nu_json on generated corpora.  Build it from the
+// repository root with
+//
+//     cc -O2 -I. bench/nu_json_bench.c -o nu_json_bench -lpthread
+//
+// and run it as
+//
+//     ./nu_json_bench [--size MB] [--iterations N] [--threads N] [--corpus NAME] [FILE...]
+//
+// Corpora are generated with a fixed seed so runs are comparable:
+// twitter (string heavy), canada (number heavy), nested (deep),
+// wide (one object with many keys) and ndjson (log lines).  FILEs are
+// benchmarked as they are, in addition to or instead of (--corpus none)
+// the generated ones.  Each measurement is printed as one JSON object
+// per line, the best of the iterations is kept.
+//
+// canada is also converted number by number with strtod.  Parsing the
+// whole document has to be faster than that alone, otherwise number
+// parsing has regressed, which is reported and makes the exit status
+// 1.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+typedef struct BenchBuffer
+{
+    char* data;
+    unsigned long long size;
+    unsigned long long capacity;
+} BenchBuffer;
+
+typedef struct BenchOptions
+{
+    unsigned long long size;
+    unsigned int iterations;
+    unsigned int threads;
+    const char* corpus;
+} BenchOptions;
+
+static unsigned long long bench_random_state = 0x9E3779B97F4A7C15ull;
+
+static double bench_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+// NOTE: xorshift64*, the corpora only need to be the same on every run.
+static unsigned long long bench_random(void)
+{
+    bench_random_state ^= bench_random_state >> 12;
+    bench_random_state ^= bench_random_state << 25;
+    bench_random_state ^= bench_random_state >> 27;
+
+    return bench_random_state * 0x2545F4914F6CDD1Dull;
+}
+
+static unsigned int bench_random_range(unsigned int range)
+{
+    return (unsigned int)(bench_random() % range);
+}
+
+static double bench_random_double(void)
+{
+    return (double)(bench_random() >> 11) / 9007199254740992.0;
+}
+
+static void* bench_alloc(void* user_data, unsigned long long size)
+{
+    (void)user_data;
+
+    return malloc((size_t)size);
+}
+
+static void bench_free(void* user_data, void* memory, unsigned long long size)
+{
+    (void)user_data;
+    (void)size;
+
+    free(memory);
+}
+
+static void bench_append(BenchBuffer* buffer, const char* data, unsigned long long size)
+{
+    if (buffer->size + size + 1 > buffer->capacity)
+    {
+        buffer->capacity = (buffer->size + size + 1) * 2;
+        buffer->data = realloc(buffer->data, (size_t)buffer->capacity);
+
+        if (!buffer->data)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    memcpy(buffer->data + buffer->size, data, (size_t)size);
+    buffer->size += size;
+    buffer->data[buffer->size] = '\0';
+}
+
+static void bench_appendf(BenchBuffer* buffer, const char* format, ...)
+{
+    char text[512];
+    va_list args;
+    int length = 0;
+
+    va_start(args, format);
+    length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    bench_append(buffer, text, (unsigned long long)(length < (int)sizeof(text) ? length : (int)sizeof(text) - 1));
+}
+
+static void bench_append_words(BenchBuffer* buffer, unsigned int word_count)
+{
+    static const char* words[] =
+    {
+        "lorem", "ipsum", "dolor", "sit", "amet", "json", "parser", "arena", "\\u00e9t\\u00e9",
+        "\\\"quoted\\\"", "caf\\u00e9", "line\\nbreak", "https:\\/\\/example.com\\/path", "#hashtag", "@user",
+    };
+    unsigned int i = 0;
+
+    for (i = 0; i < word_count; ++i)
+    {
+        const char* word = words[bench_random_range(sizeof(words) / sizeof(words[0]))];
+
+        if (i)
+        {
+            bench_append(buffer, " ", 1);
+        }
+
+        bench_append(buffer, word, strlen(word));
+    }
+}
+
+static void bench_generate_twitter(BenchBuffer* buffer, unsigned long long size)
+{
+    unsigned int i = 0;
+
+    bench_appendf(buffer, "{\"statuses\":[");
+
+    for (i = 0; buffer->size < size; ++i)
+    {
+        unsigned long long id = 1000000000000000000ull + bench_random() % 1000000000000000ull;
+
+        bench_appendf(buffer, "%s{\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"", i ? "," : "", id, id);
+        bench_append_words(buffer, 8 + bench_random_range(16));
+        bench_appendf(buffer, "\",\"user\":{\"id\":%u,\"name\":\"user_%u\",\"screen_name\":\"", bench_random_range(100000000), i);
+        bench_append_words(buffer, 2);
+        bench_appendf(buffer, "\",\"description\":\"");
+        bench_append_words(buffer, 4 + bench_random_range(12));
+        bench_appendf(buffer, "\",\"followers_count\":%u,\"verified\":%s,\"url\":null},", bench_random_range(1000000), bench_random_range(10) ? "false" : "true");
+        bench_appendf(buffer, "\"entities\":{\"hashtags\":[{\"text\":\"tag%u\",\"indices\":[%u,%u]}],\"urls\":[]},", bench_random_range(1000), bench_random_range(50), 50 + bench_random_range(50));
+        bench_appendf(buffer, "\"retweet_count\":%u,\"favorited\":false,\"lang\":\"en\",\"in_reply_to_status_id\":null}", bench_random_range(10000));
+    }
+
+    bench_appendf(buffer, "]}");
+}
+
+static void bench_generate_canada(BenchBuffer* buffer, unsigned long long size)
+{
+    unsigned int i = 0;
+
+    bench_appendf(buffer, "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[");
+
+    for (i = 0; buffer->size < size; ++i)
+    {
+        unsigned int j = 0;
+
+        bench_appendf(buffer, "%s[", i ? "," : "");
+
+        for (j = 0; j < 256; ++j)
+        {
+            bench_appendf(buffer, "%s[%.15f,%.15f]", j ? "," : "", -141.0 + bench_random_double() * 88.0, 41.0 + bench_random_double() * 42.0);
+        }
+
+        bench_appendf(buffer, "]");
+    }
+
+    bench_appendf(buffer, "]}}]}");
+}
+
+static void bench_generate_nested(BenchBuffer* buffer, unsigned long long size)
+{
+    unsigned int i = 0;
+
+    bench_appendf(buffer, "{\"items\":[");
+
+    for (i = 0; buffer->size < size; ++i)
+    {
+        unsigned int depth = 64 + bench_random_range(192);
+        unsigned int j = 0;
+
+        bench_appendf(buffer, "%s", i ? "," : "");
+
+        for (j = 0; j < depth; ++j)
+        {
+            bench_appendf(buffer, (j & 1) ? "[%u," : "{\"level\":%u,\"next\":", j);
+        }
+
+        bench_appendf(buffer, "null");
+
+        while (j--)
+        {
+            bench_appendf(buffer, (j & 1) ? "]" : "}");
+        }
+    }
+
+    bench_appendf(buffer, "]}");
+}
+
+static void bench_generate_wide(BenchBuffer* buffer, unsigned long long size)
+{
+    unsigned int i = 0;
+
+    bench_appendf(buffer, "{");
+
+    for (i = 0; buffer->size < size; ++i)
+    {
+        bench_appendf(buffer, "%s\"key_%08x_%u\":", i ? "," : "", (unsigned int)bench_random(), i);
+
+        switch (i % 4)
+        {
+            case 0: bench_appendf(buffer, "%u", bench_random_range(1000000)); break;
+            case 1: bench_appendf(buffer, "%.6f", bench_random_double()); break;
+            case 2: bench_appendf(buffer, "\"value %u\"", i); break;
+            default: bench_appendf(buffer, "[%u,true,null]", i); break;
+        }
+    }
+
+    bench_appendf(buffer, "}");
+}
+
+static void bench_generate_ndjson(BenchBuffer* buffer, unsigned long long size)
+{
+    static const char* levels[] = { "debug", "info", "info", "info", "warn", "error" };
+    static const char* paths[] = { "/api/v1/users", "/api/v1/orders", "/health", "/static/app.js", "/api/v2/search?q=caf\\u00e9" };
+    unsigned int i = 0;
+
+    for (i = 0; buffer->size < size; ++i)
+    {
+        bench_appendf(buffer, "{\"ts\":\"2024-01-%02uT%02u:%02u:%02u.%03uZ\",\"level\":\"%s\",\"path\":\"%s\",\"status\":%u,\"latency_ms\":%.3f,\"msg\":\"",
+                      1 + i % 28, bench_random_range(24), bench_random_range(60), bench_random_range(60), bench_random_range(1000),
+                      levels[bench_random_range(6)], paths[bench_random_range(5)], bench_random_range(10) ? 200 : 500, bench_random_double() * 250.0);
+        bench_append_words(buffer, 3 + bench_random_range(10));
+        bench_appendf(buffer, "\",\"request_id\":\"%016llx\",\"retry\":%s}\n", bench_random(), bench_random_range(20) ? "false" : "true");
+    }
+}
+
+static unsigned long long bench_count_nodes(const NUJElement* element)
+{
+    unsigned long long count = 1;
+    unsigned int i = 0;
+
+    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    {
+        for (i = 0; i < NUJ_CHILD_COUNT(element); ++i)
+        {
+            count += bench_count_nodes(NUJ_CHILD(element, i));
+        }
+    }
+
+    return count;
+}
+
+// NOTE: bytes is the input size for parses and the output size for
+// writes.  The arena is only reported for operations that push to a
+// handle, arena_size is 0 for the others.
+static void bench_report(const char* corpus, const char* operation, unsigned long long input_size, unsigned long long node_count, double seconds, unsigned long long arena_size)
+{
+    printf("{\"corpus\":\"%s\",\"operation\":\"%s\",\"bytes\":%llu,\"nodes\":%llu,\"seconds\":%.9f,\"mb_per_s\":%.2f,\"ns_per_node\":%.2f",
+           corpus, operation, input_size, node_count, seconds,
+           seconds > 0.0 ? (double)input_size / seconds / 1e6 : 0.0,
+           node_count ? seconds * 1e9 / (double)node_count : 0.0);
+
+    if (arena_size)
+    {
+        printf(",\"arena_bytes\":%llu,\"arena_bytes_per_input_byte\":%.3f", arena_size, input_size ? (double)arena_size / (double)input_size : 0.0);
+    }
+
+    printf("}\n");
+    fflush(stdout);
+}
+
+// NOTE: Lookups don't read the input or push anything, they are
+// reported per lookup.  nodes is how many nodes are searched, seconds
+// the time of all lookup_count lookups.
+static void bench_report_lookups(const char* corpus, const char* operation, unsigned long long node_count, unsigned long long lookup_count, double seconds)
+{
+    printf("{\"corpus\":\"%s\",\"operation\":\"%s\",\"nodes\":%llu,\"lookups\":%llu,\"seconds\":%.9f,\"ns_per_lookup\":%.2f}\n",
+           corpus, operation, node_count, lookup_count, seconds,
+           lookup_count ? seconds * 1e9 / (double)lookup_count : 0.0);
+    fflush(stdout);
+}
+
+// NOTE: Parses with and without views, then times lookups and
+// serialization on the parsed tree.  input must be a JSON object.
+// Returns the best time of the plain parse, 0 if input is invalid.
+static double bench_document(const BenchOptions* options, const char* corpus, const unsigned char* input, unsigned long long input_size)
+{
+    NUJHandle handle = nuj_init_chained(bench_alloc, bench_free, 0, 1 << 20, 0);
+    NUJElement* root = 0;
+    double parse_seconds = 0.0;
+    unsigned long long node_count = 0;
+    unsigned long long arena_size = 0;
+    unsigned long long output_size = 0;
+    char* output = 0;
+    double best = 0.0;
+    unsigned int flags = 0;
+    unsigned int i = 0;
+
+    static const struct
+    {
+        const char* operation;
+        unsigned int flags;
+    } parses[] =
+    {
+        { "parse", NUJ_PARSE_SOFT_ERRORS },
+        { "parse_index_keys", NUJ_PARSE_SOFT_ERRORS | NUJ_PARSE_INDEX_KEYS },
+        { "parse_views", NUJ_PARSE_SOFT_ERRORS | NUJ_PARSE_VIEWS },
+    };
+
+    for (flags = 0; flags < sizeof(parses) / sizeof(parses[0]); ++flags)
+    {
+        for (i = 0; i < options->iterations; ++i)
+        {
+            double start = bench_now();
+            double seconds = 0.0;
+
+            root = nuj_parse_flags(handle, input, input_size, parses[flags].flags);
+            seconds = bench_now() - start;
+            best = !i || seconds < best ? seconds : best;
+        }
+
+        if (!root)
+        {
+            fprintf(stderr, "%s: not a valid JSON object\n", corpus);
+            nuj_release(handle);
+            return 0.0;
+        }
+
+        parse_seconds = flags ? parse_seconds : best;
+        node_count = bench_count_nodes(root);
+        arena_size = nuj_get_used_size(handle);
+        bench_report(corpus, parses[flags].operation, input_size, node_count, best, arena_size);
+    }
+
+    // NOTE: A name that doesn't exist, so the whole tree is searched.
+    for (i = 0; i < options->iterations; ++i)
+    {
+        double start = bench_now();
+        double seconds = 0.0;
+        NUJElement* found = nuj_find_element_by_name(root, "__missing__");
+
+        seconds = bench_now() - start;
+        best = !i || seconds < best ? seconds : best;
+
+        if (found)
+        {
+            fprintf(stderr, "%s: unexpected match\n", corpus);
+        }
+    }
+
+    bench_report_lookups(corpus, "find_element_by_name", node_count, 1, best);
+
+    // NOTE: Every child of the root looked up by name, through the
+    // key index built on the first lookup.
+    if (root->type == NUJObject_TYPE && NUJ_CHILD_COUNT(root) > 1)
+    {
+        unsigned int child_count = NUJ_CHILD_COUNT(root);
+        char** names = malloc(child_count * sizeof(char*));
+
+        for (i = 0; i < child_count; ++i)
+        {
+            unsigned int length = 0;
+            const char* name = nuj_get_name(NUJ_CHILD(root, i), &length);
+
+            names[i] = malloc(length + 1);
+            memcpy(names[i], name, length);
+            names[i][length] = '\0';
+        }
+
+        nuj_find_child_by_name(handle, root, names[0]);
+
+        for (i = 0; i < options->iterations; ++i)
+        {
+            double start = bench_now();
+            double seconds = 0.0;
+            unsigned int j = 0;
+            unsigned int found_count = 0;
+
+            for (j = 0; j < child_count; ++j)
+            {
+                found_count += nuj_find_child_by_name(handle, root, names[j]) != 0;
+            }
+
+            seconds = bench_now() - start;
+            best = !i || seconds < best ? seconds : best;
+
+            if (found_count != child_count)
+            {
+                fprintf(stderr, "%s: %u of %u children found\n", corpus, found_count, child_count);
+            }
+        }
+
+        bench_report_lookups(corpus, "find_child_by_name", child_count, child_count, best);
+
+        for (i = 0; i < child_count; ++i)
+        {
+            free(names[i]);
+        }
+
+        free(names);
+    }
+
+    // NOTE: nuj_print goes to stdout, which is where the results go, so
+    // serialization is timed through nuj_write.
+    for (flags = 0; flags < 2; ++flags)
+    {
+        unsigned int write_flags = flags ? NUJ_WRITE_PRETTY : 0;
+
+        output_size = nuj_write(root, 0, 0, write_flags) + 1;
+        output = malloc((size_t)output_size);
+
+        for (i = 0; i < options->iterations; ++i)
+        {
+            double start = bench_now();
+            double seconds = 0.0;
+
+            nuj_write(root, output, output_size, write_flags);
+            seconds = bench_now() - start;
+            best = !i || seconds < best ? seconds : best;
+        }
+
+        bench_report(corpus, flags ? "write_pretty" : "write", output_size - 1, node_count, best, 0);
+        free(output);
+    }
+
+    nuj_release(handle);
+
+    return parse_seconds;
+}
+
+// NOTE: Converts every number of input with strtod, skipping the rest,
+// and returns the best time.  It is the floor number parsing must
+// beat, see bench_numbers_check.
+static double bench_strtod(const BenchOptions* options, const char* corpus, const unsigned char* input, unsigned long long input_size)
+{
+    unsigned long long number_count = 0;
+    double best = 0.0;
+    double sum = 0.0;
+    unsigned int i = 0;
+
+    for (i = 0; i < options->iterations; ++i)
+    {
+        const char* current = (const char*)input;
+        const char* end = current + input_size;
+        double start = bench_now();
+        double seconds = 0.0;
+
+        number_count = 0;
+
+        while (current < end)
+        {
+            if (*current == '-' || (*current >= '0' && *current <= '9'))
+            {
+                char* number_end = 0;
+
+                sum += strtod(current, &number_end);
+                current = number_end;
+                ++number_count;
+            }
+            else
+            {
+                ++current;
+            }
+        }
+
+        seconds = bench_now() - start;
+        best = !i || seconds < best ? seconds : best;
+    }
+
+    // NOTE: Keeps the conversions from being optimized away.
+    if (sum == 0.5)
+    {
+        fprintf(stderr, "%s: %f\n", corpus, sum);
+    }
+
+    bench_report(corpus, "strtod", input_size, number_count, best, 0);
+
+    return best;
+}
+
+static int bench_numbers_check(const char* corpus, double parse_seconds, double strtod_seconds)
+{
+    int result = parse_seconds > 0.0 && parse_seconds < strtod_seconds;
+
+    if (!result)
+    {
+        fprintf(stderr, "%s: parse takes %.3f s, longer than strtod on its numbers alone (%.3f s)\n", corpus, parse_seconds, strtod_seconds);
+    }
+
+    return result;
+}
+
+static void bench_lines(const BenchOptions* options, const char* corpus, const unsigned char* input, unsigned long long input_size)
+{
+    NUJHandle handles[NUJ_MAX_THREAD_COUNT];
+    unsigned long long record_count = nuj_count_lines(input, input_size);
+    NUJElement** roots = malloc((size_t)(record_count ? record_count : 1) * sizeof(NUJElement*));
+    unsigned int thread_counts[2] = { 1, options->threads };
+    unsigned int t = 0;
+
+    for (t = 0; t < 2 && (!t || thread_counts[t] > 1); ++t)
+    {
+        unsigned int handle_count = thread_counts[t] < NUJ_MAX_THREAD_COUNT ? thread_counts[t] : NUJ_MAX_THREAD_COUNT;
+        unsigned long long node_count = 0;
+        unsigned long long arena_size = 0;
+        double best = 0.0;
+        unsigned int i = 0;
+        unsigned long long r = 0;
+
+        for (i = 0; i < handle_count; ++i)
+        {
+            handles[i] = nuj_init_chained(bench_alloc, bench_free, 0, 1 << 20, 0);
+        }
+
+        for (i = 0; i < options->iterations; ++i)
+        {
+            double start = 0.0;
+            double seconds = 0.0;
+            unsigned int h = 0;
+
+            for (h = 0; h < handle_count; ++h)
+            {
+                nuj_reset_used_size(handles[h]);
+            }
+
+            start = bench_now();
+            nuj_parse_lines(handles, handle_count, input, input_size, 0, roots, record_count);
+            seconds = bench_now() - start;
+            best = !i || seconds < best ? seconds : best;
+        }
+
+        for (r = 0; r < record_count; ++r)
+        {
+            node_count += roots[r] ? bench_count_nodes(roots[r]) : 0;
+        }
+
+        for (i = 0; i < handle_count; ++i)
+        {
+            arena_size += nuj_get_used_size(handles[i]);
+        }
+
+        bench_report(corpus, t ? "parse_lines_threads" : "parse_lines", input_size, node_count, best, arena_size);
+
+        for (i = 0; i < handle_count; ++i)
+        {
+            nuj_release(handles[i]);
+        }
+    }
+
+    free(roots);
+}
+
+static void bench_file(const BenchOptions* options, const char* path)
+{
+    unsigned long long size = 0;
+    const unsigned char* memory = nuj_map_file(path, &size);
+
+    if (!memory)
+    {
+        fprintf(stderr, "%s: can't be read\n", path);
+        return;
+    }
+
+    bench_document(options, path, memory, size);
+    nuj_unmap_file(memory, size);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct
+    {
+        const char* name;
+        void (*generate)(BenchBuffer* buffer, unsigned long long size);
+        int lines;
+        int numbers;
+    } corpora[] =
+    {
+        { "twitter", bench_generate_twitter, 0, 0 },
+        { "canada", bench_generate_canada, 0, 1 },
+        { "nested", bench_generate_nested, 0, 0 },
+        { "wide", bench_generate_wide, 0, 0 },
+        { "ndjson", bench_generate_ndjson, 1, 0 },
+    };
+    BenchOptions options = { 16ull << 20, 5, 4, 0 };
+    int result = 0;
+    int i = 0;
+    unsigned int c = 0;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            options.size = strtoull(argv[++i], 0, 10) << 20;
+        }
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            options.iterations = (unsigned int)strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            options.threads = (unsigned int)strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--corpus") && i + 1 < argc)
+        {
+            options.corpus = argv[++i];
+        }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: %s [--size MB] [--iterations N] [--threads N] [--corpus NAME|none] [FILE...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    options.iterations = options.iterations ? options.iterations : 1;
+    options.threads = options.threads ? options.threads : 1;
+
+    for (c = 0; c < sizeof(corpora) / sizeof(corpora[0]); ++c)
+    {
+        if (!options.corpus || !strcmp(options.corpus, corpora[c].name))
+        {
+            BenchBuffer buffer = { 0 };
+
+            corpora[c].generate(&buffer, options.size);
+
+            if (corpora[c].lines)
+            {
+                bench_lines(&options, corpora[c].name, (const unsigned char*)buffer.data, buffer.size);
+            }
+            else
+            {
+                double parse_seconds = bench_document(&options, corpora[c].name, (const unsigned char*)buffer.data, buffer.size);
+
+                if (corpora[c].numbers &&
+                    !bench_numbers_check(corpora[c].name, parse_seconds, bench_strtod(&options, corpora[c].name, (const unsigned char*)buffer.data, buffer.size)))
+                {
+                    result = 1;
+                }
+            }
+
+            free(buffer.data);
+        }
+    }
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (argv[i][0] == '-')
+        {
+            ++i;
+        }
+        else
+        {
+            bench_file(&options, argv[i]);
+        }
+    }
+
+    return result;
+}
@@ -8,15 +8,127 @@
 #include <string.h>
 #endif
 
-// TODO: We should #ifdef this.
+#ifndef NUJ_NO_STDLIB
+#include <stdlib.h>
+#endif
+
+// NOTE: Define NUJDEF before including to give the functions another
+// linkage, by default every file that has the implementation gets its
+// own copy.
+#ifndef NUJDEF
 #define NUJDEF static
+#endif
 
-typedef struct NUJHandle* NUJHandle;
+typedef struct NUJHandleInternal* NUJHandle;
 typedef struct NUJElement NUJElement;
+typedef struct NUJPath    NUJPath;
+typedef struct NUJPushParser NUJPushParser;
+typedef struct NUJDocument NUJDocument;
+typedef struct NUJTape     NUJTape;
+typedef struct NUJInternTable NUJInternTable;
+
+typedef void* NUJAllocFunc(void* user_data, unsigned long long size);
+typedef void  NUJFreeFunc(void* user_data, void* memory, unsigned long long size);
+
+typedef enum NUJParseFlags
+{
+    NUJ_PARSE_INDEX_KEYS = 1 << 0,
+    // NOTE: Strings and names point into the input buffer instead of
+    // being copied, so the buffer must outlive the elements.  They
+    // are not null terminated, use their lengths.
+    NUJ_PARSE_VIEWS      = 1 << 1,
+    // NOTE: Invalid input makes the parse return 0 instead of asserting.
+    // What was pushed before the error stays in the handle.  A full
+    // handle makes the parse return 0 even without this flag.
+    NUJ_PARSE_SOFT_ERRORS = 1 << 2,
+} NUJParseFlags;
+
+typedef enum NUJWriteFlags
+{
+    NUJ_WRITE_PRETTY = 1 << 0,
+    // NOTE: Escapes strings and names, for trees whose strings were
+    // decoded by nuj_parse_insitu or nuj_decode_string.
+    NUJ_WRITE_ESCAPE = 1 << 1,
+} NUJWriteFlags;
+
+typedef enum NUJDocumentFlags
+{
+    // NOTE: Stores the parent of every node, otherwise parents are
+    // searched for.
+    NUJ_DOCUMENT_PARENTS = 1 << 0,
+} NUJDocumentFlags;
+
+// NOTE: Size of NUJStats.element_counts, which is indexed by element
+// type.
+#define NUJ_STATS_ELEMENT_TYPE_COUNT 8
+
+// NOTE: Counters of a handle, filled only when compiled with NUJ_STATS.
+// They add up over every parse to the handle until nuj_reset_stats.
+// indexed_size counts the bytes classified by the structural index, it
+// is above input_size when lookahead classifies a block twice.  Cycles
+// are read from the CPU's time stamp counter, index_cycles and
+// key_index_cycles are part of parse_cycles.
+typedef struct NUJStats
+{
+    unsigned long long parse_count;
+    unsigned long long input_size;
+    unsigned long long scanned_size;
+    unsigned long long indexed_size;
+    unsigned long long token_count;
+    unsigned long long max_depth;
+    unsigned long long element_counts[NUJ_STATS_ELEMENT_TYPE_COUNT];
+    unsigned long long string_copy_size;
+    unsigned long long max_used_size;
+    unsigned long long parse_cycles;
+    unsigned long long index_cycles;
+    unsigned long long key_index_cycles;
+} NUJStats;
+
+// NOTE: A value of a document that is read on demand, see
+// nuj_parse_cursor.  name is the raw key if the value is in an object.
+// length is the size of the value's text, 0 for objects and arrays
+// whose end is only found when they are skipped.
+typedef struct NUJCursor
+{
+    const unsigned char* start;
+    const unsigned char* end;
+    const char* name;
+    unsigned int name_length;
+    unsigned int length;
+    unsigned int type;
+} NUJCursor;
+
+// NOTE: Output sink of nuj_write_to, returns 0 on failure.
+typedef int NUJWriteFunc(void* user_data, const void* data, unsigned long long size);
+
+// NOTE: Event callbacks of nuj_sax_parse, any of them can be 0.
+// Returning 0 from a callback stops parsing.  Keys and strings point
+// into the input buffer and are not null terminated or unescaped.
+typedef struct NUJCallbacks
+{
+    void* user_data;
+    int (*on_start_object)(void* user_data);
+    int (*on_end_object)(void* user_data);
+    int (*on_start_array)(void* user_data);
+    int (*on_end_array)(void* user_data);
+    int (*on_key)(void* user_data, const char* name, unsigned int length);
+    int (*on_string)(void* user_data, const char* value, unsigned int length);
+    int (*on_integer)(void* user_data, long long value);
+    int (*on_double)(void* user_data, double value);
+    int (*on_boolean)(void* user_data, int value);
+    int (*on_null)(void* user_data);
+} NUJCallbacks;
 
 NUJDEF NUJHandle          nuj_init(void* memory, unsigned long long size);
+NUJDEF NUJHandle          nuj_init_chained(NUJAllocFunc* alloc, NUJFreeFunc* free, void* user_data, unsigned long long block_size, unsigned long long max_size);
+NUJDEF void*              nuj_alloc_huge_pages(void* user_data, unsigned long long size);
+NUJDEF void               nuj_free_huge_pages(void* user_data, void* memory, unsigned long long size);
+NUJDEF void               nuj_release(NUJHandle handle);
 NUJDEF void               nuj_reset_used_size(NUJHandle handle);
 NUJDEF unsigned long long nuj_get_used_size(const NUJHandle handle);
+NUJDEF unsigned long long nuj_get_init_size(unsigned long long used_size);
+NUJDEF int                nuj_get_stats(const NUJHandle handle, NUJStats* stats);
+NUJDEF void               nuj_reset_stats(NUJHandle handle);
 NUJDEF NUJElement*        nuj_create_element(NUJHandle handle, unsigned int type, unsigned int size);
 NUJDEF NUJElement*        nuj_create_element_string(NUJHandle handle, const char* string);
 NUJDEF NUJElement*        nuj_create_element_integer(NUJHandle handle, long long value);
@@ -26,16 +138,226 @@ NUJDEF NUJElement*        nuj_create_element_null(NUJHandle handle);
 NUJDEF NUJElement*        nuj_create_element_object(NUJHandle handle, unsigned int element_count);
 NUJDEF NUJElement*        nuj_create_element_array(NUJHandle handle, unsigned int element_count);
 NUJDEF NUJElement*        nuj_add_element_element(NUJElement* element, const char* name, NUJElement* child);
+NUJDEF NUJElement*        nuj_insert_element(NUJHandle handle, NUJElement* element, unsigned int index, const char* name, NUJElement* child);
+NUJDEF void               nuj_remove_element(NUJHandle handle, NUJElement* child);
+NUJDEF NUJElement*        nuj_replace_element(NUJHandle handle, NUJElement* child, NUJElement* value);
+NUJDEF void               nuj_rename_element(NUJHandle handle, NUJElement* child, const char* name);
 NUJDEF int                nuj_is_last_object_element(const NUJElement* element);
+NUJDEF const char*        nuj_get_name(const NUJElement* element, unsigned int* length);
+NUJDEF const char*        nuj_get_string(const NUJElement* element, unsigned int* length);
+NUJDEF unsigned int       nuj_decode_string(const char* string, unsigned int length, char* buffer);
 NUJDEF void               nuj_printf(const NUJElement* element);
 NUJDEF void               nuj_print(const NUJElement* element);
+NUJDEF unsigned long long nuj_write(const NUJElement* element, char* buffer, unsigned long long buffer_size, unsigned int flags);
+NUJDEF unsigned long long nuj_write_to(const NUJElement* element, NUJWriteFunc* write, void* user_data, char* buffer, unsigned long long buffer_size, unsigned int flags);
 NUJDEF NUJElement*        nuj_find_element_by_name(const NUJElement* element, const char* name);
+NUJDEF NUJElement*        nuj_find_child_by_name(NUJHandle handle, NUJElement* element, const char* name);
+NUJDEF void               nuj_index_keys(NUJHandle handle, NUJElement* element);
+NUJDEF NUJInternTable*    nuj_create_intern_table(NUJHandle handle, unsigned int capacity);
+NUJDEF void               nuj_set_intern_table(NUJHandle handle, NUJInternTable* table);
+NUJDEF void               nuj_freeze_intern_table(NUJInternTable* table);
+NUJDEF const char*        nuj_intern_name(NUJInternTable* table, const char* name, unsigned int length);
+NUJDEF NUJElement*        nuj_find_child_by_interned_name(const NUJElement* element, const char* name);
+NUJDEF NUJPath*           nuj_compile_path(NUJHandle handle, const char* path);
+NUJDEF NUJElement*        nuj_find_element_by_path(const NUJElement* element, const NUJPath* path);
+NUJDEF void               nuj_find_elements_by_paths(const NUJElement* const* elements, unsigned int element_count, const NUJPath* const* paths, unsigned int path_count, NUJElement** results);
+NUJDEF NUJDocument*       nuj_create_document(NUJHandle handle, const NUJElement* element, unsigned int flags);
+NUJDEF unsigned long long nuj_get_document_size(const NUJDocument* document);
+NUJDEF unsigned int       nuj_get_node_type(const NUJDocument* document, unsigned int node);
+NUJDEF const char*        nuj_get_node_name(const NUJDocument* document, unsigned int node, unsigned int* length);
+NUJDEF const char*        nuj_get_node_string(const NUJDocument* document, unsigned int node, unsigned int* length);
+NUJDEF long long          nuj_get_node_integer(const NUJDocument* document, unsigned int node);
+NUJDEF double             nuj_get_node_double(const NUJDocument* document, unsigned int node);
+NUJDEF int                nuj_get_node_boolean(const NUJDocument* document, unsigned int node);
+NUJDEF unsigned int       nuj_get_node_child_count(const NUJDocument* document, unsigned int node);
+NUJDEF unsigned int       nuj_get_node_child(const NUJDocument* document, unsigned int node, unsigned int index);
+NUJDEF unsigned int       nuj_get_node_parent(const NUJDocument* document, unsigned int node);
+NUJDEF unsigned int       nuj_find_node_by_name(const NUJDocument* document, unsigned int node, const char* name);
+NUJDEF unsigned long long nuj_write_snapshot(const NUJDocument* document, NUJWriteFunc* write, void* user_data);
+NUJDEF int                nuj_save_snapshot(const NUJDocument* document, const char* path);
+NUJDEF const NUJDocument* nuj_load_snapshot(const void* memory, unsigned long long size);
+NUJDEF NUJTape*           nuj_parse_tape(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF unsigned long long nuj_get_tape_size(const NUJTape* tape);
+NUJDEF unsigned int       nuj_get_tape_type(const NUJTape* tape, unsigned int entry);
+NUJDEF const char*        nuj_get_tape_name(const NUJTape* tape, unsigned int entry, unsigned int* length);
+NUJDEF unsigned int       nuj_get_tape_value(const NUJTape* tape, unsigned int entry);
+NUJDEF const char*        nuj_get_tape_string(const NUJTape* tape, unsigned int entry, unsigned int* length);
+NUJDEF long long          nuj_get_tape_integer(const NUJTape* tape, unsigned int entry);
+NUJDEF double             nuj_get_tape_double(const NUJTape* tape, unsigned int entry);
+NUJDEF int                nuj_get_tape_boolean(const NUJTape* tape, unsigned int entry);
+NUJDEF unsigned int       nuj_get_tape_child_count(const NUJTape* tape, unsigned int entry);
+NUJDEF unsigned int       nuj_get_tape_first_child(const NUJTape* tape, unsigned int entry);
+NUJDEF unsigned int       nuj_get_tape_next_sibling(const NUJTape* tape, unsigned int entry);
+NUJDEF unsigned int       nuj_skip_tape_element(const NUJTape* tape, unsigned int entry);
+NUJDEF unsigned int       nuj_find_tape_child(const NUJTape* tape, unsigned int entry, const char* name);
+NUJDEF int                nuj_parse_cursor(NUJCursor* cursor, const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF unsigned int       nuj_get_cursor_type(const NUJCursor* cursor);
+NUJDEF const char*        nuj_get_cursor_name(const NUJCursor* cursor, unsigned int* length);
+NUJDEF const char*        nuj_get_cursor_string(const NUJCursor* cursor, unsigned int* length);
+NUJDEF long long          nuj_get_cursor_integer(const NUJCursor* cursor);
+NUJDEF double             nuj_get_cursor_double(const NUJCursor* cursor);
+NUJDEF int                nuj_get_cursor_boolean(const NUJCursor* cursor);
+NUJDEF int                nuj_get_cursor_first_child(const NUJCursor* cursor, NUJCursor* child);
+NUJDEF int                nuj_get_cursor_next_sibling(const NUJCursor* cursor, NUJCursor* sibling);
+NUJDEF int                nuj_get_cursor_sibling_at(const NUJCursor* cursor, const unsigned char* current, NUJCursor* sibling);
+NUJDEF int                nuj_get_cursor_child(const NUJCursor* cursor, unsigned int index, NUJCursor* child);
+NUJDEF unsigned int       nuj_get_cursor_child_count(const NUJCursor* cursor);
+NUJDEF int                nuj_find_cursor_child(const NUJCursor* cursor, const char* name, NUJCursor* child);
+NUJDEF const unsigned char* nuj_skip_cursor(const NUJCursor* cursor);
 NUJDEF NUJElement*        nuj_parse(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF NUJElement*        nuj_parse_flags(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags);
+NUJDEF NUJElement*        nuj_parse_insitu(NUJHandle handle, unsigned char* buffer, unsigned long long buffer_size, unsigned int flags);
+NUJDEF const unsigned char* nuj_map_file(const char* path, unsigned long long* size);
+NUJDEF void               nuj_unmap_file(const unsigned char* memory, unsigned long long size);
+NUJDEF NUJElement*        nuj_parse_file(NUJHandle handle, const char* path, unsigned int flags);
+NUJDEF unsigned long long nuj_measure(const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF unsigned long long nuj_measure_flags(const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags);
+NUJDEF unsigned long long nuj_count_lines(const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF unsigned long long nuj_parse_lines(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count);
+NUJDEF unsigned long long nuj_parse_lines_partial(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count, unsigned long long* consumed_size);
+NUJDEF NUJElement*        nuj_parse_parallel(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags);
+NUJDEF int                nuj_sax_parse(const NUJCallbacks* callbacks, const unsigned char* buffer, unsigned long long buffer_size);
+NUJDEF NUJPushParser*     nuj_push_begin(NUJHandle handle, unsigned int flags);
+NUJDEF int                nuj_push_feed(NUJPushParser* parser, const unsigned char* chunk, unsigned long long chunk_size);
+NUJDEF NUJElement*        nuj_push_end(NUJPushParser* parser);
 
 #ifdef NU_JSON_IMPLEMENTATION
 
+#if !defined(NUJ_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define NUJ_X64 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NUJ_TARGET_AVX2
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define NUJ_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if !defined(NUJ_NO_THREADS)
+#if defined(_WIN32)
+#include <windows.h>
+#define NUJ_WIN32_THREADS 1
+#else
+#include <pthread.h>
+#define NUJ_PTHREADS 1
+#endif
+#endif
+
+#if !defined(NUJ_NO_MMAP)
+#if defined(_WIN32)
+#include <windows.h>
+#define NUJ_WIN32_MMAP 1
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NUJ_POSIX_MMAP 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#if defined(NUJ_STATS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define NUJ_ASSERT(x) do { if (!(x)) { *(volatile int*)0; } } while (0)
 
+// NOTE: Zero initializer for structs.  { 0 } sets every member in C
+// too, but C++ compilers warn about the members it leaves out.
+#ifdef __cplusplus
+#define NUJ_ZERO {}
+#else
+#define NUJ_ZERO { 0 }
+#endif
+
+// NOTE: Objects with fewer children than this are searched linearly,
+// comparing a few names is faster than hashing.
+#ifndef NUJ_KEY_INDEX_MIN_COUNT
+#define NUJ_KEY_INDEX_MIN_COUNT 8
+#endif
+
+// NOTE: Midpoints between doubles have at most this many significant
+// digits, so numbers only need this many to be rounded exactly, the
+// rest only matter if they aren't all 0.
+#define NUJ_MAX_NUMBER_DIGITS 767
+
+// NOTE: nuj_parse_lines and nuj_parse_parallel use at most this many
+// threads.
+#ifndef NUJ_MAX_THREAD_COUNT
+#define NUJ_MAX_THREAD_COUNT 64
+#endif
+
+// NOTE: nuj_parse_parallel gives each thread at least this many bytes
+// and looks this far for a split point.  A split is only taken after
+// the value it starts in closes, so children of the root larger than
+// this, and roots whose children are all scalars, are parsed on fewer
+// threads.  See nuj__find_split for when a split is still wrong.
+#ifndef NUJ_PARALLEL_SLICE_SIZE
+#define NUJ_PARALLEL_SLICE_SIZE (1 << 20)
+#endif
+
+// NOTE: Blocks from nuj_alloc_huge_pages are aligned to and rounded up
+// to this size.
+#ifndef NUJ_HUGE_PAGE_SIZE
+#define NUJ_HUGE_PAGE_SIZE (2 << 20)
+#endif
+
+// NOTE: Maximum nesting and number length of the push parser, its
+// state is fixed size and lives in the handle.
+#ifndef NUJ_PUSH_MAX_DEPTH
+#define NUJ_PUSH_MAX_DEPTH 256
+#endif
+
+#ifndef NUJ_PUSH_MAX_NUMBER_LENGTH
+#define NUJ_PUSH_MAX_NUMBER_LENGTH 64
+#endif
+
+// NOTE: Range of nuj__powers_of_10.  Numbers from 19 digits below
+// 10^-342 are 0 and above 10^308 infinity, and the writer needs the
+// powers up to 10^324 to scale the smallest denormals.
+#define NUJ_MIN_POWER_OF_10 -342
+#define NUJ_MAX_POWER_OF_10 324
+
+// NOTE: Words of NUJBig, enough for 2^3840.  The biggest numbers are
+// made by nuj__compare_midpoint, NUJ_MAX_NUMBER_DIGITS digits times a
+// power of 5.
+#define NUJ_BIG_WORD_COUNT 120
+
+// NOTE: Set by nuj_parse_insitu, strings and names are decoded where
+// they are in the input.
+#define NUJ_PARSE_INSITU (1u << 31)
+
+// NOTE: Without NUJ_STATS these expand to nothing.  NUJ_STATS_BEGIN
+// declares its variable, so it goes with the declarations.
+#ifdef NUJ_STATS
+#define NUJ_STATS_ADD(stats, field, value)  do { if (stats) { (stats)->field += (value); } } while (0)
+#define NUJ_STATS_MAX(stats, field, value)  do { if ((stats) && (stats)->field < (value)) { (stats)->field = (value); } } while (0)
+#define NUJ_STATS_BEGIN(name)               unsigned long long name = nuj__read_cycles();
+#define NUJ_STATS_END(stats, field, name)   NUJ_STATS_ADD(stats, field, nuj__read_cycles() - (name))
+#define NUJ_STATS_ATTACH(parser, handle)    ((parser)->stats = (handle) ? &(handle)->stats : 0)
+#define NUJ_STATS_ENTER(parser)             do { ++(parser)->depth; NUJ_STATS_MAX((parser)->stats, max_depth, (parser)->depth); } while (0)
+#define NUJ_STATS_LEAVE(parser)             (--(parser)->depth)
+#define NUJ_STATS_PARSED(parser, name)      do { NUJ_STATS_ADD((parser)->stats, parse_count, 1);                                   \
+                                                 NUJ_STATS_ADD((parser)->stats, input_size, (parser)->end - (parser)->initial);      \
+                                                 NUJ_STATS_ADD((parser)->stats, scanned_size, (parser)->current - (parser)->initial); \
+                                                 NUJ_STATS_END((parser)->stats, parse_cycles, name); } while (0)
+#else
+#define NUJ_STATS_ADD(stats, field, value)  ((void)0)
+#define NUJ_STATS_MAX(stats, field, value)  ((void)0)
+#define NUJ_STATS_BEGIN(name)
+#define NUJ_STATS_END(stats, field, name)   ((void)0)
+#define NUJ_STATS_ATTACH(parser, handle)    ((void)0)
+#define NUJ_STATS_ENTER(parser)             ((void)0)
+#define NUJ_STATS_LEAVE(parser)             ((void)0)
+#define NUJ_STATS_PARSED(parser, name)      ((void)0)
+#endif
+
 #define NUJ_STRING(x)     ((NUJString*)(x))
 #define NUJ_INTEGER(x)    ((NUJInteger*)(x))
 #define NUJ_DOUBLE(x)     ((NUJDouble*)(x))
@@ -56,40 +378,193 @@ NUJDEF NUJElement*        nuj_parse(NUJHandle handle, const unsigned char* buffe
 #define NUJ_VALUE(element, t)                    (*((t*)(&NUJ_INTEGER(element)->value)))
 #define NUJ_CHILD(element, i)                    (NUJ_OBJECT(element)->children[(i)])
 #define NUJ_CHILD_COUNT(element)                 (NUJ_OBJECT(element)->child_count)
-
-typedef struct NUJParser  NUJParser;
-typedef struct NUJToken   NUJToken;
-
+#define NUJ_SAX_CALL(callbacks, callback, args)  (!(callbacks)->callback || (callbacks)->callback args)
+
+typedef struct NUJBlock       NUJBlock;
+typedef struct NUJKeyIndex    NUJKeyIndex;
+typedef struct NUJPathSegment NUJPathSegment;
+typedef struct NUJPushFrame   NUJPushFrame;
+typedef struct NUJWriter      NUJWriter;
+typedef struct NUJBig         NUJBig;
+typedef struct NUJLinesWorker NUJLinesWorker;
+typedef struct NUJSliceWorker NUJSliceWorker;
+typedef struct NUJThread      NUJThread;
+typedef struct NUJNode        NUJNode;
+typedef struct NUJSnapshot    NUJSnapshot;
+typedef struct NUJParser      NUJParser;
+typedef struct NUJToken       NUJToken;
+typedef struct NUJIndex       NUJIndex;
+typedef struct NUJIndexMasks  NUJIndexMasks;
+typedef struct NUJTapeWriter  NUJTapeWriter;
+
+typedef void NUJIndexClassifyFunc(const unsigned char* block, NUJIndexMasks* masks);
+typedef void NUJWorkerFunc(void* worker);
+
+#ifdef NUJ_STATS
+static inline unsigned long long nuj__read_cycles(void);
+#endif
+static int                nuj__push_block(NUJHandle handle, unsigned int size);
 static void*              nuj__push_size(NUJHandle handle, unsigned int size);
-static unsigned int       nuj__get_element_size(const NUJElement* element);
-static unsigned long long nuj__get_total_element_object_size(const NUJElement* element);
+static void*              nuj__grow_size(NUJHandle handle, void* memory, unsigned int size, unsigned int extra_size);
+static inline unsigned int nuj__get_free_list(unsigned int size, int round_up);
+static void*              nuj__take_free_block(NUJHandle handle, unsigned int size);
+static void*              nuj__alloc_size(NUJHandle handle, unsigned int size);
+static void               nuj__free_size(NUJHandle handle, void* memory, unsigned int size);
+static unsigned int       nuj__get_element_size(unsigned int type);
+static void               nuj__free_element(NUJHandle handle, NUJElement* element);
+static void               nuj__drop_key_index(NUJHandle handle, NUJElement* element);
+static int                nuj__grow_children(NUJHandle handle, NUJElement* element);
+static unsigned int       nuj__get_child_index(const NUJElement* element, const NUJElement* child);
+static inline unsigned int nuj__hash_name(const char* name, unsigned int length);
+static unsigned long long nuj__get_key_index_size(unsigned int child_count);
+static void               nuj__create_key_index(NUJHandle handle, NUJElement* element);
+static NUJElement*        nuj__find_child(const NUJElement* element, const char* name, unsigned int length, unsigned int hash);
+static const char*        nuj__intern_name(NUJInternTable* table, const char* name, unsigned int length, unsigned int hash);
+static int                nuj__grow_intern_table(NUJInternTable* table);
+static int                nuj__can_share_intern_tables(const NUJHandle* handles, unsigned int handle_count);
+static void               nuj__write(NUJWriter* writer, const void* data, unsigned long long size);
+static void               nuj__write_string(NUJWriter* writer, const char* string, unsigned int length);
+static void               nuj__write_integer(NUJWriter* writer, long long value);
+static inline unsigned long long nuj__mul_64(unsigned long long a, unsigned long long b, unsigned long long* high);
+static inline unsigned int nuj__count_leading_zeros(unsigned long long value);
+static inline long long   nuj__floor_shift(long long value, unsigned int shift);
+static void               nuj__big_set(NUJBig* big, unsigned long long value, unsigned int shift);
+static void               nuj__big_mul(NUJBig* big, unsigned int factor);
+static void               nuj__big_mul_add(NUJBig* big, unsigned int factor, unsigned int addend);
+static void               nuj__big_shift(NUJBig* big, unsigned int shift);
+static void               nuj__big_mul_pow10(NUJBig* big, unsigned int power);
+static void               nuj__big_mul_pow5(NUJBig* big, unsigned int power);
+static void               nuj__big_mul_big(NUJBig* result, const NUJBig* a, const NUJBig* b);
+static int                nuj__big_compare(const NUJBig* a, const NUJBig* b);
+static unsigned int       nuj__get_integer_digits(unsigned long long number, char* digits);
+static inline unsigned long long nuj__round_to_odd(unsigned long long g_high, unsigned long long g_low, unsigned long long value);
+static unsigned int       nuj__get_shortest_digits(double value, char* digits, int* point);
+static void               nuj__write_double(NUJWriter* writer, double value);
+static void               nuj__write_newline_and_spaces(NUJWriter* writer, unsigned int depth);
+static void               nuj__write_element(NUJWriter* writer, const NUJElement* element, unsigned int depth);
 static void               nuj__print_newline_and_spaces(unsigned int space_count);
+static inline int          nuj__decode_hex(const char* string, unsigned int* code_point);
+static inline char*        nuj__encode_utf8(char* buffer, unsigned int code_point);
+static unsigned int        nuj__decode_escape(const char* current, const char* end, char* decoded, unsigned int* decoded_length);
 static void               nuj__print_primitive_element(const NUJElement* element);
 static void               nuj__printf(const NUJElement* element, unsigned int depth);
 
+static inline unsigned int nuj__index_ctz(unsigned long long value);
+static inline unsigned long long nuj__index_prefix_xor(unsigned long long value);
+static NUJIndexClassifyFunc* nuj__index_get_classify_func(void);
+static void               nuj__index_next_block(NUJParser* parser);
+static inline const unsigned char* nuj__index_next_structural(NUJParser* parser);
+
 static void               nuj__parse_error(NUJParser* parser, NUJToken token, char expected);
+static void               nuj__parse_init(NUJParser* parser, const unsigned char* buffer, unsigned long long buffer_size);
 static inline int         nuj__parse_is_whitespace_char(char character);
 static inline void        nuj__parse_skip_all_whitespace_chars(NUJParser* parser);
 static inline int         nuj__parse_is_numeric(char character);
 static inline int         nuj__parse_skip_all_numerics(NUJParser* parser);
 static NUJToken           nuj__parse_get_token(NUJParser* parser);
 static inline int         nuj__parse_match_token(NUJToken token, unsigned int match_token_type);
-static double             nuj__parse_token_to_number(NUJToken token, int is_double);
-static NUJElement*        nuj__parse_token_to_element(NUJHandle handle, NUJToken token);
+static int                nuj__compare_midpoint(const NUJBig* digits, const NUJBig* power, int exponent, int is_truncated, unsigned long long bits);
+static unsigned long long nuj__parse_eisel_lemire(unsigned long long mantissa, int exponent);
+static double             nuj__parse_exact_number(const unsigned char* current, const unsigned char* end, int explicit_exponent, unsigned long long bits);
+static int                nuj__parse_token_to_number(NUJToken token, long long* integer, double* number);
+static NUJElement*        nuj__parse_token_to_element(NUJHandle handle, NUJToken token, unsigned int flags);
 static NUJElement*        nuj__parse_element_pair_value(NUJHandle handle, NUJParser* parser);
-static inline void        nuj__parse_set_element_pair_name(NUJHandle handle, NUJElement* element, NUJToken token);
+static inline int         nuj__parse_set_element_pair_name(NUJHandle handle, NUJElement* element, NUJToken token, unsigned int flags);
 static NUJElement*        nuj__parse_element_pair(NUJHandle handle, NUJParser* parser, int in_object);
-static inline void        nuj__parse_add_element_element(NUJElement* element, NUJElement* child);
-static NUJElement*        nuj__parse_create_element_object_or_array(NUJElement* element, NUJElement* first_element);
-static unsigned int       nuj__parse_calculate_element_child_count(NUJParser* parser, unsigned int type);
+static NUJElement*        nuj__parse_create_element_object_or_array(NUJHandle handle, NUJElement* element, NUJElement* last_element, unsigned int element_count);
+static inline unsigned int nuj__parse_link_element(NUJElement* child, NUJElement** last_element);
+static inline int         nuj__parse_match_empty_element(NUJParser* parser, unsigned int close_token_type);
 static NUJElement*        nuj__parse_element_array(NUJHandle handle, NUJParser* parser);
 static NUJElement*        nuj__parse_element_object(NUJHandle handle, NUJParser* parser);
+static int                nuj__push_add_element(NUJPushParser* parser, NUJElement* element);
+static int                nuj__push_close_element(NUJPushParser* parser, unsigned char character);
+static int                nuj__push_end_string(NUJPushParser* parser);
+static int                nuj__push_end_number(NUJPushParser* parser);
+static int                nuj__push_begin_value(NUJPushParser* parser, unsigned char character);
+static int                nuj__sax_element(NUJParser* parser, NUJToken token, const NUJCallbacks* callbacks);
+static inline const unsigned char* nuj__next_line(const unsigned char* current, const unsigned char* end, int* is_blank);
+static NUJElement*        nuj__parse_record(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags);
+static void               nuj__count_lines_worker(void* worker);
+static void               nuj__parse_lines_worker(void* worker);
+static void               nuj__run_workers(void* workers, unsigned int worker_size, unsigned int worker_count, NUJWorkerFunc* func);
+static unsigned long long nuj__parse_lines(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count, unsigned long long* consumed_size);
+static inline int         nuj__is_escaped(const unsigned char* begin, const unsigned char* quote);
+static const unsigned char* nuj__find_split(const unsigned char* begin, const unsigned char* start, const unsigned char* end);
+static void               nuj__split_slice_worker(void* worker);
+static void               nuj__parse_slice_worker(void* worker);
+static NUJElement*        nuj__find_element_by_name(const NUJElement* element, const char* name, unsigned int length, unsigned int hash);
+static void               nuj__compile_path_segment(NUJPathSegment* segment);
+static unsigned long long nuj__measure_element(NUJParser* parser, NUJToken token);
+static void               nuj__count_document_element(const NUJElement* element, unsigned long long* node_count, unsigned long long* string_size);
+static unsigned int       nuj__add_document_string(NUJDocument* document, unsigned int* string_used, const char* string, unsigned int length);
+static void               nuj__fill_document_node(NUJDocument* document, unsigned int node, unsigned int parent, const NUJElement* element, unsigned int* next_node, unsigned int* string_used);
+static inline NUJNode*    nuj__get_document_nodes(const NUJDocument* document);
+static inline unsigned int* nuj__get_document_parents(const NUJDocument* document);
+static inline char*       nuj__get_document_strings(const NUJDocument* document);
+static void               nuj__init_snapshot(NUJSnapshot* snapshot, const NUJDocument* document);
+static int                nuj__tape_element(NUJParser* parser, NUJToken token, NUJTapeWriter* writer);
+static int                nuj__tape_reserve(NUJTapeWriter* writer, unsigned long long word_count, unsigned long long string_size);
+static inline unsigned long long* nuj__tape_add_words(NUJTapeWriter* writer, unsigned int count);
+static inline int         nuj__tape_add_string(NUJTapeWriter* writer, unsigned char tag, NUJToken token);
+static inline unsigned long long* nuj__get_tape_words(const NUJTape* tape);
+static inline char*       nuj__get_tape_strings(const NUJTape* tape);
+static inline const char* nuj__get_tape_word_string(const NUJTape* tape, unsigned long long word, unsigned int* length);
+static const unsigned char* nuj__skip_container(const unsigned char* current, const unsigned char* end);
+static int                nuj__read_cursor(NUJCursor* cursor, const unsigned char* current, const unsigned char* end);
+static int                nuj__read_cursor_child(NUJCursor* child, const unsigned char* current, const unsigned char* end, int in_object);
+static int                nuj__match_cursor_name(const NUJCursor* cursor, const char* name, unsigned int length);
+
+// NOTE: Header of every block of a chained handle except the first
+// one, which holds the handle itself.
+typedef struct NUJBlock
+{
+    struct NUJBlock* next;
+    unsigned long long size;
+} NUJBlock;
+
+// NOTE: Free lists of a handle, see nuj__get_free_list.  Blocks
+// below NUJ_FREE_LIST_SMALL_SIZE have a list per multiple of 8 bytes,
+// larger ones a list per power of two.
+#define NUJ_FREE_LIST_SMALL_SIZE 256
+#define NUJ_FREE_LIST_COUNT      (NUJ_FREE_LIST_SMALL_SIZE / 8 + 24)
+
+typedef struct NUJFreeBlock
+{
+    struct NUJFreeBlock* next;
+    unsigned int size;
+} NUJFreeBlock;
 
-typedef struct NUJHandle
+typedef struct NUJHandleInternal
 {
     unsigned char* buffer;
     unsigned long long buffer_used;
     unsigned long long buffer_size;
+
+    // NOTE: Only used by chained handles.  buffer points to the
+    // current block and used_before is the used size of all blocks
+    // before it.
+    NUJAllocFunc* alloc;
+    NUJFreeFunc* free;
+    void* user_data;
+    NUJBlock* blocks;
+    unsigned long long first_block_size;
+    unsigned long long last_block_size;
+    unsigned long long total_size;
+    unsigned long long max_size;
+    unsigned long long used_before;
+
+    // NOTE: Names of parsed elements are taken from it instead of
+    // being copied, see nuj_set_intern_table.
+    NUJInternTable* intern_table;
+
+    // NOTE: Memory given back by removed elements and grown children
+    // arrays, see nuj__free_size.  Emptied by nuj_reset_used_size.
+    NUJFreeBlock* free_lists[NUJ_FREE_LIST_COUNT];
+    unsigned long long free_count;
+
+#ifdef NUJ_STATS
+    NUJStats stats;
+#endif
 } NUJHandleInternal;
 
 enum NUJElementType
@@ -109,19 +584,62 @@ enum NUJElementType
 
 struct NUJElement
 {
-    unsigned long long type;
+    unsigned int type;
+    unsigned int name_length;
     const char* name;
     struct NUJElement* parent;
 };
 
+// NOTE: index is the key index of an object, 0 until it is built, and
+// always 0 in arrays.  It costs 8 bytes in every object and array,
+// 48 instead of 40, which is 2 to 8% of the arena of a parsed tree.
+// Kept in the node so nuj_find_child_by_name needs no other lookup to
+// find it, and so the children arrays stay plain arrays of pointers.
 typedef struct NUJObject
 {
     struct NUJElement element;
     struct NUJElement** children;
     unsigned int child_count;
     unsigned int max_child_count;
+    struct NUJKeyIndex* index;
 } NUJObject, NUJArray;
 
+// NOTE: Open addressing hash table from child names to children,
+// capacity is a power of two at least twice the child count.
+typedef struct NUJKeyIndexEntry
+{
+    unsigned int hash;
+    unsigned int length;
+    struct NUJElement* element;
+} NUJKeyIndexEntry;
+
+typedef struct NUJKeyIndex
+{
+    unsigned int mask;
+    unsigned int count;
+    NUJKeyIndexEntry entries[];
+} NUJKeyIndex;
+
+// NOTE: Distinct names shared by the handles it is set on, open
+// addressing like NUJKeyIndex.  Every name is pushed to handle once,
+// after its hash, so the hash of an interned name is in the 4 bytes
+// before it.
+typedef struct NUJInternEntry
+{
+    unsigned int hash;
+    unsigned int length;
+    const char* name;
+} NUJInternEntry;
+
+struct NUJInternTable
+{
+    NUJHandle handle;
+    NUJInternEntry* entries;
+    unsigned int mask;
+    unsigned int count;
+    int frozen;
+};
+
 typedef struct NUJInteger
 {
     struct NUJElement element;
@@ -140,16 +658,274 @@ typedef struct NUJBoolean
     long long value;
 } NUJBoolean, NUJNull;
 
+// NOTE: Strings are stored escaped, see nuj_decode_string, unless
+// they were parsed with nuj_parse_insitu.
 typedef struct NUJString
 {
     struct NUJElement element;
     const char* value;
+    unsigned int length;
 } NUJString;
 
+// NOTE: Node of a NUJDocument.  Tag holds the element type in the low
+// 4 bits, a has-name bit and the name length above them, names and
+// strings are offsets into the string area of the document.  Children
+// of a container are consecutive nodes, so a container only stores
+// the first of them and their count.
+typedef struct NUJNode
+{
+    unsigned int tag;
+    unsigned int name;
+    union
+    {
+        long long integer;
+        double number;
+        struct
+        {
+            unsigned int offset;
+            unsigned int length;
+        } string;
+        struct
+        {
+            unsigned int first;
+            unsigned int count;
+        } children;
+    } value;
+} NUJNode;
+
+#define NUJ_NODE_TYPE_BITS  4
+#define NUJ_NODE_TYPE_MASK  ((1u << NUJ_NODE_TYPE_BITS) - 1)
+#define NUJ_NODE_HAS_NAME   (1u << NUJ_NODE_TYPE_BITS)
+#define NUJ_NODE_NAME_SHIFT (NUJ_NODE_TYPE_BITS + 1)
+
+// NOTE: Compact and relocatable copy of an element tree, it is a single
+// push: this header, the nodes, the parents if there are any, then
+// the null terminated names and strings.  Node 0 is the root.
+struct NUJDocument
+{
+    unsigned int node_count;
+    unsigned int flags;
+    unsigned int string_size;
+    unsigned int reserved;
+};
+
+#define NUJ_SNAPSHOT_MAGIC      0x534A554EU
+#define NUJ_SNAPSHOT_VERSION    1
+#define NUJ_SNAPSHOT_BYTE_ORDER 0x01020304U
+
+// NOTE: Header of a snapshot file, the document follows it.  The
+// header is 32 bytes so the document stays 8 byte aligned in a
+// mapping.  byte_order is written in native order and tells a file
+// from a machine with another endianness apart.
+struct NUJSnapshot
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned int header_size;
+    unsigned long long document_size;
+    unsigned long long reserved;
+};
+
+// NOTE: A tape is the header, word_count 64 bit words, then the
+// strings.  Every word has a tag char in its top byte:
+//   '{' '[' low 32 bits are the index of the matching close word, the
+//           next 24 bits the child count, saturated
+//   '}' ']' index of the matching open word
+//   'k' '"' key or string, offset of a 32 bit length followed by the
+//           null terminated string in the strings
+//   'l' 'd' integer or double, its bits are the next word
+//   't' 'f' 'n'
+// Entries are the words that start a child, keys in objects and
+// values in arrays.  Entry 0 is the root.
+struct NUJTape
+{
+    unsigned long long word_count;
+    unsigned long long string_size;
+};
+
+#define NUJ_TAPE_TAG(word)        ((unsigned char)((word) >> 56))
+#define NUJ_TAPE_PAYLOAD(word)    ((word) & 0x00FFFFFFFFFFFFFFULL)
+#define NUJ_TAPE_WORD(tag, value) (((unsigned long long)(tag) << 56) | (value))
+#define NUJ_TAPE_MAX_CHILD_COUNT  0xFFFFFFu
+
+// NOTE: A tape being parsed.  It is the last push of the handle, with
+// room for max_word_count words and then max_string_size bytes of
+// strings, and tape->word_count is max_word_count until
+// nuj_parse_tape moves the strings down to the words.
+struct NUJTapeWriter
+{
+    NUJHandle handle;
+    NUJTape* tape;
+    unsigned long long word_count;
+    unsigned long long string_size;
+    unsigned long long max_word_count;
+    unsigned long long max_string_size;
+};
+
+// NOTE: Classification of one 64 byte block, one bit per byte.
+typedef struct NUJIndexMasks
+{
+    unsigned long long quote;
+    unsigned long long backslash;
+    unsigned long long op;
+    unsigned long long whitespace;
+} NUJIndexMasks;
+
+// NOTE: Structural index of the input.  Blocks are indexed on demand,
+// so structurals only holds the not yet consumed structural chars of
+// the current block.  Structural chars are the operators, both quotes
+// of every string and the first char of every scalar (numbers, true,
+// false, null) outside of strings.
+typedef struct NUJIndex
+{
+    NUJIndexClassifyFunc* classify;
+    unsigned long long structurals;
+    unsigned long long block_offset;
+    unsigned long long next_offset;
+    unsigned long long size;
+    unsigned long long in_string;
+    unsigned long long escaped;
+    unsigned long long scalar;
+} NUJIndex;
+
+typedef struct NUJPathSegment
+{
+    const char* name;
+    unsigned int length;
+    unsigned int hash;
+    unsigned int index;
+    int is_index;
+} NUJPathSegment;
+
+typedef struct NUJPath
+{
+    unsigned int segment_count;
+    NUJPathSegment segments[];
+} NUJPath;
+
+typedef enum NUJPushState
+{
+    NUJ_PUSH_ROOT_STATE,
+    NUJ_PUSH_VALUE_STATE,
+    NUJ_PUSH_VALUE_OR_CLOSE_STATE,
+    NUJ_PUSH_KEY_STATE,
+    NUJ_PUSH_KEY_OR_CLOSE_STATE,
+    NUJ_PUSH_COLON_STATE,
+    NUJ_PUSH_COMMA_OR_CLOSE_STATE,
+    NUJ_PUSH_STRING_STATE,
+    NUJ_PUSH_NUMBER_STATE,
+    NUJ_PUSH_LITERAL_STATE,
+    NUJ_PUSH_DONE_STATE,
+    NUJ_PUSH_ERROR_STATE,
+} NUJPushState;
+
+typedef struct NUJPushFrame
+{
+    struct NUJElement* element;
+    struct NUJElement* last_element;
+    unsigned int element_count;
+} NUJPushFrame;
+
+// NOTE: Strings are copied to the handle as they arrive, so only
+// numbers and literals have to be buffered across chunks.
+typedef struct NUJPushParser
+{
+    NUJHandle handle;
+    unsigned int flags;
+    unsigned int state;
+    unsigned int depth;
+    struct NUJElement* root;
+    const char* name;
+    unsigned int name_length;
+    struct NUJElement* string_element;
+    char* string;
+    unsigned int string_length;
+    int in_key;
+    int escaped;
+    const char* literal;
+    unsigned int literal_index;
+    unsigned int number_length;
+    char number[NUJ_PUSH_MAX_NUMBER_LENGTH + 1];
+    NUJPushFrame frames[NUJ_PUSH_MAX_DEPTH];
+} NUJPushParser;
+
+// NOTE: Each worker of nuj_parse_lines owns a range of whole lines and
+// a handle.  It first counts the records in its range, then parses
+// them to roots starting at root_offset.
+typedef struct NUJLinesWorker
+{
+    NUJHandle handle;
+    const unsigned char* start;
+    const unsigned char* end;
+    const unsigned char* parsed_end;
+    unsigned int flags;
+    struct NUJElement** roots;
+    unsigned long long root_offset;
+    unsigned long long root_count;
+    unsigned long long record_count;
+} NUJLinesWorker;
+
+// NOTE: Each worker of nuj_parse_parallel moves its start forward to a
+// split point, then parses the children of the root between it and the
+// next worker's split.  Like in nuj__parse_element_array, the children
+// are linked backwards through their parent fields.
+typedef struct NUJSliceWorker
+{
+    NUJHandle handle;
+    const unsigned char* begin;
+    const unsigned char* start;
+    const unsigned char* end;
+    const unsigned char* scan_end;
+    unsigned int flags;
+    int in_object;
+    int failed;
+    struct NUJElement* last_element;
+    unsigned int element_count;
+} NUJSliceWorker;
+
+typedef struct NUJThread
+{
+    NUJWorkerFunc* func;
+    void* worker;
+} NUJThread;
+
+// NOTE: Output goes to buffer, which is flushed to write when it
+// fills up.  Without write, output that doesn't fit is dropped but
+// still counted in total_size.
+typedef struct NUJWriter
+{
+    char* buffer;
+    unsigned long long buffer_used;
+    unsigned long long buffer_size;
+    unsigned long long total_size;
+    NUJWriteFunc* write;
+    void* user_data;
+    unsigned int flags;
+    int failed;
+} NUJWriter;
+
+// NOTE: Unsigned integer of 32 bit words, least significant first, for
+// the exact compares of nuj__compare_midpoint.
+typedef struct NUJBig
+{
+    unsigned int words[NUJ_BIG_WORD_COUNT];
+    unsigned int count;
+} NUJBig;
+
 typedef struct NUJParser
 {
     const unsigned char* initial;
     const unsigned char* current;
+    const unsigned char* end;
+    unsigned int flags;
+    int failed;
+    NUJIndex index;
+
+#ifdef NUJ_STATS
+    NUJStats* stats;
+    unsigned long long depth;
+#endif
 } NUJParser;
 
 typedef enum NUJTokenType
@@ -181,1083 +957,6765 @@ typedef struct NUJToken
     unsigned int type;
 } NUJToken;
 
-static void* nuj__push_size(NUJHandle handle, unsigned int size)
+#ifdef NUJ_STATS
+static inline unsigned long long nuj__read_cycles(void)
 {
-    void* result = 0;
-
-    NUJ_ASSERT(handle->buffer_used + size < handle->buffer_size);
-    result = handle->buffer + handle->buffer_used;
-    handle->buffer_used += size;
+    unsigned long long result = 0;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    result = __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned int low = 0;
+    unsigned int high = 0;
+
+    __asm__ volatile ("rdtsc" : "=a"(low), "=d"(high));
+    result = ((unsigned long long)high << 32) | low;
+#elif defined(__aarch64__)
+    __asm__ volatile ("mrs %0, cntvct_el0" : "=r"(result));
+#endif
 
     return result;
 }
+#endif
 
-static unsigned int nuj__get_element_size(const NUJElement* element)
+// NOTE: Returns 0 if the block would go over max_size or alloc fails.
+// The current block is kept then, so smaller pushes can still fit.
+static int nuj__push_block(NUJHandle handle, unsigned int size)
 {
-    unsigned int size = 0;
+    NUJBlock* block = 0;
+    unsigned long long block_size = handle->last_block_size * 2;
 
-    switch (element->type)
+    if (block_size < sizeof(NUJBlock) + size + 1)
     {
-        case NUJString_TYPE:
-        {
-            size = sizeof(NUJString) + (unsigned int)strlen(NUJ_CSTRING(element)->value) + 1;
-        }
-        break;
-        case NUJInteger_TYPE:
-        {
-            size = sizeof(NUJInteger);
-        }
-        break;
-        case NUJDouble_TYPE:
-        {
-            size = sizeof(NUJDouble);
-        }
-        break;
-        case NUJBoolean_TYPE:
-        {
-            size = sizeof(NUJBoolean);
-        }
-        break;
-        case NUJNull_TYPE:
-        {
-            size = sizeof(NUJNull);
-        }
-        break;
-        case NUJArray_TYPE:
-        {
-            size = sizeof(NUJArray);
-        }
-        break;
-        case NUJObject_TYPE:
-        {
-            size = sizeof(NUJObject);
-        }
-        break;
+        block_size = sizeof(NUJBlock) + size + 1;
     }
 
-    if (element->name)
+    if (handle->max_size && handle->total_size + block_size > handle->max_size)
     {
-        // NOTE: Skip len bytes + null terminator
-        size += (unsigned int)strlen(element->name) + 1;
+        block_size = handle->max_size - handle->total_size;
     }
 
-    return size;
+    if (block_size >= sizeof(NUJBlock) + size + 1)
+    {
+        block = (NUJBlock*)handle->alloc(handle->user_data, block_size);
+    }
+
+    if (block)
+    {
+        block->size = block_size;
+        block->next = handle->blocks;
+        handle->blocks = block;
+        handle->last_block_size = block_size;
+        handle->total_size += block_size;
+
+        handle->used_before += handle->buffer_used;
+        handle->buffer = (unsigned char*)(block + 1);
+        handle->buffer_used = 0;
+        handle->buffer_size = block_size - sizeof(NUJBlock);
+    }
+
+    return block != 0;
 }
 
-static unsigned long long nuj__get_total_element_object_size(const NUJElement* element)
+// NOTE: Returns 0 if the handle is full, see nuj_init_chained.  A push
+// of 0 bytes never fails.
+static void* nuj__push_size(NUJHandle handle, unsigned int size)
 {
-    unsigned int i = 0;
-    unsigned long long size = 0;
+    void* result = 0;
 
-    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+    if (handle->buffer_used + size < handle->buffer_size ||
+        (handle->alloc && nuj__push_block(handle, size)))
+    {
+        result = handle->buffer + handle->buffer_used;
+        handle->buffer_used += size;
+        NUJ_STATS_MAX(&handle->stats, max_used_size, handle->used_before + handle->buffer_used);
+    }
+
+    return result;
+}
+
+// NOTE: memory must be the last push of the handle.  It grows in
+// place if the current block has room, otherwise it is copied to a
+// new push and the old bytes are left unused.  Returns 0 if the handle
+// is full, memory is left as it was.
+static void* nuj__grow_size(NUJHandle handle, void* memory, unsigned int size, unsigned int extra_size)
+{
+    void* result = memory;
 
-    size += nuj__get_element_size(element);
-    size += (sizeof(NUJElement*) * NUJ_COBJECT(element)->child_count);
+    NUJ_ASSERT((unsigned char*)memory + size == handle->buffer + handle->buffer_used);
 
-    for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
+    if (handle->buffer_used + extra_size < handle->buffer_size)
     {
-        const NUJElement* e = NUJ_COBJECT(element)->children[i];
+        handle->buffer_used += extra_size;
+        NUJ_STATS_MAX(&handle->stats, max_used_size, handle->used_before + handle->buffer_used);
+    }
+    else
+    {
+        result = nuj__push_size(handle, size + extra_size);
 
-        if (e->type == NUJObject_TYPE || e->type == NUJArray_TYPE)
-        {
-            size += nuj__get_total_element_object_size(e);
-        }
-        else
+        if (result)
         {
-            size += nuj__get_element_size(e);
+            memcpy(result, memory, size);
         }
     }
 
-    return size;
+    return result;
 }
 
-static void nuj__print_newline_and_spaces(unsigned int space_count)
+// NOTE: Every block in a list is at least as large as the smallest
+// size of the list.  Freed blocks go to the list below their size and
+// allocations take from the list above theirs, so small elements of
+// one type reuse each other's blocks exactly.
+static inline unsigned int nuj__get_free_list(unsigned int size, int round_up)
 {
-    unsigned int i = 0;
-
-    printf("\n");
+    unsigned int list = 0;
 
-    for (i = 0; i < space_count; ++i)
+    if (size < NUJ_FREE_LIST_SMALL_SIZE)
     {
-        printf(" ");
+        list = round_up ? (size + 7) / 8 : size / 8;
     }
-}
-
-static void nuj__print_primitive_element(const NUJElement* element)
-{
-    switch (element->type)
+    else
     {
-        case NUJString_TYPE:
+        unsigned int power = 8;
+
+        while (power < 31 && (2u << power) <= size)
         {
-            printf("\"%s\"", NUJ_CSTRING(element)->value);
+            ++power;
         }
-        break;
-        case NUJInteger_TYPE:
+
+        if (round_up && (1u << power) < size)
         {
-            printf("%lld", NUJ_CINTEGER(element)->value);
+            ++power;
         }
-        break;
-        case NUJDouble_TYPE:
+
+        list = NUJ_FREE_LIST_SMALL_SIZE / 8 + power - 8;
+    }
+
+    return list;
+}
+
+// NOTE: Returns a freed block of at least size bytes, or 0.  The list
+// above size always fits, the first block of the list below it fits
+// if it was freed with the same size.  The free count keeps this to
+// one branch until something is freed.
+static void* nuj__take_free_block(NUJHandle handle, unsigned int size)
+{
+    NUJFreeBlock* block = 0;
+
+    if (handle->free_count && size >= sizeof(NUJFreeBlock))
+    {
+        unsigned int list = nuj__get_free_list(size, 1);
+        unsigned int below = nuj__get_free_list(size, 0);
+
+        if (list < NUJ_FREE_LIST_COUNT && handle->free_lists[list])
         {
-            // TODO: Parametrize .16f?
-            printf("%.16lf", NUJ_CDOUBLE(element)->value);
+            block = handle->free_lists[list];
         }
-        break;
-        case NUJBoolean_TYPE:
+        else if (handle->free_lists[below] && handle->free_lists[below]->size >= size)
         {
-            printf("%s", NUJ_CBOOLEAN(element)->value ? "true" : "false");
+            list = below;
+            block = handle->free_lists[list];
         }
-        break;
-        case NUJNull_TYPE:
+
+        if (block)
         {
-            printf("null");
+            handle->free_lists[list] = block->next;
+            --handle->free_count;
         }
-        break;
     }
 
-    if (!nuj_is_last_object_element(element))
-    {
-        printf(",");
-    }
+    return block;
 }
 
-static void nuj__printf(const NUJElement* element, unsigned int depth)
+// NOTE: Like nuj__push_size, but takes a freed block if there is one.
+static void* nuj__alloc_size(NUJHandle handle, unsigned int size)
 {
-    if (!element)
-        return;
+    void* result = nuj__take_free_block(handle, size);
 
-    if (element->parent && (element->parent->type == NUJObject_TYPE || element->parent->type == NUJArray_TYPE))
+    return result ? result : nuj__push_size(handle, size);
+}
+
+// NOTE: The rest of a block reused for a smaller size stays unused.
+static void nuj__free_size(NUJHandle handle, void* memory, unsigned int size)
+{
+    if (size >= sizeof(NUJFreeBlock))
     {
-        nuj__print_newline_and_spaces(depth * 3);
+        NUJFreeBlock* block = (NUJFreeBlock*)memory;
+        unsigned int list = nuj__get_free_list(size, 0);
+
+        block->next = handle->free_lists[list];
+        block->size = size;
+        handle->free_lists[list] = block;
+        ++handle->free_count;
     }
+}
 
-    if (element->name)
+// NOTE: FNV-1a
+static inline unsigned int nuj__hash_name(const char* name, unsigned int length)
+{
+    unsigned int hash = 2166136261u;
+    unsigned int i = 0;
+
+    for (i = 0; i < length; ++i)
     {
-        printf("\"%s\": ", element->name);
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
     }
 
-    if (element->type == NUJObject_TYPE)
+    return hash;
+}
+
+static unsigned long long nuj__get_key_index_size(unsigned int child_count)
+{
+    unsigned long long capacity = 1;
+
+    while (capacity < 2 * (unsigned long long)child_count)
     {
-        printf("{");
+        capacity *= 2;
     }
-    else if (element->type == NUJArray_TYPE)
+
+    return sizeof(NUJKeyIndex) + capacity * sizeof(NUJKeyIndexEntry);
+}
+
+// NOTE: Without room in the handle the object has no index and is
+// searched linearly.
+static void nuj__create_key_index(NUJHandle handle, NUJElement* element)
+{
+    NUJ_STATS_BEGIN(start_cycles)
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+    unsigned long long size = nuj__get_key_index_size(nuj_object->child_count);
+    NUJKeyIndex* index = (NUJKeyIndex*)nuj__alloc_size(handle, (unsigned int)size);
+    unsigned int i = 0;
+
+    if (!index)
     {
-        printf("[");
+        return;
     }
-    else
+
+    memset(index, 0, size);
+    index->mask = (unsigned int)((size - sizeof(NUJKeyIndex)) / sizeof(NUJKeyIndexEntry)) - 1;
+
+    // NOTE: With linear probing the first of duplicated names stays
+    // first in the probe sequence, so lookups find the same child as
+    // a linear search does.
+    for (i = 0; i < nuj_object->child_count; ++i)
+    {
+        NUJElement* child = nuj_object->children[i];
+
+        if (child->name)
+        {
+            unsigned int length = child->name_length;
+            unsigned int hash = nuj__hash_name(child->name, length);
+            unsigned int slot = hash & index->mask;
+
+            while (index->entries[slot].element)
+            {
+                slot = (slot + 1) & index->mask;
+            }
+
+            index->entries[slot].hash = hash;
+            index->entries[slot].length = length;
+            index->entries[slot].element = child;
+            ++index->count;
+        }
+    }
+
+    nuj_object->index = index;
+    NUJ_STATS_END(&handle->stats, key_index_cycles, start_cycles);
+}
+
+static NUJElement* nuj__find_child(const NUJElement* element, const char* name, unsigned int length, unsigned int hash)
+{
+    const NUJObject* nuj_object = NUJ_COBJECT(element);
+    NUJElement* found = 0;
+    unsigned int i = 0;
+
+    if (nuj_object->index)
+    {
+        const NUJKeyIndex* index = nuj_object->index;
+        unsigned int slot = hash & index->mask;
+
+        while (!found && index->entries[slot].element)
+        {
+            const NUJKeyIndexEntry* entry = &index->entries[slot];
+
+            if (entry->hash == hash && entry->length == length && !memcmp(entry->element->name, name, length))
+            {
+                found = entry->element;
+            }
+
+            slot = (slot + 1) & index->mask;
+        }
+    }
+    else
+    {
+        for (i = 0; !found && i < nuj_object->child_count; ++i)
+        {
+            NUJElement* el = nuj_object->children[i];
+
+            if (el->name && el->name_length == length && !memcmp(el->name, name, length))
+            {
+                found = el;
+            }
+        }
+    }
+
+    return found;
+}
+
+static const char* nuj__intern_name(NUJInternTable* table, const char* name, unsigned int length, unsigned int hash)
+{
+    const char* interned = 0;
+    char* copy = 0;
+    unsigned int slot = hash & table->mask;
+
+    while (!interned && table->entries[slot].name)
+    {
+        const NUJInternEntry* entry = &table->entries[slot];
+
+        if (entry->hash == hash && entry->length == length && !memcmp(entry->name, name, length))
+        {
+            interned = entry->name;
+        }
+
+        slot = (slot + 1) & table->mask;
+    }
+
+    // NOTE: If the table couldn't grow one slot is kept empty, so probes
+    // still end.  Names that don't fit aren't interned.
+    if (!interned && !table->frozen && table->count < table->mask)
+    {
+        copy = (char*)nuj__push_size(table->handle, (unsigned int)sizeof(hash) + length + 1);
+    }
+
+    if (copy)
+    {
+        memcpy(copy, &hash, sizeof(hash));
+        memcpy(copy + sizeof(hash), name, length);
+        copy[sizeof(hash) + length] = '\0';
+        interned = copy + sizeof(hash);
+
+        table->entries[slot].hash = hash;
+        table->entries[slot].length = length;
+        table->entries[slot].name = interned;
+
+        if (++table->count * 2 > table->mask + 1)
+        {
+            nuj__grow_intern_table(table);
+        }
+    }
+
+    return interned;
+}
+
+// NOTE: The old entries are left unused in the handle.  Returns 0 if
+// the handle is full, the table stays as it is.
+static int nuj__grow_intern_table(NUJInternTable* table)
+{
+    unsigned int capacity = (table->mask + 1) * 2;
+    NUJInternEntry* entries = (NUJInternEntry*)nuj__push_size(table->handle, capacity * (unsigned int)sizeof(NUJInternEntry));
+    unsigned int i = 0;
+
+    if (!entries)
+    {
+        return 0;
+    }
+
+    memset(entries, 0, capacity * sizeof(NUJInternEntry));
+
+    for (i = 0; i <= table->mask; ++i)
+    {
+        if (table->entries[i].name)
+        {
+            unsigned int slot = table->entries[i].hash & (capacity - 1);
+
+            while (entries[slot].name)
+            {
+                slot = (slot + 1) & (capacity - 1);
+            }
+
+            entries[slot] = table->entries[i];
+        }
+    }
+
+    table->entries = entries;
+    table->mask = capacity - 1;
+
+    return 1;
+}
+
+// NOTE: Handles that parse on several threads can only share frozen
+// tables.
+static int nuj__can_share_intern_tables(const NUJHandle* handles, unsigned int handle_count)
+{
+    int result = 1;
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for (i = 0; result && i < handle_count; ++i)
+    {
+        const NUJInternTable* table = handles[i]->intern_table;
+
+        for (j = i + 1; result && table && !table->frozen && j < handle_count; ++j)
+        {
+            result = handles[j]->intern_table != table;
+        }
+    }
+
+    return result;
+}
+
+static void nuj__write(NUJWriter* writer, const void* data, unsigned long long size)
+{
+    writer->total_size += size;
+
+    // NOTE: buffer is 0 when only the size is computed, so even empty
+    // strings can't be copied to it.
+    if (!size)
+    {
+        return;
+    }
+
+    if (writer->buffer_used + size <= writer->buffer_size)
+    {
+        memcpy(writer->buffer + writer->buffer_used, data, size);
+        writer->buffer_used += size;
+    }
+    else if (writer->write)
+    {
+        if (!writer->failed && writer->buffer_used)
+        {
+            writer->failed = !writer->write(writer->user_data, writer->buffer, writer->buffer_used);
+        }
+
+        writer->buffer_used = 0;
+
+        if (size <= writer->buffer_size)
+        {
+            memcpy(writer->buffer, data, size);
+            writer->buffer_used = size;
+        }
+        else if (!writer->failed)
+        {
+            writer->failed = !writer->write(writer->user_data, data, size);
+        }
+    }
+    else if (writer->buffer_used < writer->buffer_size)
+    {
+        memcpy(writer->buffer + writer->buffer_used, data, writer->buffer_size - writer->buffer_used);
+        writer->buffer_used = writer->buffer_size;
+    }
+}
+
+static void nuj__write_string(NUJWriter* writer, const char* string, unsigned int length)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    const char* run = string;
+    const char* end = string + length;
+    const char* current = string;
+
+    nuj__write(writer, "\"", 1);
+
+    if (writer->flags & NUJ_WRITE_ESCAPE)
+    {
+        for (current = string; current < end; ++current)
+        {
+            unsigned char character = (unsigned char)*current;
+
+            if (character < 0x20 || character == '"' || character == '\\')
+            {
+                char escaped[6] = { '\\', 0, 0, 0, 0, 0 };
+                unsigned int escaped_length = 2;
+
+                switch (character)
+                {
+                    case '"':  escaped[1] = '"';  break;
+                    case '\\': escaped[1] = '\\'; break;
+                    case '\b': escaped[1] = 'b';  break;
+                    case '\f': escaped[1] = 'f';  break;
+                    case '\n': escaped[1] = 'n';  break;
+                    case '\r': escaped[1] = 'r';  break;
+                    case '\t': escaped[1] = 't';  break;
+                    default:
+                    {
+                        escaped[1] = 'u';
+                        escaped[2] = '0';
+                        escaped[3] = '0';
+                        escaped[4] = hex_digits[character >> 4];
+                        escaped[5] = hex_digits[character & 0xF];
+                        escaped_length = 6;
+                    }
+                    break;
+                }
+
+                nuj__write(writer, run, (unsigned long long)(current - run));
+                nuj__write(writer, escaped, escaped_length);
+                run = current + 1;
+            }
+        }
+    }
+
+    nuj__write(writer, run, (unsigned long long)(end - run));
+    nuj__write(writer, "\"", 1);
+}
+
+static void nuj__write_integer(NUJWriter* writer, long long value)
+{
+    static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char digits[24];
+    char* current = digits + sizeof(digits);
+    unsigned long long number = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    while (number >= 100)
+    {
+        unsigned int pair = (unsigned int)(number % 100) * 2;
+
+        number /= 100;
+        *--current = digit_pairs[pair + 1];
+        *--current = digit_pairs[pair];
+    }
+
+    if (number >= 10)
+    {
+        *--current = digit_pairs[number * 2 + 1];
+        *--current = digit_pairs[number * 2];
+    }
+    else
+    {
+        *--current = (char)('0' + number);
+    }
+
+    if (value < 0)
+    {
+        *--current = '-';
+    }
+
+    nuj__write(writer, current, (unsigned long long)(digits + sizeof(digits) - current));
+}
+
+// NOTE: 10^q for q from NUJ_MIN_POWER_OF_10 to NUJ_MAX_POWER_OF_10,
+// as the 128 bits from its leading one rounded down, high word first.
+// Shared by nuj__parse_eisel_lemire and the shortest double writer.
+static const unsigned long long nuj__powers_of_10[] =
+{
+    0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL, 0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL,
+    0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL, 0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL,
+    0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL, 0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL,
+    0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL, 0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL,
+    0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL, 0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL,
+    0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL, 0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL,
+    0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL, 0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL,
+    0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL, 0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL,
+    0x84A57695FE98746DULL, 0x014BB630F7604B57ULL, 0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL,
+    0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL, 0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL,
+    0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL, 0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL,
+    0xFD00B897478238D0ULL, 0x8920B098955522B4ULL, 0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL,
+    0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL, 0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL,
+    0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL, 0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL,
+    0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL, 0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL,
+    0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL, 0xEBA09271E88D976BULL, 0xF7864A44C633682EULL,
+    0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL, 0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL,
+    0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL, 0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL,
+    0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL, 0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL,
+    0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL, 0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL,
+    0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL, 0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL,
+    0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL, 0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL,
+    0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL, 0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL,
+    0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL, 0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL,
+    0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL, 0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL,
+    0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL, 0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL,
+    0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL, 0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL,
+    0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL, 0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL,
+    0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL, 0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL,
+    0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL, 0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL,
+    0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL, 0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL,
+    0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL, 0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL,
+    0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL, 0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL,
+    0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL, 0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL,
+    0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL, 0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL,
+    0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL, 0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL,
+    0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL, 0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL,
+    0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL, 0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL,
+    0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL, 0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL,
+    0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL, 0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL,
+    0xC987434744AC874EULL, 0xA327FFB266B56220ULL, 0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL,
+    0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL, 0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL,
+    0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL, 0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL,
+    0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL, 0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL,
+    0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL, 0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL,
+    0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL, 0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL,
+    0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL, 0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL,
+    0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL, 0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL,
+    0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL, 0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL,
+    0xAECC49914078536DULL, 0x58FAE9F773886E18ULL, 0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL,
+    0x888F99797A5E012DULL, 0x6D8406C952429603ULL, 0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL,
+    0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL, 0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL,
+    0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL, 0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL,
+    0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL, 0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL,
+    0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL, 0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL,
+    0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL, 0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL,
+    0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL, 0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL,
+    0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL, 0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL,
+    0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL, 0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL,
+    0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL, 0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL,
+    0xB913179899F68584ULL, 0x28E2557B59846E3FULL, 0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL,
+    0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL, 0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL,
+    0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL, 0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL,
+    0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL, 0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL,
+    0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL, 0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL,
+    0xD77485CB25823AC7ULL, 0x7D633293366B828BULL, 0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL,
+    0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL, 0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL,
+    0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL, 0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL,
+    0xCD795BE870516656ULL, 0x67902E276C921F8BULL, 0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL,
+    0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL, 0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL,
+    0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL, 0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL,
+    0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL, 0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL,
+    0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL, 0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL,
+    0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL, 0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL,
+    0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL, 0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL,
+    0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL, 0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL,
+    0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL, 0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL,
+    0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL, 0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL,
+    0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL, 0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL,
+    0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL, 0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL,
+    0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL, 0xD47487CC8470652BULL, 0x7647C3200069671FULL,
+    0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL, 0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL,
+    0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL, 0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL,
+    0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL, 0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL,
+    0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL, 0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL,
+    0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL, 0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL,
+    0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL, 0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL,
+    0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL, 0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL,
+    0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL, 0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL,
+    0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL, 0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL,
+    0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL, 0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL,
+    0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL, 0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL,
+    0x8C974F7383725573ULL, 0x1E414218C73A13FBULL, 0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL,
+    0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL, 0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL,
+    0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL, 0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL,
+    0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL, 0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL,
+    0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL, 0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL,
+    0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL, 0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL,
+    0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL, 0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL,
+    0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL, 0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL,
+    0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL, 0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL,
+    0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL, 0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL,
+    0xBE89523386091465ULL, 0xF6BBB397F1135823ULL, 0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL,
+    0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL, 0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL,
+    0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL, 0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL,
+    0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL, 0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL,
+    0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL, 0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL,
+    0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL, 0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL,
+    0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL, 0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL,
+    0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL, 0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL,
+    0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL, 0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL,
+    0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL, 0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL,
+    0x811CCC668829B887ULL, 0x0806357D5A3F525FULL, 0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL,
+    0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL, 0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL,
+    0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL, 0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL,
+    0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL, 0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL,
+    0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL, 0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL,
+    0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL, 0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL,
+    0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL, 0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL,
+    0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL, 0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL,
+    0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL, 0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL,
+    0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL, 0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL,
+    0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL, 0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL,
+    0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL, 0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL,
+    0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL, 0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL,
+    0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL, 0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL,
+    0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL, 0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL,
+    0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL, 0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL,
+    0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL, 0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL,
+    0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL, 0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL,
+    0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL, 0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL,
+    0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL, 0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL,
+    0xED246723473E3813ULL, 0x290123E9AAB23B68ULL, 0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL,
+    0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL, 0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL,
+    0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL, 0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL,
+    0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL, 0x8D590723948A535FULL, 0x579C487E5A38AD0EULL,
+    0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL, 0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL,
+    0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL, 0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL,
+    0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL, 0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL,
+    0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL, 0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL,
+    0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL, 0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL,
+    0xCDB02555653131B6ULL, 0x3792F412CB06794DULL, 0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL,
+    0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL, 0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL,
+    0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL, 0x9CED737BB6C4183DULL, 0x55464DD69685606BULL,
+    0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL, 0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL,
+    0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL, 0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL,
+    0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL, 0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL,
+    0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL, 0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL,
+    0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL, 0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL,
+    0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL, 0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL,
+    0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL, 0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL,
+    0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL, 0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL,
+    0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL, 0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL,
+    0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL, 0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL,
+    0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL, 0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL,
+    0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL, 0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL,
+    0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL, 0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL,
+    0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL, 0x9E74D1B791E07E48ULL, 0x775EA264CF55347DULL,
+    0xC612062576589DDAULL, 0x95364AFE032A819DULL, 0xF79687AED3EEC551ULL, 0x3A83DDBD83F52204ULL,
+    0x9ABE14CD44753B52ULL, 0xC4926A9672793542ULL, 0xC16D9A0095928A27ULL, 0x75B7053C0F178293ULL,
+    0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6338ULL, 0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E03ULL,
+    0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF584ULL, 0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E5ULL,
+    0x9392EE8E921D5D07ULL, 0x3AFF322E62439FCFULL, 0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C2ULL,
+    0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B3ULL, 0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A10ULL,
+    0xB424DC35095CD80FULL, 0x538484C19EF38C94ULL, 0xE12E13424BB40E13ULL, 0x2865A5F206B06FB9ULL,
+    0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D3ULL, 0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D748ULL,
+    0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1BULL, 0x89705F4136B4A597ULL, 0x31680A88F8953030ULL,
+    0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3DULL, 0xD6BF94D5E57A42BCULL, 0x3D32907604691B4CULL,
+    0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B10FULL, 0xA7C5AC471B478423ULL, 0x0FCF80DC33721D53ULL,
+    0xD1B71758E219652BULL, 0xD3C36113404EA4A8ULL, 0x83126E978D4FDF3BULL, 0x645A1CAC083126E9ULL,
+    0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A3ULL, 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCCULL,
+    0x8000000000000000ULL, 0x0000000000000000ULL, 0xA000000000000000ULL, 0x0000000000000000ULL,
+    0xC800000000000000ULL, 0x0000000000000000ULL, 0xFA00000000000000ULL, 0x0000000000000000ULL,
+    0x9C40000000000000ULL, 0x0000000000000000ULL, 0xC350000000000000ULL, 0x0000000000000000ULL,
+    0xF424000000000000ULL, 0x0000000000000000ULL, 0x9896800000000000ULL, 0x0000000000000000ULL,
+    0xBEBC200000000000ULL, 0x0000000000000000ULL, 0xEE6B280000000000ULL, 0x0000000000000000ULL,
+    0x9502F90000000000ULL, 0x0000000000000000ULL, 0xBA43B74000000000ULL, 0x0000000000000000ULL,
+    0xE8D4A51000000000ULL, 0x0000000000000000ULL, 0x9184E72A00000000ULL, 0x0000000000000000ULL,
+    0xB5E620F480000000ULL, 0x0000000000000000ULL, 0xE35FA931A0000000ULL, 0x0000000000000000ULL,
+    0x8E1BC9BF04000000ULL, 0x0000000000000000ULL, 0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL,
+    0xDE0B6B3A76400000ULL, 0x0000000000000000ULL, 0x8AC7230489E80000ULL, 0x0000000000000000ULL,
+    0xAD78EBC5AC620000ULL, 0x0000000000000000ULL, 0xD8D726B7177A8000ULL, 0x0000000000000000ULL,
+    0x878678326EAC9000ULL, 0x0000000000000000ULL, 0xA968163F0A57B400ULL, 0x0000000000000000ULL,
+    0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL, 0x84595161401484A0ULL, 0x0000000000000000ULL,
+    0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL, 0xCECB8F27F4200F3AULL, 0x0000000000000000ULL,
+    0x813F3978F8940984ULL, 0x4000000000000000ULL, 0xA18F07D736B90BE5ULL, 0x5000000000000000ULL,
+    0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL, 0xFC6F7C4045812296ULL, 0x4D00000000000000ULL,
+    0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL, 0xC5371912364CE305ULL, 0x6C28000000000000ULL,
+    0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL, 0x9A130B963A6C115CULL, 0x3C7F400000000000ULL,
+    0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL, 0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL,
+    0x96769950B50D88F4ULL, 0x1314448000000000ULL, 0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL,
+    0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL, 0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL,
+    0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL, 0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL,
+    0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL, 0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL,
+    0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL, 0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL,
+    0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL, 0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL,
+    0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL, 0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL,
+    0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL, 0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL,
+    0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL, 0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL,
+    0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL, 0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL,
+    0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL, 0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL,
+    0x9F4F2726179A2245ULL, 0x01D762422C946590ULL, 0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL,
+    0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL, 0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL,
+    0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL, 0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL,
+    0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL, 0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL,
+    0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL, 0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL,
+    0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL, 0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL,
+    0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL, 0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL,
+    0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL, 0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL,
+    0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL, 0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL,
+    0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL, 0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL,
+    0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL, 0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL,
+    0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL, 0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL,
+    0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL, 0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL,
+    0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL, 0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL,
+    0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL, 0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL,
+    0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL, 0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL,
+    0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL, 0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL,
+    0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL, 0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL,
+    0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL, 0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL,
+    0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL, 0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL,
+    0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL, 0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL,
+    0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL, 0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL,
+    0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL, 0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL,
+    0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL, 0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL,
+    0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL, 0x884134FE908658B2ULL, 0x3109058D147FDCDDULL,
+    0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL, 0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL,
+    0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL, 0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL,
+    0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL, 0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL,
+    0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL, 0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL,
+    0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL, 0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL,
+    0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL, 0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL,
+    0x9AE757596946075FULL, 0x3375788DE9B06958ULL, 0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL,
+    0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL, 0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL,
+    0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL, 0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL,
+    0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL, 0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL,
+    0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL, 0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL,
+    0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL, 0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL,
+    0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL, 0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL,
+    0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL, 0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL,
+    0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL, 0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL,
+    0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL, 0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL,
+    0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL, 0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL,
+    0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL, 0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL,
+    0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL, 0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL,
+    0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL, 0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL,
+    0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL, 0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL,
+    0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL, 0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL,
+    0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL, 0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL,
+    0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL, 0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL,
+    0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL, 0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL,
+    0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL, 0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL,
+    0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL, 0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL,
+    0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL, 0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL,
+    0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL, 0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL,
+    0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL, 0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL,
+    0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL, 0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL,
+    0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL, 0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL,
+    0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL, 0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL,
+    0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL, 0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL,
+    0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL, 0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL,
+    0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL, 0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL,
+    0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL, 0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL,
+    0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL, 0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL,
+    0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL, 0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL,
+    0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL, 0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL,
+    0x8FA475791A569D10ULL, 0xF96E017D694487BCULL, 0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL,
+    0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL, 0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL,
+    0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL, 0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL,
+    0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL, 0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL,
+    0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL, 0x85C7056562757456ULL, 0xF6872D5667844E49ULL,
+    0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL, 0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL,
+    0x82A45B450226B39CULL, 0xECC0024661173473ULL, 0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL,
+    0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL, 0xFF290242C83396CEULL, 0x7E67047175A15271ULL,
+    0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL, 0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL,
+    0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL, 0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL,
+    0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL, 0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL,
+    0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL, 0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL,
+    0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL, 0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL,
+    0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL, 0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL,
+    0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL, 0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL,
+    0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL, 0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL,
+    0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL, 0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL,
+    0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL, 0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL,
+    0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL, 0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL,
+    0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL, 0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL,
+    0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL, 0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL,
+    0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL, 0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL,
+    0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL, 0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL,
+    0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL, 0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL,
+    0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL, 0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL,
+    0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL, 0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL,
+    0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL, 0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL,
+    0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL, 0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL,
+    0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL, 0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL,
+    0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL, 0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL,
+    0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL, 0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL,
+    0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL, 0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL,
+    0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL, 0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL,
+    0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL, 0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL,
+    0x8533285C936B35DEULL, 0xD53A88958F87275FULL, 0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL,
+    0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL, 0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL,
+    0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL, 0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL,
+    0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL, 0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL,
+    0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL, 0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL,
+    0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL, 0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL,
+    0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL, 0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL,
+    0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL, 0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL,
+    0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL, 0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL,
+    0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL, 0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL,
+    0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL, 0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL,
+    0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL, 0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL,
+    0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL, 0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL,
+    0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL, 0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL,
+    0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL, 0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL,
+    0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL, 0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL,
+    0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL, 0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL,
+    0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL, 0xA0555E361951C366ULL, 0xD7E105BCC332621FULL,
+    0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL, 0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL,
+    0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL, 0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL,
+    0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL, 0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL,
+    0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL, 0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL,
+    0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL, 0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL,
+    0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL, 0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL,
+    0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL, 0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL,
+    0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL, 0xB201833B35D63F73ULL, 0x2CD2CC6551E513DAULL,
+    0xDE81E40A034BCF4FULL, 0xF8077F7EA65E58D1ULL, 0x8B112E86420F6191ULL, 0xFB04AFAF27FAF782ULL,
+    0xADD57A27D29339F6ULL, 0x79C5DB9AF1F9B563ULL, 0xD94AD8B1C7380874ULL, 0x18375281AE7822BCULL,
+    0x87CEC76F1C830548ULL, 0x8F2293910D0B15B5ULL, 0xA9C2794AE3A3C69AULL, 0xB2EB3875504DDB22ULL,
+    0xD433179D9C8CB841ULL, 0x5FA60692A46151EBULL, 0x849FEEC281D7F328ULL, 0xDBC7C41BA6BCD333ULL,
+    0xA5C7EA73224DEFF3ULL, 0x12B9B522906C0800ULL, 0xCF39E50FEAE16BEFULL, 0xD768226B34870A00ULL,
+    0x81842F29F2CCE375ULL, 0xE6A1158300D46640ULL, 0xA1E53AF46F801C53ULL, 0x60495AE3C1097FD0ULL,
+    0xCA5E89B18B602368ULL, 0x385BB19CB14BDFC4ULL, 0xFCF62C1DEE382C42ULL, 0x46729E03DD9ED7B5ULL,
+    0x9E19DB92B4E31BA9ULL, 0x6C07A2C26A8346D1ULL,
+};
+
+// NOTE: Full 128 bit product, returns the low word.
+static inline unsigned long long nuj__mul_64(unsigned long long a, unsigned long long b, unsigned long long* high)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+
+    *high = (unsigned long long)(product >> 64);
+
+    return (unsigned long long)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, high);
+#else
+    unsigned long long a_low = a & 0xFFFFFFFFULL;
+    unsigned long long a_high = a >> 32;
+    unsigned long long b_low = b & 0xFFFFFFFFULL;
+    unsigned long long b_high = b >> 32;
+    unsigned long long low = a_low * b_low;
+    unsigned long long middle = a_high * b_low + (low >> 32);
+    unsigned long long other = a_low * b_high + (middle & 0xFFFFFFFFULL);
+
+    *high = a_high * b_high + (middle >> 32) + (other >> 32);
+
+    return (other << 32) | (low & 0xFFFFFFFFULL);
+#endif
+}
+
+// NOTE: value is not 0.
+static inline unsigned int nuj__count_leading_zeros(unsigned long long value)
+{
+#if defined(_MSC_VER)
+    unsigned long result = 0;
+
+    _BitScanReverse64(&result, value);
+
+    return 63 - (unsigned int)result;
+#else
+    return (unsigned int)__builtin_clzll(value);
+#endif
+}
+
+// NOTE: floor(value / 2^shift), without shifting a negative number
+// right, which C leaves to the compiler.
+static inline long long nuj__floor_shift(long long value, unsigned int shift)
+{
+    return value >= 0 ? value >> shift : -((-value + (1LL << shift) - 1) >> shift);
+}
+
+// NOTE: big is value << shift.
+static void nuj__big_set(NUJBig* big, unsigned long long value, unsigned int shift)
+{
+    unsigned int word = shift / 32;
+    unsigned int bit = shift % 32;
+
+    NUJ_ASSERT(word + 2 < NUJ_BIG_WORD_COUNT);
+
+    memset(big->words, 0, word * sizeof(*big->words));
+    big->words[word] = (unsigned int)(value << bit);
+    big->words[word + 1] = (unsigned int)(value >> (32 - bit));
+    big->words[word + 2] = bit ? (unsigned int)(value >> (64 - bit)) : 0;
+    big->count = word + 3;
+
+    while (big->count && !big->words[big->count - 1])
+    {
+        --big->count;
+    }
+}
+
+static void nuj__big_mul(NUJBig* big, unsigned int factor)
+{
+    nuj__big_mul_add(big, factor, 0);
+}
+
+static void nuj__big_mul_add(NUJBig* big, unsigned int factor, unsigned int addend)
+{
+    unsigned long long carry = addend;
+    unsigned int i = 0;
+
+    for (i = 0; i < big->count; ++i)
+    {
+        carry += (unsigned long long)big->words[i] * factor;
+        big->words[i] = (unsigned int)carry;
+        carry >>= 32;
+    }
+
+    if (carry)
+    {
+        NUJ_ASSERT(big->count < NUJ_BIG_WORD_COUNT);
+        big->words[big->count++] = (unsigned int)carry;
+    }
+}
+
+static void nuj__big_mul_pow10(NUJBig* big, unsigned int power)
+{
+    static const unsigned int powers_of_10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+    while (power >= 9)
+    {
+        nuj__big_mul(big, powers_of_10[9]);
+        power -= 9;
+    }
+
+    nuj__big_mul(big, powers_of_10[power]);
+}
+
+static void nuj__big_mul_pow5(NUJBig* big, unsigned int power)
+{
+    static const unsigned int powers_of_5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125 };
+
+    while (power >= 13)
+    {
+        nuj__big_mul(big, powers_of_5[13]);
+        power -= 13;
+    }
+
+    nuj__big_mul(big, powers_of_5[power]);
+}
+
+// NOTE: result must not be a or b.
+static void nuj__big_mul_big(NUJBig* result, const NUJBig* a, const NUJBig* b)
+{
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    NUJ_ASSERT(a->count + b->count <= NUJ_BIG_WORD_COUNT);
+
+    memset(result->words, 0, (a->count + b->count) * sizeof(*result->words));
+
+    for (i = 0; i < a->count; ++i)
+    {
+        unsigned long long carry = 0;
+
+        for (j = 0; j < b->count; ++j)
+        {
+            carry += (unsigned long long)a->words[i] * b->words[j] + result->words[i + j];
+            result->words[i + j] = (unsigned int)carry;
+            carry >>= 32;
+        }
+
+        result->words[i + b->count] = (unsigned int)carry;
+    }
+
+    result->count = a->count + b->count;
+
+    while (result->count && !result->words[result->count - 1])
+    {
+        --result->count;
+    }
+}
+
+static void nuj__big_shift(NUJBig* big, unsigned int shift)
+{
+    unsigned int word_shift = shift / 32;
+    unsigned int bit_shift = shift % 32;
+    unsigned int i = big->count;
+
+    if (big->count)
+    {
+        NUJ_ASSERT(big->count + word_shift < NUJ_BIG_WORD_COUNT);
+
+        big->words[big->count + word_shift] = 0;
+
+        while (i--)
+        {
+            unsigned int word = big->words[i];
+
+            big->words[i + word_shift + 1] |= bit_shift ? word >> (32 - bit_shift) : 0;
+            big->words[i + word_shift] = word << bit_shift;
+        }
+
+        memset(big->words, 0, word_shift * sizeof(*big->words));
+        big->count += word_shift + 1;
+
+        while (big->count && !big->words[big->count - 1])
+        {
+            --big->count;
+        }
+    }
+}
+
+static int nuj__big_compare(const NUJBig* a, const NUJBig* b)
+{
+    int result = a->count < b->count ? -1 : a->count > b->count ? 1 : 0;
+    unsigned int i = a->count;
+
+    while (!result && i--)
+    {
+        result = a->words[i] < b->words[i] ? -1 : a->words[i] > b->words[i] ? 1 : 0;
+    }
+
+    return result;
+}
+
+// NOTE: Decimal digits of a number above 0, returns how many.
+static unsigned int nuj__get_integer_digits(unsigned long long number, char* digits)
+{
+    char buffer[20];
+    unsigned int digit_count = 0;
+
+    while (number)
+    {
+        buffer[sizeof(buffer) - ++digit_count] = (char)('0' + number % 10);
+        number /= 10;
+    }
+
+    memcpy(digits, buffer + sizeof(buffer) - digit_count, digit_count);
+
+    return digit_count;
+}
+
+// NOTE: value * g / 2^127 rounded to odd, g is g_high * 2^63 + g_low
+// with both below 2^63.  The low word of g_low * value is left out,
+// as the proof of nuj__get_shortest_digits does, and what is left is
+// rounded down with its lowest bit set if anything was cut off.
+static inline unsigned long long nuj__round_to_odd(unsigned long long g_high, unsigned long long g_low, unsigned long long value)
+{
+    unsigned long long low_high = 0;
+    unsigned long long high_high = 0;
+    unsigned long long high_low = nuj__mul_64(g_high, value, &high_high);
+    unsigned long long middle = 0;
+
+    nuj__mul_64(g_low, value, &low_high);
+    middle = (high_low >> 1) + low_high;
+
+    return (high_high + (middle >> 63)) | (((middle & 0x7FFFFFFFFFFFFFFFULL) + 0x7FFFFFFFFFFFFFFFULL) >> 63);
+}
+
+// NOTE: Shortest digits that read back as value, by Giulietti's
+// Schubfach.  value is c * 2^q, the doubles next to it round to it up
+// to the midpoints (4c - 2) / 4 * 2^q and (4c + 2) / 4 * 2^q, or
+// (4c - 1) / 4 * 2^q below a power of 2.  They are scaled by 10^-k from
+// nuj__powers_of_10 so that 10^k is one digit below value, then the
+// multiple of 10 and both neighbours of the scaled value are tried
+// in that order.  The midpoints read back as value if c is even, if
+// two candidates read back the nearer wins and ties go to the even
+// one.  value is finite and positive, it is 0.digits * 10^point.
+static unsigned int nuj__get_shortest_digits(double value, char* digits, int* point)
+{
+    const unsigned long long* power = 0;
+    unsigned long long bits = 0;
+    unsigned long long c = 0;
+    unsigned long long cb = 0;
+    unsigned long long cb_left = 0;
+    unsigned long long cb_right = 0;
+    unsigned long long g_high = 0;
+    unsigned long long g_low = 0;
+    unsigned long long v = 0;
+    unsigned long long v_left = 0;
+    unsigned long long v_right = 0;
+    unsigned long long s = 0;
+    unsigned long long t = 0;
+    unsigned long long number = 0;
+    unsigned int digit_count = 0;
+    unsigned int out = 0;
+    int q = 0;
+    int k = 0;
+    int h = 0;
+    int found = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    c = bits & ((1ULL << 52) - 1);
+    q = (int)((bits >> 52) & 0x7FF);
+
+    if (q)
+    {
+        c |= 1ULL << 52;
+        q -= 1075;
+    }
+    else
+    {
+        q = -1074;
+    }
+
+    out = (unsigned int)(c & 1);
+    cb = c << 2;
+    cb_right = cb + 2;
+
+    // NOTE: floor(log10(2^q)) and floor(log10(3/4 * 2^q)), exact for
+    // every q of a double.
+    if (c != (1ULL << 52) || q == -1074)
+    {
+        cb_left = cb - 2;
+        k = (int)nuj__floor_shift(q * 661971961083LL, 41);
+    }
+    else
+    {
+        cb_left = cb - 1;
+        k = (int)nuj__floor_shift(q * 661971961083LL - 274743187321LL, 41);
+    }
+
+    // NOTE: g is the power rounded down to 126 bits plus 1, h is what
+    // is left of q after the scale of g and the 2 bits of cb.
+    power = nuj__powers_of_10 + 2 * (-k - NUJ_MIN_POWER_OF_10);
+    g_high = power[0] >> 1;
+    g_low = (((power[0] << 62) | (power[1] >> 2)) & 0x7FFFFFFFFFFFFFFFULL) + 1;
+    g_high += g_low >> 63;
+    g_low &= 0x7FFFFFFFFFFFFFFFULL;
+    h = q + (int)nuj__floor_shift(-k * 913124641741LL, 38) + 2;
+
+    v = nuj__round_to_odd(g_high, g_low, cb << h);
+    v_left = nuj__round_to_odd(g_high, g_low, cb_left << h);
+    v_right = nuj__round_to_odd(g_high, g_low, cb_right << h);
+    s = v >> 2;
+
+    if (s >= 10)
+    {
+        unsigned long long s_10 = s / 10 * 10;
+        unsigned long long t_10 = s_10 + 10;
+        int s_in = v_left + out <= s_10 << 2;
+        int t_in = (t_10 << 2) + out <= v_right;
+
+        if (s_in != t_in)
+        {
+            number = s_in ? s_10 : t_10;
+            found = 1;
+        }
+    }
+
+    if (!found)
+    {
+        int s_in = 0;
+        int t_in = 0;
+
+        t = s + 1;
+        s_in = v_left + out <= s << 2;
+        t_in = (t << 2) + out <= v_right;
+
+        if (s_in != t_in)
+        {
+            number = s_in ? s : t;
+        }
+        else
+        {
+            number = v < (s + t) << 1 || (v == (s + t) << 1 && !(s & 1)) ? s : t;
+        }
+    }
+
+    digit_count = nuj__get_integer_digits(number, digits);
+    *point = (int)digit_count + k;
+
+    while (digits[digit_count - 1] == '0')
+    {
+        --digit_count;
+    }
+
+    return digit_count;
+}
+
+// NOTE: Writes the shortest decimal that reads back as value, without
+// stdio, so the locale never changes it.  Like %.17g it has an
+// exponent if it is below 1e-4 or at least 1e17, and it always has a
+// '.' or an exponent so it is read back as a double.  JSON has no infinity
+// or NaN, they are written as null.
+static void nuj__write_double(NUJWriter* writer, double value)
+{
+    char text[40];
+    char digits[20];
+    unsigned long long bits = 0;
+    unsigned int digit_count = 0;
+    unsigned int length = 0;
+    unsigned int i = 0;
+    int point = 0;
+
+    if (value - value != 0)
+    {
+        nuj__write(writer, "null", 4);
+        return;
+    }
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    if (bits >> 63)
+    {
+        text[length++] = '-';
+        value = -value;
+    }
+
+    if (value == 0)
+    {
+        digits[digit_count++] = '0';
+        point = 1;
+    }
+    else if (value < 9007199254740992.0 && value == (double)(unsigned long long)value)
+    {
+        // NOTE: Integers below 2^53 are exact and need all their digits.
+        digit_count = nuj__get_integer_digits((unsigned long long)value, digits);
+        point = (int)digit_count;
+
+        while (digits[digit_count - 1] == '0')
+        {
+            --digit_count;
+        }
+    }
+    else
+    {
+        digit_count = nuj__get_shortest_digits(value, digits, &point);
+    }
+
+    if (point > 17 || point < -3)
+    {
+        int exponent = point - 1;
+
+        text[length++] = digits[0];
+
+        if (digit_count > 1)
+        {
+            text[length++] = '.';
+            memcpy(text + length, digits + 1, digit_count - 1);
+            length += digit_count - 1;
+        }
+
+        text[length++] = 'e';
+        text[length++] = exponent < 0 ? '-' : '+';
+        exponent = exponent < 0 ? -exponent : exponent;
+
+        if (exponent >= 100)
+        {
+            text[length++] = (char)('0' + exponent / 100);
+        }
+
+        if (exponent >= 10)
+        {
+            text[length++] = (char)('0' + exponent / 10 % 10);
+        }
+
+        text[length++] = (char)('0' + exponent % 10);
+    }
+    else if (point <= 0)
+    {
+        text[length++] = '0';
+        text[length++] = '.';
+
+        for (i = 0; i < (unsigned int)-point; ++i)
+        {
+            text[length++] = '0';
+        }
+
+        memcpy(text + length, digits, digit_count);
+        length += digit_count;
+    }
+    else
+    {
+        for (i = 0; i < (unsigned int)point; ++i)
+        {
+            text[length++] = i < digit_count ? digits[i] : '0';
+        }
+
+        text[length++] = '.';
+
+        if (digit_count > (unsigned int)point)
+        {
+            memcpy(text + length, digits + point, digit_count - (unsigned int)point);
+            length += digit_count - (unsigned int)point;
+        }
+        else
+        {
+            text[length++] = '0';
+        }
+    }
+
+    nuj__write(writer, text, length);
+}
+
+static void nuj__write_newline_and_spaces(NUJWriter* writer, unsigned int depth)
+{
+    static const char spaces[] = "\n                                                                ";
+    unsigned int space_count = depth * 3;
+
+    nuj__write(writer, spaces, 1);
+
+    while (space_count)
+    {
+        unsigned int count = space_count < sizeof(spaces) - 2 ? space_count : (unsigned int)sizeof(spaces) - 2;
+
+        nuj__write(writer, spaces + 1, count);
+        space_count -= count;
+    }
+}
+
+static void nuj__write_element(NUJWriter* writer, const NUJElement* element, unsigned int depth)
+{
+    int pretty = writer->flags & NUJ_WRITE_PRETTY;
+
+    if (element->name)
+    {
+        nuj__write_string(writer, element->name, element->name_length);
+        nuj__write(writer, pretty ? ": " : ":", pretty ? 2 : 1);
+    }
+
+    switch (element->type)
+    {
+        case NUJString_TYPE:
+        {
+            nuj__write_string(writer, NUJ_CSTRING(element)->value, NUJ_CSTRING(element)->length);
+        }
+        break;
+        case NUJInteger_TYPE:
+        {
+            nuj__write_integer(writer, NUJ_CINTEGER(element)->value);
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            nuj__write_double(writer, NUJ_CDOUBLE(element)->value);
+        }
+        break;
+        case NUJBoolean_TYPE:
+        {
+            if (NUJ_CBOOLEAN(element)->value)
+            {
+                nuj__write(writer, "true", 4);
+            }
+            else
+            {
+                nuj__write(writer, "false", 5);
+            }
+        }
+        break;
+        case NUJNull_TYPE:
+        {
+            nuj__write(writer, "null", 4);
+        }
+        break;
+        case NUJObject_TYPE:
+        case NUJArray_TYPE:
+        {
+            unsigned int i = 0;
+            unsigned int child_count = NUJ_COBJECT(element)->child_count;
+
+            nuj__write(writer, element->type == NUJObject_TYPE ? "{" : "[", 1);
+
+            for (i = 0; i < child_count; ++i)
+            {
+                if (pretty)
+                {
+                    nuj__write_newline_and_spaces(writer, depth + 1);
+                }
+
+                nuj__write_element(writer, NUJ_COBJECT(element)->children[i], depth + 1);
+
+                if (i + 1 < child_count)
+                {
+                    nuj__write(writer, ",", 1);
+                }
+            }
+
+            if (pretty && child_count)
+            {
+                nuj__write_newline_and_spaces(writer, depth);
+            }
+
+            nuj__write(writer, element->type == NUJObject_TYPE ? "}" : "]", 1);
+        }
+        break;
+    }
+}
+
+static inline int nuj__decode_hex(const char* string, unsigned int* code_point)
+{
+    unsigned int value = 0;
+    int result = 1;
+    int i = 0;
+
+    for (i = 0; result && i < 4; ++i)
+    {
+        char character = string[i];
+
+        if (character >= '0' && character <= '9')
+        {
+            value = (value << 4) | (unsigned int)(character - '0');
+        }
+        else if ((character | 0x20) >= 'a' && (character | 0x20) <= 'f')
+        {
+            value = (value << 4) | (unsigned int)((character | 0x20) - 'a' + 10);
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    *code_point = value;
+
+    return result;
+}
+
+static inline char* nuj__encode_utf8(char* buffer, unsigned int code_point)
+{
+    if (code_point < 0x80)
+    {
+        *buffer++ = (char)code_point;
+    }
+    else if (code_point < 0x800)
+    {
+        *buffer++ = (char)(0xC0 | (code_point >> 6));
+        *buffer++ = (char)(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+        *buffer++ = (char)(0xE0 | (code_point >> 12));
+        *buffer++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        *buffer++ = (char)(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+        *buffer++ = (char)(0xF0 | (code_point >> 18));
+        *buffer++ = (char)(0x80 | ((code_point >> 12) & 0x3F));
+        *buffer++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        *buffer++ = (char)(0x80 | (code_point & 0x3F));
+    }
+
+    return buffer;
+}
+
+static void nuj__print_newline_and_spaces(unsigned int space_count)
+{
+    unsigned int i = 0;
+
+    printf("\n");
+
+    for (i = 0; i < space_count; ++i)
+    {
+        printf(" ");
+    }
+}
+
+static void nuj__print_primitive_element(const NUJElement* element)
+{
+    switch (element->type)
+    {
+        case NUJString_TYPE:
+        {
+            printf("\"%.*s\"", (int)NUJ_CSTRING(element)->length, NUJ_CSTRING(element)->value);
+        }
+        break;
+        case NUJInteger_TYPE:
+        {
+            printf("%lld", NUJ_CINTEGER(element)->value);
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            // TODO: Parametrize .16f?
+            printf("%.16lf", NUJ_CDOUBLE(element)->value);
+        }
+        break;
+        case NUJBoolean_TYPE:
+        {
+            printf("%s", NUJ_CBOOLEAN(element)->value ? "true" : "false");
+        }
+        break;
+        case NUJNull_TYPE:
+        {
+            printf("null");
+        }
+        break;
+    }
+
+    if (!nuj_is_last_object_element(element))
+    {
+        printf(",");
+    }
+}
+
+static void nuj__printf(const NUJElement* element, unsigned int depth)
+{
+    if (!element)
+        return;
+
+    if (element->parent && (element->parent->type == NUJObject_TYPE || element->parent->type == NUJArray_TYPE))
+    {
+        nuj__print_newline_and_spaces(depth * 3);
+    }
+
+    if (element->name)
+    {
+        printf("\"%.*s\": ", (int)element->name_length, element->name);
+    }
+
+    if (element->type == NUJObject_TYPE)
+    {
+        printf("{");
+    }
+    else if (element->type == NUJArray_TYPE)
+    {
+        printf("[");
+    }
+    else
+    {
+        nuj__print_primitive_element(element);
+    }
+
+    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    {
+        unsigned int i = 0;
+
+        for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
+        {
+            nuj__printf(NUJ_COBJECT(element)->children[i], depth + 1);
+        }
+
+        if (!element->parent || (element->parent->type == NUJObject_TYPE || element->parent->type == NUJArray_TYPE))
+        {
+            nuj__print_newline_and_spaces(depth * 3);
+        }
+        printf("%s", element->type == NUJObject_TYPE ? "}" : element->type == NUJArray_TYPE ? "]" : 0);
+
+        if (!nuj_is_last_object_element(element))
+        {
+            printf(",");
+        }
+    }
+}
+
+static inline unsigned int nuj__index_ctz(unsigned long long value)
+{
+#if defined(_MSC_VER)
+    unsigned long result = 0;
+
+    _BitScanForward64(&result, value);
+
+    return (unsigned int)result;
+#else
+    return (unsigned int)__builtin_ctzll(value);
+#endif
+}
+
+static inline unsigned long long nuj__index_prefix_xor(unsigned long long value)
+{
+    value ^= value << 1;
+    value ^= value << 2;
+    value ^= value << 4;
+    value ^= value << 8;
+    value ^= value << 16;
+    value ^= value << 32;
+
+    return value;
+}
+
+#ifdef NUJ_X64
+static void nuj__index_classify_sse2(const unsigned char* block, NUJIndexMasks* masks)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i obrace = _mm_set1_epi8('{');
+    const __m128i cbrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i control_count = _mm_set1_epi8('\r' - '\t');
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int i = 0;
+
+    masks->quote = masks->backslash = masks->op = masks->whitespace = 0;
+
+    for (i = 0; i < 64; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + i));
+        // NOTE: '[' and ']' only differ from '{' and '}' by 0x20.
+        __m128i v_lower = _mm_or_si128(v, lower);
+        // NOTE: '\t', '\n', '\v', '\f' and '\r' are contiguous.
+        __m128i v_control = _mm_sub_epi8(v, tab);
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v_lower, obrace), _mm_cmpeq_epi8(v_lower, cbrace)),
+                                  _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)),
+                                               _mm_cmpeq_epi8(v, zero)));
+        __m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                          _mm_cmpeq_epi8(_mm_min_epu8(v_control, control_count), v_control));
+
+        masks->quote |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << i;
+        masks->backslash |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << i;
+        masks->op |= (unsigned long long)(unsigned int)_mm_movemask_epi8(op) << i;
+        masks->whitespace |= (unsigned long long)(unsigned int)_mm_movemask_epi8(whitespace) << i;
+    }
+}
+
+NUJ_TARGET_AVX2 static void nuj__index_classify_avx2(const unsigned char* block, NUJIndexMasks* masks)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i obrace = _mm256_set1_epi8('{');
+    const __m256i cbrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i control_count = _mm256_set1_epi8('\r' - '\t');
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned int i = 0;
+
+    masks->quote = masks->backslash = masks->op = masks->whitespace = 0;
+
+    for (i = 0; i < 64; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(block + i));
+        __m256i v_lower = _mm256_or_si256(v, lower);
+        __m256i v_control = _mm256_sub_epi8(v, tab);
+        __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v_lower, obrace), _mm256_cmpeq_epi8(v_lower, cbrace)),
+                                     _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)),
+                                                     _mm256_cmpeq_epi8(v, zero)));
+        __m256i whitespace = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                                             _mm256_cmpeq_epi8(_mm256_min_epu8(v_control, control_count), v_control));
+
+        masks->quote |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << i;
+        masks->backslash |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)) << i;
+        masks->op |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(op) << i;
+        masks->whitespace |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(whitespace) << i;
+    }
+}
+
+static int nuj__index_cpu_has_avx2(void)
+{
+    int result = 0;
+    unsigned int info[4] = { 0 };
+    unsigned long long xcr0 = 0;
+
+#if defined(_MSC_VER)
+    __cpuid((int*)info, 1);
+#else
+    __cpuid(1, info[0], info[1], info[2], info[3]);
+#endif
+
+    // NOTE: OSXSAVE and AVX, then check the OS saves YMM registers.
+    if ((info[2] & (1u << 27)) && (info[2] & (1u << 28)))
+    {
+#if defined(_MSC_VER)
+        xcr0 = _xgetbv(0);
+        __cpuidex((int*)info, 7, 0);
+#else
+        unsigned int eax = 0;
+        unsigned int edx = 0;
+
+        __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = ((unsigned long long)edx << 32) | eax;
+        __cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+#endif
+
+        result = ((xcr0 & 0x6) == 0x6) && (info[1] & (1u << 5));
+    }
+
+    return result;
+}
+#endif // NUJ_X64
+
+// NOTE: Returns 0 if there is no vectorized classifier for this
+// machine, in that case we fall back to the scalar tokenizer.
+static NUJIndexClassifyFunc* nuj__index_get_classify_func(void)
+{
+#ifdef NUJ_X64
+    // NOTE: Workers of nuj_parse_parallel and nuj_parse_lines can get
+    // here at the same time, so classify is loaded and stored
+    // atomically.  They all store the same function.
+    static NUJIndexClassifyFunc* classify = 0;
+    NUJIndexClassifyFunc* result = 0;
+
+#if defined(_MSC_VER)
+    // NOTE: Aligned pointer loads and stores are atomic on x64.
+    result = *(NUJIndexClassifyFunc* volatile*)&classify;
+#else
+    result = __atomic_load_n(&classify, __ATOMIC_RELAXED);
+#endif
+
+    if (!result)
+    {
+        result = nuj__index_cpu_has_avx2() ? nuj__index_classify_avx2 : nuj__index_classify_sse2;
+#if defined(_MSC_VER)
+        *(NUJIndexClassifyFunc* volatile*)&classify = result;
+#else
+        __atomic_store_n(&classify, result, __ATOMIC_RELAXED);
+#endif
+    }
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
+static void nuj__index_next_block(NUJParser* parser)
+{
+    NUJ_STATS_BEGIN(start_cycles)
+    // NOTE: Odd bits mask, used to find the chars escaped by an odd
+    // number of backslashes.
+    const unsigned long long odd_bits = 0xAAAAAAAAAAAAAAAAULL;
+    NUJIndex* index = &parser->index;
+    NUJIndexMasks masks = NUJ_ZERO;
+    const unsigned char* block = parser->initial + index->next_offset;
+    unsigned char padded[64];
+    unsigned long long escaped = 0;
+    unsigned long long quote = 0;
+    unsigned long long in_string = 0;
+    unsigned long long scalar = 0;
+
+    if (index->size - index->next_offset < sizeof(padded))
+    {
+        // NOTE: Pad the tail with whitespace, so we never read past the input.
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, block, index->size - index->next_offset);
+        block = padded;
+    }
+
+    index->classify(block, &masks);
+
+    if (masks.backslash)
+    {
+        unsigned long long potential_escape = masks.backslash & ~index->escaped;
+        unsigned long long escape_and_terminal = (((potential_escape << 1) | odd_bits) - potential_escape) ^ odd_bits;
+
+        escaped = escape_and_terminal ^ (masks.backslash | index->escaped);
+        index->escaped = (escape_and_terminal & masks.backslash) >> 63;
+    }
+    else
+    {
+        escaped = index->escaped;
+        index->escaped = 0;
+    }
+
+    quote = masks.quote & ~escaped;
+    in_string = nuj__index_prefix_xor(quote) ^ index->in_string;
+    scalar = ~(masks.op | masks.whitespace | quote);
+
+    index->structurals = ((masks.op | (scalar & ~((scalar << 1) | index->scalar))) & ~in_string) | quote;
+    index->in_string = 0ULL - (in_string >> 63);
+    index->scalar = scalar >> 63;
+    index->block_offset = index->next_offset;
+    index->next_offset += sizeof(padded);
+    NUJ_STATS_ADD(parser->stats, indexed_size, sizeof(padded));
+    NUJ_STATS_END(parser->stats, index_cycles, start_cycles);
+}
+
+// NOTE: Returns the position of the next structural char or parser->end.
+static inline const unsigned char* nuj__index_next_structural(NUJParser* parser)
+{
+    NUJIndex* index = &parser->index;
+    const unsigned char* result = parser->end;
+
+    while (!index->structurals && index->next_offset < index->size)
+    {
+        nuj__index_next_block(parser);
+    }
+
+    if (index->structurals)
+    {
+        result = parser->initial + index->block_offset + nuj__index_ctz(index->structurals);
+        index->structurals &= index->structurals - 1;
+    }
+
+    return result;
+}
+
+// NOTE: With NUJ_PARSE_SOFT_ERRORS the parser only remembers the
+// error and reports the end of input from then on.  Expected is 0 if
+// any value was expected.  A parser that failed because the handle is
+// full always stops this way, the end of input it reports is not an
+// error.
+static void nuj__parse_error(NUJParser* parser, NUJToken token, char expected)
+{
+    const unsigned char* initial = parser->initial;
+    unsigned int line_count = 1;
+    unsigned int char_count = 0;
+
+    if ((parser->flags & NUJ_PARSE_SOFT_ERRORS) || parser->failed)
+    {
+        parser->failed = 1;
+        return;
+    }
+
+    while (initial != token.start)
+    {
+        ++char_count;
+
+        if (*initial++ == '\n')
+        {
+            ++line_count;
+            char_count = 0;
+        }
+    }
+
+    // NOTE: Subtract (") quote?
+    if (token.type == NUJ_STRING_TYPE)
+    {
+        --char_count;
+    }
+
+    if (expected)
+    {
+        fprintf(stderr, "Syntax error: '%c' expected but found (%.*s) at line (%u, %u)!\n", expected, token.length, token.start, line_count, char_count);
+    }
+    else
+    {
+        fprintf(stderr, "Syntax error: value expected but found (%.*s) at line (%u, %u)!\n", token.length, token.start, line_count, char_count);
+    }
+
+    NUJ_ASSERT(0);
+}
+
+// NOTE: Without buffer_size the buffer is null terminated.  Nothing
+// past buffer_size is read, so buffers may be slices of bigger ones.
+static void nuj__parse_init(NUJParser* parser, const unsigned char* buffer, unsigned long long buffer_size)
+{
+    memset(parser, 0, sizeof(*parser));
+
+    if (!buffer_size)
+    {
+        buffer_size = strlen((const char*)buffer);
+    }
+
+    parser->initial = buffer;
+    parser->current = buffer;
+    parser->end = buffer + buffer_size;
+
+    if (buffer_size)
+    {
+        parser->index.classify = nuj__index_get_classify_func();
+        parser->index.size = buffer_size;
+    }
+}
+
+static inline int nuj__parse_is_whitespace_char(char character)
+{
+    int result = ((character == ' ')  ||
+                  (character == '\t') ||
+                  (character == '\v') ||
+                  (character == '\f') ||
+                  (character == '\n') ||
+                  (character == '\r'));
+
+    return result;
+}
+
+static inline void nuj__parse_skip_all_whitespace_chars(NUJParser* parser)
+{
+    while (parser->current < parser->end && nuj__parse_is_whitespace_char(*parser->current))
+    {
+        ++parser->current;
+    }
+}
+
+static inline int nuj__parse_is_numeric(char character)
+{
+    int result = 0;
+
+    if (character >= '0' && character <= '9')
+    {
+        result = NUJ_NUMBER_TYPE;
+    }
+    else if (character == '.')
+    {
+        result = NUJ_DOUBLE_TYPE;
+    }
+
+    return result;
+}
+
+static inline int nuj__parse_skip_all_numerics(NUJParser* parser)
+{
+    const unsigned char* end = parser->end;
+    int result = 0;
+    int is_numeric = parser->current < end ? nuj__parse_is_numeric(*parser->current) : 0;
+
+    while (is_numeric)
+    {
+        ++parser->current;
+
+        if (result < is_numeric)
+        {
+            result = is_numeric;
+        }
+
+        is_numeric = parser->current < end ? nuj__parse_is_numeric(*parser->current) : 0;
+    }
+
+    if (result && parser->current < end && (*parser->current == 'e' || *parser->current == 'E'))
+    {
+        const unsigned char* exponent = parser->current + 1;
+
+        if (exponent < end && (*exponent == '-' || *exponent == '+'))
+        {
+            ++exponent;
+        }
+
+        // NOTE: An exponent without digits isn't part of the number,
+        // the 'e' is then reported as an unknown token.
+        if (exponent < end && *exponent >= '0' && *exponent <= '9')
+        {
+            while (exponent < end && *exponent >= '0' && *exponent <= '9')
+            {
+                ++exponent;
+            }
+
+            parser->current = exponent;
+            result = NUJ_DOUBLE_TYPE;
+        }
+    }
+
+    return result;
+}
+
+static NUJToken nuj__parse_get_token(NUJParser* parser)
+{
+    NUJToken token = NUJ_ZERO;
+    unsigned char current = 0;
+
+    if (parser->failed)
+    {
+        token.start = parser->end;
+        token.type = NUJ_EOF_TYPE;
+
+        return token;
+    }
+
+    NUJ_STATS_ADD(parser->stats, token_count, 1);
+
+    if (parser->index.classify)
+    {
+        const unsigned char* next = nuj__index_next_structural(parser);
+
+        // NOTE: Only whitespace may come between the end of the
+        // previous token and the next structural char, anything else
+        // is reported as an unknown token.
+        if (parser->current >= next || nuj__parse_is_whitespace_char(*parser->current))
+        {
+            parser->current = next;
+        }
+
+        if (parser->current == parser->end)
+        {
+            token.start = parser->current;
+            token.type = NUJ_EOF_TYPE;
+
+            return token;
+        }
+    }
+    else
+    {
+        nuj__parse_skip_all_whitespace_chars(parser);
+
+        if (parser->current == parser->end)
+        {
+            token.start = parser->current;
+            token.type = NUJ_EOF_TYPE;
+
+            return token;
+        }
+    }
+
+    token.start = parser->current;
+    token.length = 1;
+
+    current = *parser->current;
+    ++parser->current;
+
+    switch (current)
+    {
+        case '[':  { token.type = NUJ_OBRACKET_TYPE; } break;
+        case '{':  { token.type = NUJ_OBRACE_TYPE;   } break;
+
+        case ']':  { token.type = NUJ_CBRACKET_TYPE; } break;
+        case '}':  { token.type = NUJ_CBRACE_TYPE;   } break;
+
+        case ':':  { token.type = NUJ_COLON_TYPE;    } break;
+        case ',':  { token.type = NUJ_COMMA_TYPE;    } break;
+
+        case '\0': { token.type = NUJ_EOF_TYPE;      } break;
+
+        case '"':
+        {
+            token.type = NUJ_STRING_TYPE;
+            token.start = parser->current;
+
+            // NOTE: Closing quote is the next structural char.
+            if (parser->index.classify)
+            {
+                parser->current = nuj__index_next_structural(parser);
+            }
+
+            while (!parser->index.classify && parser->current < parser->end)
+            {
+                if (*parser->current == '\\' && parser->current + 1 < parser->end)
+                {
+                    parser->current += 1;
+                }
+                else if (*parser->current == '"')
+                {
+                    break;
+                }
+
+                ++parser->current;
+            }
+
+            token.length = (unsigned int)(parser->current - token.start);
+
+            if (parser->current != parser->end && *parser->current == '"')
+            {
+                ++parser->current;
+            }
+            else
+            {
+                token.type = NUJ_UNKNOWN_TYPE;
+            }
+        }
+        break;
+
+        case 't':
+        {
+            if (parser->end - parser->current >= 3 &&
+                parser->current[0] == 'r' && parser->current[1] == 'u' && parser->current[2] == 'e')
+            {
+                token.type = NUJ_BOOLEAN_TYPE;
+                token.start = (unsigned char*)TRUE;
+                token.length = 1;
+                parser->current += 3;
+            }
+            else
+            {
+                token.type = NUJ_UNKNOWN_TYPE;
+                ++parser->current;
+            }
+        }
+        break;
+
+        case 'f':
+        {
+            if (parser->end - parser->current >= 4 &&
+                parser->current[0] == 'a' && parser->current[1] == 'l' &&
+                parser->current[2] == 's' && parser->current[3] == 'e')
+            {
+                token.type = NUJ_BOOLEAN_TYPE;
+                token.start = (unsigned char*)FALSE;
+                token.length = 1;
+                parser->current += 4;
+            }
+            else
+            {
+                token.type = NUJ_UNKNOWN_TYPE;
+                ++parser->current;
+            }
+        }
+        break;
+
+        case 'n':
+        {
+            if (parser->end - parser->current >= 3 &&
+                parser->current[0] == 'u' && parser->current[1] == 'l' && parser->current[2] == 'l')
+            {
+                token.type = NUJ_NULL_TYPE;
+                token.start = (unsigned char*)0;
+                token.length = 1;
+                parser->current += 3;
+            }
+            else
+            {
+                token.type = NUJ_UNKNOWN_TYPE;
+                ++parser->current;
+            }
+        }
+        break;
+
+        default:
+        {
+            token.type = NUJ_UNKNOWN_TYPE;
+
+            --parser->current;
+
+            if (*parser->current == '-' || *parser->current == '+')
+            {
+                token.start = parser->current++;
+                token.type = nuj__parse_skip_all_numerics(parser);
+                token.length = (unsigned int)(parser->current - token.start);
+            }
+            else if (nuj__parse_is_numeric(*parser->current))
+            {
+                token.start = parser->current;
+                token.type = nuj__parse_skip_all_numerics(parser);
+                token.length = (unsigned int)(parser->current - token.start);
+            }
+        }
+        break;
+    }
+
+    return token;
+}
+
+static inline int nuj__parse_match_token(NUJToken token, unsigned int match_token_type)
+{
+    int result = 1;
+
+    if (token.type != match_token_type)
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+// NOTE: Sign of the difference between digits * 10^exponent, plus a
+// bit more if is_truncated, and the midpoint between the double with
+// bits and the next one up, (2 * mantissa + 1) * 2^(binary_exponent -
+// 1).  The power of 5 of 10^exponent is already in digits if exponent
+// is positive and in power if it is negative, so only powers of 2 are
+// left and one side is shifted by their difference.
+static int nuj__compare_midpoint(const NUJBig* digits, const NUJBig* power, int exponent, int is_truncated, unsigned long long bits)
+{
+    NUJBig left;
+    NUJBig right;
+    NUJBig midpoint;
+    unsigned long long mantissa = bits & ((1ULL << 52) - 1);
+    int binary_exponent = (int)(bits >> 52);
+    int shift = 0;
+    int result = 0;
+
+    if (binary_exponent)
+    {
+        mantissa |= 1ULL << 52;
+        binary_exponent -= 1075;
+    }
+    else
+    {
+        binary_exponent = -1074;
+    }
+
+    shift = exponent - binary_exponent + 1;
+    left.count = digits->count;
+    memcpy(left.words, digits->words, digits->count * sizeof(*digits->words));
+    nuj__big_set(&midpoint, 2 * mantissa + 1, 0);
+    nuj__big_mul_big(&right, &midpoint, power);
+    nuj__big_shift(shift > 0 ? &left : &right, (unsigned int)(shift > 0 ? shift : -shift));
+
+    result = nuj__big_compare(&left, &right);
+
+    if (!result && is_truncated)
+    {
+        result = 1;
+    }
+
+    return result;
+}
+
+// NOTE: Bits of the double nearest to mantissa * 10^exponent, by
+// Eisel and Lemire's algorithm: the 19 digit mantissa times the 128
+// bit power of 10 has all 54 bits needed to round, which Mushtak and
+// Lemire proved for every mantissa and exponent.  Only exact ties are
+// told apart by their low bits, they can only happen for small
+// exponents.  mantissa is not 0.
+static unsigned long long nuj__parse_eisel_lemire(unsigned long long mantissa, int exponent)
+{
+    const unsigned long long* power = 0;
+    unsigned long long low = 0;
+    unsigned long long high = 0;
+    unsigned long long second_high = 0;
+    unsigned long long bits = 0;
+    unsigned int leading_zeros = 0;
+    unsigned int upper_bit = 0;
+    int binary_exponent = 0;
+
+    if (exponent < NUJ_MIN_POWER_OF_10)
+    {
+        return 0;
+    }
+
+    if (exponent > 308)
+    {
+        return 0x7FF0000000000000ULL;
+    }
+
+    power = nuj__powers_of_10 + 2 * (exponent - NUJ_MIN_POWER_OF_10);
+    leading_zeros = nuj__count_leading_zeros(mantissa);
+    mantissa <<= leading_zeros;
+
+    // NOTE: The low word of the power only matters if the bits below
+    // the 55 kept ones are all ones.  The powers from 10^-27 to 10^-1
+    // were rounded up when the algorithm was proved.
+    low = nuj__mul_64(mantissa, power[0], &high);
+
+    if ((high & 0x1FF) == 0x1FF)
+    {
+        nuj__mul_64(mantissa, power[1] + (exponent >= -27 && exponent < 0), &second_high);
+        low += second_high;
+        high += low < second_high;
+    }
+
+    upper_bit = (unsigned int)(high >> 63);
+    bits = high >> (upper_bit + 9);
+    binary_exponent = (int)nuj__floor_shift(217706LL * exponent, 16) + 63 + (int)upper_bit - (int)leading_zeros + 1023;
+
+    if (binary_exponent <= 0)
+    {
+        // NOTE: Denormal, rounded at the bit the exponent leaves.
+        if (-binary_exponent + 1 >= 64)
+        {
+            return 0;
+        }
+
+        bits >>= -binary_exponent + 1;
+        bits = (bits + (bits & 1)) >> 1;
+
+        return bits;
+    }
+
+    // NOTE: Exactly halfway, round down to even instead of up.
+    if (low <= 1 && exponent >= -4 && exponent <= 23 && (bits & 3) == 1 && (bits << (upper_bit + 9)) == high)
+    {
+        bits &= ~1ULL;
+    }
+
+    bits = (bits + (bits & 1)) >> 1;
+
+    if (bits >= (2ULL << 52))
+    {
+        bits = 1ULL << 52;
+        ++binary_exponent;
+    }
+
+    if (binary_exponent >= 0x7FF)
+    {
+        return 0x7FF0000000000000ULL;
+    }
+
+    return (bits & ~(1ULL << 52)) | ((unsigned long long)binary_exponent << 52);
+}
+
+// NOTE: Correctly rounded value of the digits from current, up to end
+// or an exponent, times 10^explicit_exponent, for the rare numbers
+// with more than 19 digits whose first 19 don't decide the rounding.
+// bits is a double next to the result, and moves one double at a time
+// until the exact digits are between the midpoints around it.  Ties go
+// to the even mantissa.
+static double nuj__parse_exact_number(const unsigned char* current, const unsigned char* end, int explicit_exponent, unsigned long long bits)
+{
+    NUJBig digits;
+    NUJBig power;
+    unsigned int digit = 0;
+    unsigned int chunk = 0;
+    unsigned int chunk_length = 0;
+    int digit_count = 0;
+    int digits_exponent = explicit_exponent;
+    int is_fraction = 0;
+    int is_truncated = 0;
+    int comparison = 0;
+    double result = 0.0;
+
+    digits.count = 0;
+
+    while (current < end && (*current == '.' || (digit = (unsigned int)(*current - '0')) < 10))
+    {
+        if (*current == '.')
+        {
+            is_fraction = 1;
+        }
+        else if (digit_count < NUJ_MAX_NUMBER_DIGITS)
+        {
+            if (digit_count || digit)
+            {
+                chunk = 10 * chunk + digit;
+                ++digit_count;
+
+                if (++chunk_length == 9)
+                {
+                    nuj__big_mul_add(&digits, 1000000000, chunk);
+                    chunk = 0;
+                    chunk_length = 0;
+                }
+            }
+
+            digits_exponent -= is_fraction;
+        }
+        else
+        {
+            is_truncated |= digit != 0;
+            digits_exponent += !is_fraction;
+        }
+
+        ++current;
+    }
+
+    nuj__big_mul_pow10(&digits, chunk_length);
+    nuj__big_mul_add(&digits, 1, chunk);
+
+    // NOTE: Below 10^-342 everything rounds to 0 and above 10^310 to
+    // infinity, and the powers of 5 would not fit in NUJBig.
+    if (!digits.count || digit_count + digits_exponent < -342)
+    {
+        bits = 0;
+    }
+    else if (digit_count + digits_exponent > 310)
+    {
+        bits = 0x7FF0000000000000ULL;
+    }
+    else
+    {
+        nuj__big_set(&power, 1, 0);
+        nuj__big_mul_pow5(digits_exponent > 0 ? &digits : &power, (unsigned int)(digits_exponent > 0 ? digits_exponent : -digits_exponent));
+
+        // NOTE: At a midpoint, move up if that makes the mantissa even.
+        while (bits < 0x7FF0000000000000ULL &&
+               ((comparison = nuj__compare_midpoint(&digits, &power, digits_exponent, is_truncated, bits)) > 0 || (!comparison && (bits & 1))))
+        {
+            ++bits;
+        }
+
+        while (bits > 0 &&
+               ((comparison = nuj__compare_midpoint(&digits, &power, digits_exponent, is_truncated, bits - 1)) < 0 || (!comparison && (bits & 1))))
+        {
+            --bits;
+        }
+    }
+
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+// NOTE: Returns 1 and sets integer if the token is an integer that
+// fits in a long long, otherwise returns 0 and sets number.  At most
+// 19 significant digits are accumulated.  When they fit in 53 bits
+// and the exponent is small, the double is the correctly rounded
+// product or quotient of two exact doubles (Clinger's fast path),
+// the rest goes through nuj__parse_eisel_lemire, and only longer
+// numbers it can't round through nuj__parse_exact_number.  None of
+// them depends on the locale.
+static int nuj__parse_token_to_number(NUJToken token, long long* integer, double* number)
+{
+    static const double powers_of_ten[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    const unsigned char* current = token.start;
+    const unsigned char* end = token.start + token.length;
+    const unsigned char* digits = 0;
+    unsigned long long mantissa = 0;
+    unsigned int digit = 0;
+    int digit_count = 0;
+    int exponent = 0;
+    int explicit_exponent = 0;
+    int is_truncated = 0;
+    int is_integer = 1;
+    int negative = 0;
+    int result = 0;
+
+    if (*current == '-' || *current == '+')
+    {
+        negative = *current == '-';
+        ++current;
+    }
+
+    digits = current;
+
+    while (current < end && (digit = (unsigned int)(*current - '0')) < 10)
+    {
+        if (digit_count < 19)
+        {
+            mantissa = 10 * mantissa + digit;
+            digit_count += mantissa != 0;
+        }
+        else
+        {
+            is_truncated |= digit != 0;
+            ++exponent;
+        }
+
+        ++current;
+    }
+
+    if (current < end && *current == '.')
+    {
+        is_integer = 0;
+        ++current;
+
+        while (current < end && (digit = (unsigned int)(*current - '0')) < 10)
+        {
+            if (digit_count < 19)
+            {
+                mantissa = 10 * mantissa + digit;
+                digit_count += mantissa != 0;
+                --exponent;
+            }
+            else
+            {
+                is_truncated |= digit != 0;
+            }
+
+            ++current;
+        }
+    }
+
+    if (current < end && (*current == 'e' || *current == 'E'))
+    {
+        int exponent_negative = 0;
+
+        is_integer = 0;
+        ++current;
+
+        if (current < end && (*current == '-' || *current == '+'))
+        {
+            exponent_negative = *current == '-';
+            ++current;
+        }
+
+        while (current < end && (digit = (unsigned int)(*current - '0')) < 10)
+        {
+            if (explicit_exponent < 100000)
+            {
+                explicit_exponent = 10 * explicit_exponent + (int)digit;
+            }
+
+            ++current;
+        }
+
+        explicit_exponent = exponent_negative ? -explicit_exponent : explicit_exponent;
+        exponent += explicit_exponent;
+    }
+
+    if (is_integer && !is_truncated && exponent == 0 &&
+        mantissa <= (negative ? 9223372036854775808ULL : 9223372036854775807ULL))
+    {
+        *integer = negative ? -(long long)(mantissa - 1) - 1 : (long long)mantissa;
+        result = 1;
+    }
+    else if (!is_truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double value = (double)mantissa;
+
+        value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+        *number = negative ? -value : value;
+    }
+    else
+    {
+        unsigned long long bits = mantissa ? nuj__parse_eisel_lemire(mantissa, exponent) : 0;
+        double value = 0.0;
+
+        // NOTE: Digits cut after the 19th put the number between
+        // mantissa and mantissa + 1, if both round the same it is done.
+        if (is_truncated && bits != nuj__parse_eisel_lemire(mantissa + 1, exponent))
+        {
+            value = nuj__parse_exact_number(digits, end, explicit_exponent, bits);
+        }
+        else
+        {
+            memcpy(&value, &bits, sizeof(value));
+        }
+
+        *number = negative ? -value : value;
+    }
+
+    return result;
+}
+
+static NUJElement* nuj__parse_token_to_element(NUJHandle handle, NUJToken token, unsigned int flags)
+{
+    NUJElement* element = 0;
+
+    switch (token.type)
+    {
+        case NUJ_STRING_TYPE:
+        {
+            element = nuj_create_element_string(handle, 0);
+
+            if (element && (flags & NUJ_PARSE_INSITU))
+            {
+                char* svalue = (char*)token.start;
+
+                token.length = nuj_decode_string(svalue, token.length, svalue);
+                svalue[token.length] = '\0';
+                NUJ_STRING(element)->value = svalue;
+            }
+            else if (element && (flags & NUJ_PARSE_VIEWS))
+            {
+                NUJ_STRING(element)->value = (const char*)token.start;
+            }
+            else if (element)
+            {
+                char* svalue = (char*)nuj__push_size(handle, token.length + 1);
+
+                if (svalue)
+                {
+                    memcpy(svalue, token.start, token.length);
+                    svalue[token.length] = '\0';
+                    NUJ_STRING(element)->value = svalue;
+                    NUJ_STATS_ADD(&handle->stats, string_copy_size, token.length);
+                }
+                else
+                {
+                    nuj__free_size(handle, element, sizeof(NUJString));
+                    element = 0;
+                }
+            }
+
+            if (element)
+            {
+                NUJ_STRING(element)->length = token.length;
+            }
+        }
+        break;
+        case NUJ_NUMBER_TYPE:
+        case NUJ_DOUBLE_TYPE:
+        {
+            long long integer = 0;
+            double number = 0;
+
+            if (nuj__parse_token_to_number(token, &integer, &number))
+            {
+                element = nuj_create_element_integer(handle, integer);
+            }
+            else
+            {
+                element = nuj_create_element_double(handle, number);
+            }
+        }
+        break;
+        case NUJ_BOOLEAN_TYPE:
+        {
+            long long value = (long long)token.start;
+
+            element = nuj_create_element_boolean(handle, (int)value);
+        }
+        break;
+        case NUJ_NULL_TYPE:
+        {
+            element = nuj_create_element_null(handle);
+        }
+        break;
+    }
+
+    return element;
+}
+
+static NUJElement* nuj__parse_element_pair_value(NUJHandle handle, NUJParser* parser)
+{
+    NUJElement* element = 0;
+    NUJToken token = nuj__parse_get_token(parser);
+
+    switch (token.type)
+    {
+        case NUJ_STRING_TYPE:
+        case NUJ_NUMBER_TYPE:
+        case NUJ_DOUBLE_TYPE:
+        case NUJ_BOOLEAN_TYPE:
+        case NUJ_NULL_TYPE:
+        {
+            element = nuj__parse_token_to_element(handle, token, parser->flags);
+        }
+        break;
+        case NUJ_OBRACKET_TYPE:
+        {
+            element = nuj__parse_element_array(handle, parser);
+        }
+        break;
+        case NUJ_OBRACE_TYPE:
+        {
+            element = nuj__parse_element_object(handle, parser);
+        }
+        break;
+        default:
+        {
+            // NOTE: Placeholder, so a soft error leaves a valid tree.
+            nuj__parse_error(parser, token, 0);
+            element = nuj_create_element_null(handle);
+        }
+        break;
+    }
+
+    // NOTE: The handle is full.  Containers return 0 when a child does,
+    // so the whole parse fails.
+    if (!element)
+    {
+        parser->failed = 1;
+    }
+
+    return element;
+}
+
+static inline int nuj__parse_set_element_pair_name(NUJHandle handle, NUJElement* element, NUJToken token, unsigned int flags)
+{
+    if (flags & NUJ_PARSE_INSITU)
+    {
+        char* name = (char*)token.start;
+
+        token.length = nuj_decode_string(name, token.length, name);
+        name[token.length] = '\0';
+        element->name = name;
+    }
+    else if (flags & NUJ_PARSE_VIEWS)
+    {
+        element->name = (const char*)token.start;
+    }
+    else
+    {
+        const char* name = 0;
+
+        if (handle->intern_table)
+        {
+            name = nuj_intern_name(handle->intern_table, (const char*)token.start, token.length);
+        }
+
+        if (!name)
+        {
+            char* copy = (char*)nuj__push_size(handle, token.length + 1);
+
+            if (copy)
+            {
+                memcpy(copy, token.start, token.length);
+                copy[token.length] = '\0';
+                name = copy;
+                NUJ_STATS_ADD(&handle->stats, string_copy_size, token.length);
+            }
+        }
+
+        element->name = name;
+    }
+
+    element->name_length = token.length;
+
+    return element->name != 0;
+}
+
+static NUJElement* nuj__parse_element_pair(NUJHandle handle, NUJParser* parser, int in_object)
+{
+    NUJElement* element = 0;
+
+    if (in_object)
+    {
+        NUJToken string_token = nuj__parse_get_token(parser);
+        NUJToken token = NUJ_ZERO;
+
+        if (nuj__parse_match_token(string_token, NUJ_STRING_TYPE))
+        {
+            token = nuj__parse_get_token(parser);
+        }
+        else
+        {
+            nuj__parse_error(parser, string_token, '\"');
+        }
+
+        if (nuj__parse_match_token(token, NUJ_COLON_TYPE))
+        {
+            element = nuj__parse_element_pair_value(handle, parser);
+
+            if (element && !nuj__parse_set_element_pair_name(handle, element, string_token, parser->flags))
+            {
+                element = 0;
+            }
+        }
+        else
+        {
+            nuj__parse_error(parser, token, ':');
+            element = nuj_create_element_null(handle);
+        }
+
+        if (!element)
+        {
+            parser->failed = 1;
+        }
+    }
+    else
+    {
+        element = nuj__parse_element_pair_value(handle, parser);
+    }
+
+    return element;
+}
+
+// NOTE: Children of NUJObject/NUJArray are parsed right after the
+// container itself, so we don't know how many of them there are
+// until the closing token.  While parsing, each child's parent field
+// points to its previous sibling, so when the container is closed we
+// push the children array after the last child and fill it by
+// following these links backwards.  Returns 0 if the handle is full.
+static NUJElement* nuj__parse_create_element_object_or_array(NUJHandle handle, NUJElement* element, NUJElement* last_element, unsigned int element_count)
+{
+    NUJElement* el = last_element;
+    NUJElement* previous = 0;
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+    unsigned int i = element_count;
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+
+    nuj_object->children = (NUJElement**)nuj__push_size(handle, element_count * sizeof(NUJElement*));
+
+    if (!nuj_object->children)
+    {
+        return 0;
+    }
+
+    nuj_object->child_count = element_count;
+    nuj_object->max_child_count = element_count;
+
+    while (i--)
+    {
+        previous = el->parent;
+        nuj_object->children[i] = el;
+        el->parent = element;
+        el = previous;
+    }
+
+    return element;
+}
+
+// NOTE: Links child to its previous sibling until the container is
+// closed.  Returns the number of children linked, a child of 0 failed
+// to parse because the handle is full and is left out.
+static inline unsigned int nuj__parse_link_element(NUJElement* child, NUJElement** last_element)
+{
+    if (child)
+    {
+        child->parent = *last_element;
+        *last_element = child;
+    }
+
+    return child != 0;
+}
+
+// NOTE: Returns 1 and consumes the token if the next token is the
+// closing token of an empty NUJObject/NUJArray.
+static inline int nuj__parse_match_empty_element(NUJParser* parser, unsigned int close_token_type)
+{
+    NUJParser current_parser = *parser;
+    NUJToken token = nuj__parse_get_token(&current_parser);
+    int result = nuj__parse_match_token(token, close_token_type);
+
+    if (result)
+    {
+        *parser = current_parser;
+    }
+
+    return result;
+}
+
+static NUJElement* nuj__parse_element_array(NUJHandle handle, NUJParser* parser)
+{
+    NUJToken token = NUJ_ZERO;
+    int done = 0;
+    NUJElement* array_element = 0;
+    NUJElement* last_element = 0;
+    unsigned int element_count = 0;
+
+    NUJ_STATS_ENTER(parser);
+    array_element = nuj_create_element_array(handle, 0);
+
+    if (!array_element)
+    {
+        parser->failed = 1;
+        done = 1;
+    }
+    else if (nuj__parse_match_empty_element(parser, NUJ_CBRACKET_TYPE))
+    {
+        done = 1;
+    }
+    else
+    {
+        element_count += nuj__parse_link_element(nuj__parse_element_pair(handle, parser, 0), &last_element);
+    }
+
+    while (!done)
+    {
+        token = nuj__parse_get_token(parser);
+
+        switch (token.type)
+        {
+            case NUJ_COMMA_TYPE:
+            {
+                element_count += nuj__parse_link_element(nuj__parse_element_pair(handle, parser, 0), &last_element);
+            }
+            break;
+            case NUJ_CBRACKET_TYPE:
+            {
+                done = 1;
+            }
+            break;
+            default:
+            {
+                nuj__parse_error(parser, token, ',');
+                done = 1;
+            }
+            break;
+        }
+    }
+
+    if (element_count)
+    {
+        array_element = nuj__parse_create_element_object_or_array(handle, array_element, last_element, element_count);
+    }
+
+    NUJ_STATS_LEAVE(parser);
+
+    return array_element;
+}
+
+static NUJElement* nuj__parse_element_object(NUJHandle handle, NUJParser* parser)
+{
+    NUJToken token = NUJ_ZERO;
+    int done = 0;
+    NUJElement* object_element = 0;
+    NUJElement* last_element = 0;
+    unsigned int element_count = 0;
+
+    NUJ_STATS_ENTER(parser);
+    object_element = nuj_create_element_object(handle, 0);
+
+    // NOTE: If it is object with 0 child skip this and find '}' token.
+    if (!object_element)
+    {
+        parser->failed = 1;
+        done = 1;
+    }
+    else if (nuj__parse_match_empty_element(parser, NUJ_CBRACE_TYPE))
+    {
+        done = 1;
+    }
+    else
+    {
+        element_count += nuj__parse_link_element(nuj__parse_element_pair(handle, parser, 1), &last_element);
+    }
+
+    while (!done)
+    {
+        token = nuj__parse_get_token(parser);
+
+        switch (token.type)
+        {
+            case NUJ_COMMA_TYPE:
+            {
+                element_count += nuj__parse_link_element(nuj__parse_element_pair(handle, parser, 1), &last_element);
+            }
+            break;
+            case NUJ_CBRACE_TYPE:
+            {
+                done = 1;
+            }
+            break;
+            default:
+            {
+                nuj__parse_error(parser, token, ',');
+                done = 1;
+            }
+            break;
+        }
+    }
+
+    if (element_count)
+    {
+        object_element = nuj__parse_create_element_object_or_array(handle, object_element, last_element, element_count);
+
+        if (object_element && (parser->flags & NUJ_PARSE_INDEX_KEYS) && element_count >= NUJ_KEY_INDEX_MIN_COUNT)
+        {
+            nuj__create_key_index(handle, object_element);
+        }
+    }
+
+    NUJ_STATS_LEAVE(parser);
+
+    return object_element;
+}
+
+// NOTE: Adds a finished value to the open container, or makes it the
+// root.  Containers are added when they are opened.  An element of 0
+// couldn't be created because the handle is full.
+static int nuj__push_add_element(NUJPushParser* parser, NUJElement* element)
+{
+    int result = 1;
+
+    if (!element)
+    {
+        result = 0;
+    }
+    else if (parser->depth)
+    {
+        NUJPushFrame* frame = &parser->frames[parser->depth - 1];
+
+        element->name = parser->name;
+        element->name_length = parser->name_length;
+        frame->element_count += nuj__parse_link_element(element, &frame->last_element);
+        parser->name = 0;
+        parser->state = NUJ_PUSH_COMMA_OR_CLOSE_STATE;
+    }
+    else if (element->type == NUJObject_TYPE)
+    {
+        parser->root = element;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result && (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE))
+    {
+        if (parser->depth < NUJ_PUSH_MAX_DEPTH)
+        {
+            NUJPushFrame* frame = &parser->frames[parser->depth++];
+
+            frame->element = element;
+            frame->last_element = 0;
+            frame->element_count = 0;
+            parser->state = element->type == NUJObject_TYPE ? NUJ_PUSH_KEY_OR_CLOSE_STATE : NUJ_PUSH_VALUE_OR_CLOSE_STATE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int nuj__push_close_element(NUJPushParser* parser, unsigned char character)
+{
+    NUJPushFrame* frame = &parser->frames[parser->depth - 1];
+    NUJElement* element = frame->element;
+    int result = character == (element->type == NUJObject_TYPE ? '}' : ']');
+
+    if (result)
+    {
+        if (frame->element_count)
+        {
+            result = nuj__parse_create_element_object_or_array(parser->handle, element, frame->last_element, frame->element_count) != 0;
+
+            if (result && (parser->flags & NUJ_PARSE_INDEX_KEYS) && element->type == NUJObject_TYPE &&
+                frame->element_count >= NUJ_KEY_INDEX_MIN_COUNT)
+            {
+                nuj__create_key_index(parser->handle, element);
+            }
+        }
+
+        --parser->depth;
+        parser->state = parser->depth ? NUJ_PUSH_COMMA_OR_CLOSE_STATE : NUJ_PUSH_DONE_STATE;
+    }
+
+    return result;
+}
+
+static int nuj__push_end_string(NUJPushParser* parser)
+{
+    int result = 1;
+    char* string = (char*)nuj__grow_size(parser->handle, parser->string, parser->string_length, 1);
+
+    if (!string)
+    {
+        result = 0;
+    }
+    else if (parser->in_key)
+    {
+        const char* name = 0;
+
+        parser->string = string;
+        parser->string[parser->string_length] = '\0';
+
+        if (parser->handle->intern_table)
+        {
+            name = nuj_intern_name(parser->handle->intern_table, parser->string, parser->string_length);
+        }
+
+        if (name)
+        {
+            // NOTE: The key is the last push of the handle.
+            parser->handle->buffer_used -= parser->string_length + 1;
+        }
+
+        parser->name = name ? name : parser->string;
+        parser->name_length = parser->string_length;
+        parser->state = NUJ_PUSH_COLON_STATE;
+    }
+    else
+    {
+        parser->string = string;
+        parser->string[parser->string_length] = '\0';
+        NUJ_STRING(parser->string_element)->value = parser->string;
+        NUJ_STRING(parser->string_element)->length = parser->string_length;
+        nuj__push_add_element(parser, parser->string_element);
+    }
+
+    return result;
+}
+
+// NOTE: Numbers go through the regular tokenizer, so they are read
+// exactly like nuj_parse reads them.
+static int nuj__push_end_number(NUJPushParser* parser)
+{
+    NUJParser number_parser = NUJ_ZERO;
+    NUJToken token = NUJ_ZERO;
+    int result = 0;
+
+    parser->number[parser->number_length] = '\0';
+    nuj__parse_init(&number_parser, (const unsigned char*)parser->number, 0);
+    token = nuj__parse_get_token(&number_parser);
+
+    if ((token.type == NUJ_NUMBER_TYPE || token.type == NUJ_DOUBLE_TYPE) &&
+        token.start == (const unsigned char*)parser->number && token.length == parser->number_length)
+    {
+        result = nuj__push_add_element(parser, nuj__parse_token_to_element(parser->handle, token, 0));
+    }
+
+    return result;
+}
+
+static int nuj__push_begin_value(NUJPushParser* parser, unsigned char character)
+{
+    int result = 1;
+
+    switch (character)
+    {
+        case '{':
+        {
+            result = nuj__push_add_element(parser, nuj_create_element_object(parser->handle, 0));
+        }
+        break;
+        case '[':
+        {
+            result = nuj__push_add_element(parser, nuj_create_element_array(parser->handle, 0));
+        }
+        break;
+        case '"':
+        {
+            parser->in_key = 0;
+            parser->escaped = 0;
+            parser->string_element = nuj_create_element_string(parser->handle, 0);
+            parser->string = (char*)nuj__push_size(parser->handle, 0);
+            parser->string_length = 0;
+            parser->state = NUJ_PUSH_STRING_STATE;
+            result = parser->string_element != 0;
+        }
+        break;
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            parser->literal = character == 't' ? "true" : character == 'f' ? "false" : "null";
+            parser->literal_index = 1;
+            parser->state = NUJ_PUSH_LITERAL_STATE;
+        }
+        break;
+        default:
+        {
+            if (character == '-' || character == '+' || nuj__parse_is_numeric((char)character))
+            {
+                parser->number[0] = (char)character;
+                parser->number_length = 1;
+                parser->state = NUJ_PUSH_NUMBER_STATE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+static NUJElement* nuj__find_element_by_name(const NUJElement* element, const char* name, unsigned int length, unsigned int hash)
+{
+    NUJElement* found = nuj__find_child(element, name, length, hash);
+    NUJElement* el = 0;
+    unsigned int i = 0;
+
+    for (i = 0; !found && i < NUJ_COBJECT(element)->child_count; ++i)
+    {
+        el = NUJ_OBJECT(element)->children[i];
+
+        if (el->type == NUJObject_TYPE || el->type == NUJArray_TYPE)
+        {
+            found = nuj__find_element_by_name(el, name, length, hash);
+        }
+    }
+
+    return found;
+}
+
+// NOTE: Array index segments are plain decimals without leading zeros.
+static void nuj__compile_path_segment(NUJPathSegment* segment)
+{
+    unsigned int i = 0;
+
+    segment->hash = nuj__hash_name(segment->name, segment->length);
+    segment->index = 0;
+    segment->is_index = segment->length > 0 && segment->length <= 9 && (segment->name[0] != '0' || segment->length == 1);
+
+    for (i = 0; segment->is_index && i < segment->length; ++i)
+    {
+        if (segment->name[i] >= '0' && segment->name[i] <= '9')
+        {
+            segment->index = segment->index * 10 + (unsigned int)(segment->name[i] - '0');
+        }
+        else
+        {
+            segment->is_index = 0;
+        }
+    }
+}
+
+// NOTE: Returns 0 on syntax error or if a callback stopped parsing.
+static int nuj__sax_element(NUJParser* parser, NUJToken token, const NUJCallbacks* callbacks)
+{
+    int result = 0;
+
+    switch (token.type)
+    {
+        case NUJ_STRING_TYPE:
+        {
+            result = NUJ_SAX_CALL(callbacks, on_string, (callbacks->user_data, (const char*)token.start, token.length));
+        }
+        break;
+        case NUJ_NUMBER_TYPE:
+        case NUJ_DOUBLE_TYPE:
+        {
+            long long integer = 0;
+            double number = 0;
+
+            if (nuj__parse_token_to_number(token, &integer, &number))
+            {
+                result = NUJ_SAX_CALL(callbacks, on_integer, (callbacks->user_data, integer));
+            }
+            else
+            {
+                result = NUJ_SAX_CALL(callbacks, on_double, (callbacks->user_data, number));
+            }
+        }
+        break;
+        case NUJ_BOOLEAN_TYPE:
+        {
+            result = NUJ_SAX_CALL(callbacks, on_boolean, (callbacks->user_data, token.start != 0));
+        }
+        break;
+        case NUJ_NULL_TYPE:
+        {
+            result = NUJ_SAX_CALL(callbacks, on_null, (callbacks->user_data));
+        }
+        break;
+        case NUJ_OBRACE_TYPE:
+        case NUJ_OBRACKET_TYPE:
+        {
+            int in_object = token.type == NUJ_OBRACE_TYPE;
+            unsigned int close_token_type = in_object ? NUJ_CBRACE_TYPE : NUJ_CBRACKET_TYPE;
+            int done = 0;
+
+            result = in_object ? NUJ_SAX_CALL(callbacks, on_start_object, (callbacks->user_data)) : NUJ_SAX_CALL(callbacks, on_start_array, (callbacks->user_data));
+            done = !result || nuj__parse_match_empty_element(parser, close_token_type);
+
+            while (!done)
+            {
+                token = nuj__parse_get_token(parser);
+
+                if (in_object)
+                {
+                    if (nuj__parse_match_token(token, NUJ_STRING_TYPE) &&
+                        nuj__parse_match_token(nuj__parse_get_token(parser), NUJ_COLON_TYPE))
+                    {
+                        result = NUJ_SAX_CALL(callbacks, on_key, (callbacks->user_data, (const char*)token.start, token.length));
+                        token = nuj__parse_get_token(parser);
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+
+                result = result && nuj__sax_element(parser, token, callbacks);
+                token = nuj__parse_get_token(parser);
+                result = result && (token.type == NUJ_COMMA_TYPE || token.type == close_token_type);
+                done = !result || token.type == close_token_type;
+            }
+
+            if (result)
+            {
+                result = in_object ? NUJ_SAX_CALL(callbacks, on_end_object, (callbacks->user_data)) : NUJ_SAX_CALL(callbacks, on_end_array, (callbacks->user_data));
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+// NOTE: Size of the element and its subtree, 0 on syntax error.
+static unsigned long long nuj__measure_element(NUJParser* parser, NUJToken token)
+{
+    unsigned long long size = 0;
+
+    switch (token.type)
+    {
+        case NUJ_STRING_TYPE:
+        {
+            size = sizeof(NUJString);
+
+            if (!(parser->flags & NUJ_PARSE_VIEWS))
+            {
+                size += token.length + 1;
+            }
+        }
+        break;
+        case NUJ_NUMBER_TYPE:
+        {
+            size = sizeof(NUJInteger);
+        }
+        break;
+        case NUJ_DOUBLE_TYPE:
+        {
+            size = sizeof(NUJDouble);
+        }
+        break;
+        case NUJ_BOOLEAN_TYPE:
+        {
+            size = sizeof(NUJBoolean);
+        }
+        break;
+        case NUJ_NULL_TYPE:
+        {
+            size = sizeof(NUJNull);
+        }
+        break;
+        case NUJ_OBRACE_TYPE:
+        case NUJ_OBRACKET_TYPE:
+        {
+            int in_object = token.type == NUJ_OBRACE_TYPE;
+            unsigned int close_token_type = in_object ? NUJ_CBRACE_TYPE : NUJ_CBRACKET_TYPE;
+            unsigned int element_count = 0;
+            int done = nuj__parse_match_empty_element(parser, close_token_type);
+
+            size = sizeof(NUJObject);
+
+            while (!done)
+            {
+                unsigned long long element_size = 0;
+
+                token = nuj__parse_get_token(parser);
+
+                if (in_object)
+                {
+                    if (nuj__parse_match_token(token, NUJ_STRING_TYPE) &&
+                        nuj__parse_match_token(nuj__parse_get_token(parser), NUJ_COLON_TYPE))
+                    {
+                        if (!(parser->flags & NUJ_PARSE_VIEWS))
+                        {
+                            size += token.length + 1;
+                        }
+
+                        token = nuj__parse_get_token(parser);
+                    }
+                    else
+                    {
+                        token.type = NUJ_UNKNOWN_TYPE;
+                    }
+                }
+
+                element_size = nuj__measure_element(parser, token);
+                token = nuj__parse_get_token(parser);
+
+                if (!element_size || (token.type != NUJ_COMMA_TYPE && token.type != close_token_type))
+                {
+                    return 0;
+                }
+
+                size += element_size + sizeof(NUJElement*);
+                ++element_count;
+                done = token.type == close_token_type;
+            }
+
+            if (in_object && (parser->flags & NUJ_PARSE_INDEX_KEYS) && element_count >= NUJ_KEY_INDEX_MIN_COUNT)
+            {
+                size += nuj__get_key_index_size(element_count);
+            }
+        }
+        break;
+    }
+
+    return size;
+}
+
+// NOTE: Pre-allocated buffer by size.
+static void nuj__count_document_element(const NUJElement* element, unsigned long long* node_count, unsigned long long* string_size)
+{
+    ++*node_count;
+
+    if (element->name)
+    {
+        *string_size += element->name_length + 1;
+    }
+
+    if (element->type == NUJString_TYPE)
+    {
+        *string_size += NUJ_CSTRING(element)->length + 1;
+    }
+    else if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    {
+        unsigned int i = 0;
+
+        for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
+        {
+            nuj__count_document_element(NUJ_COBJECT(element)->children[i], node_count, string_size);
+        }
+    }
+}
+
+static unsigned int nuj__add_document_string(NUJDocument* document, unsigned int* string_used, const char* string, unsigned int length)
+{
+    unsigned int offset = *string_used;
+    char* strings = nuj__get_document_strings(document);
+
+    memcpy(strings + offset, string, length);
+    strings[offset + length] = '\0';
+    *string_used += length + 1;
+
+    return offset;
+}
+
+// NOTE: Children get their node range before any of them is filled,
+// so the children of every container are consecutive.
+static void nuj__fill_document_node(NUJDocument* document, unsigned int node, unsigned int parent, const NUJElement* element, unsigned int* next_node, unsigned int* string_used)
+{
+    NUJNode* nuj_node = nuj__get_document_nodes(document) + node;
+
+    nuj_node->tag = element->type;
+    nuj_node->name = 0;
+    nuj_node->value.integer = 0;
+
+    if (element->name)
+    {
+        NUJ_ASSERT(element->name_length < (1u << (32 - NUJ_NODE_NAME_SHIFT)));
+
+        nuj_node->tag |= NUJ_NODE_HAS_NAME | (element->name_length << NUJ_NODE_NAME_SHIFT);
+        nuj_node->name = nuj__add_document_string(document, string_used, element->name, element->name_length);
+    }
+
+    if (document->flags & NUJ_DOCUMENT_PARENTS)
+    {
+        nuj__get_document_parents(document)[node] = parent;
+    }
+
+    switch (element->type)
+    {
+        case NUJString_TYPE:
+        {
+            nuj_node->value.string.length = NUJ_CSTRING(element)->length;
+            nuj_node->value.string.offset = nuj__add_document_string(document, string_used, NUJ_CSTRING(element)->value, NUJ_CSTRING(element)->length);
+        }
+        break;
+        case NUJInteger_TYPE:
+        case NUJBoolean_TYPE:
+        case NUJNull_TYPE:
+        {
+            nuj_node->value.integer = NUJ_CINTEGER(element)->value;
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            nuj_node->value.number = NUJ_CDOUBLE(element)->value;
+        }
+        break;
+        case NUJObject_TYPE:
+        case NUJArray_TYPE:
+        {
+            unsigned int child_count = NUJ_COBJECT(element)->child_count;
+            unsigned int first = *next_node;
+            unsigned int i = 0;
+
+            nuj_node->value.children.first = first;
+            nuj_node->value.children.count = child_count;
+            *next_node += child_count;
+
+            for (i = 0; i < child_count; ++i)
+            {
+                nuj__fill_document_node(document, first + i, node, NUJ_COBJECT(element)->children[i], next_node, string_used);
+            }
+        }
+        break;
+    }
+}
+
+static inline NUJNode* nuj__get_document_nodes(const NUJDocument* document)
+{
+    return (NUJNode*)(document + 1);
+}
+
+static inline unsigned int* nuj__get_document_parents(const NUJDocument* document)
+{
+    return (unsigned int*)(nuj__get_document_nodes(document) + document->node_count);
+}
+
+static inline char* nuj__get_document_strings(const NUJDocument* document)
+{
+    char* strings = (char*)(nuj__get_document_nodes(document) + document->node_count);
+
+    if (document->flags & NUJ_DOCUMENT_PARENTS)
+    {
+        strings += document->node_count * sizeof(unsigned int);
+    }
+
+    return strings;
+}
+
+// NOTE: Makes room for word_count more words and string_size more
+// bytes of strings.  What is short is doubled, or grown by just what is
+// needed if the handle has no room for that.  Returns 0 if the handle
+// is full or the tape would reach 4 GB, pushes are 32 bit.
+static int nuj__tape_reserve(NUJTapeWriter* writer, unsigned long long word_count, unsigned long long string_size)
+{
+    NUJTape* tape = 0;
+    unsigned long long size = sizeof(NUJTape) + writer->max_word_count * sizeof(unsigned long long) + writer->max_string_size;
+    unsigned long long max_word_count = writer->max_word_count;
+    unsigned long long max_string_size = writer->max_string_size;
+    int exact = 0;
+
+    word_count += writer->word_count;
+    string_size += writer->string_size;
+
+    if (word_count <= max_word_count && string_size <= max_string_size)
+    {
+        return 1;
+    }
+
+    for (exact = 0; !tape && exact < 2; ++exact)
+    {
+        unsigned long long new_size = 0;
+
+        if (word_count > writer->max_word_count)
+        {
+            max_word_count = !exact && writer->max_word_count * 2 > word_count ? writer->max_word_count * 2 : word_count;
+        }
+
+        if (string_size > writer->max_string_size)
+        {
+            max_string_size = !exact && writer->max_string_size * 2 > string_size ? writer->max_string_size * 2 : string_size;
+        }
+
+        new_size = sizeof(NUJTape) + max_word_count * sizeof(unsigned long long) + max_string_size;
+
+        if (new_size < 0xFFFFFFFFULL)
+        {
+            tape = (NUJTape*)nuj__grow_size(writer->handle, writer->tape, (unsigned int)size, (unsigned int)(new_size - size));
+        }
+    }
+
+    if (tape)
+    {
+        if (max_word_count != writer->max_word_count)
+        {
+            memmove(nuj__get_tape_words(tape) + max_word_count, nuj__get_tape_strings(tape), writer->string_size);
+        }
+
+        tape->word_count = max_word_count;
+        writer->tape = tape;
+        writer->max_word_count = max_word_count;
+        writer->max_string_size = max_string_size;
+    }
+
+    return tape != 0;
+}
+
+// NOTE: Returns the words, 0 if the handle is full.
+static inline unsigned long long* nuj__tape_add_words(NUJTapeWriter* writer, unsigned int count)
+{
+    unsigned long long* words = 0;
+
+    if (nuj__tape_reserve(writer, count, 0))
+    {
+        words = nuj__get_tape_words(writer->tape) + writer->word_count;
+        writer->word_count += count;
+    }
+
+    return words;
+}
+
+static inline int nuj__tape_add_string(NUJTapeWriter* writer, unsigned char tag, NUJToken token)
+{
+    unsigned long long size = sizeof(token.length) + token.length + 1;
+    int result = nuj__tape_reserve(writer, 1, size);
+
+    if (result)
+    {
+        char* string = nuj__get_tape_strings(writer->tape) + writer->string_size;
+
+        nuj__get_tape_words(writer->tape)[writer->word_count++] = NUJ_TAPE_WORD(tag, writer->string_size);
+        memcpy(string, &token.length, sizeof(token.length));
+        memcpy(string + sizeof(token.length), token.start, token.length);
+        string[sizeof(token.length) + token.length] = '\0';
+        writer->string_size += size;
+    }
+
+    return result;
+}
+
+// NOTE: Returns 0 on syntax error or if the handle is full.
+static int nuj__tape_element(NUJParser* parser, NUJToken token, NUJTapeWriter* writer)
+{
+    unsigned long long* words = 0;
+    int result = 1;
+
+    switch (token.type)
+    {
+        case NUJ_STRING_TYPE:
+        {
+            result = nuj__tape_add_string(writer, '"', token);
+        }
+        break;
+        case NUJ_NUMBER_TYPE:
+        case NUJ_DOUBLE_TYPE:
+        {
+            long long integer = 0;
+            double number = 0;
+
+            words = nuj__tape_add_words(writer, 2);
+            result = words != 0;
+
+            if (words && nuj__parse_token_to_number(token, &integer, &number))
+            {
+                words[0] = NUJ_TAPE_WORD('l', 0);
+                memcpy(&words[1], &integer, sizeof(integer));
+            }
+            else if (words)
+            {
+                words[0] = NUJ_TAPE_WORD('d', 0);
+                memcpy(&words[1], &number, sizeof(number));
+            }
+        }
+        break;
+        case NUJ_BOOLEAN_TYPE:
+        case NUJ_NULL_TYPE:
+        {
+            words = nuj__tape_add_words(writer, 1);
+            result = words != 0;
+
+            if (words)
+            {
+                words[0] = NUJ_TAPE_WORD(token.type == NUJ_NULL_TYPE ? 'n' : token.start ? 't' : 'f', 0);
+            }
+        }
+        break;
+        case NUJ_OBRACE_TYPE:
+        case NUJ_OBRACKET_TYPE:
+        {
+            int in_object = token.type == NUJ_OBRACE_TYPE;
+            unsigned int close_token_type = in_object ? NUJ_CBRACE_TYPE : NUJ_CBRACKET_TYPE;
+            unsigned long long open = writer->word_count;
+            unsigned int child_count = 0;
+            int done = 0;
+
+            if (!nuj__tape_add_words(writer, 1))
+            {
+                return 0;
+            }
+
+            done = nuj__parse_match_empty_element(parser, close_token_type);
+
+            while (!done)
+            {
+                token = nuj__parse_get_token(parser);
+
+                if (in_object)
+                {
+                    if (nuj__parse_match_token(token, NUJ_STRING_TYPE) &&
+                        nuj__parse_match_token(nuj__parse_get_token(parser), NUJ_COLON_TYPE) &&
+                        nuj__tape_add_string(writer, 'k', token))
+                    {
+                        token = nuj__parse_get_token(parser);
+                    }
+                    else
+                    {
+                        return 0;
+                    }
+                }
+
+                if (!nuj__tape_element(parser, token, writer))
+                {
+                    return 0;
+                }
+
+                token = nuj__parse_get_token(parser);
+
+                if (token.type != NUJ_COMMA_TYPE && token.type != close_token_type)
+                {
+                    return 0;
+                }
+
+                child_count += child_count < NUJ_TAPE_MAX_CHILD_COUNT;
+                done = token.type == close_token_type;
+            }
+
+            words = nuj__tape_add_words(writer, 1);
+
+            if (!words)
+            {
+                return 0;
+            }
+
+            words[0] = NUJ_TAPE_WORD(in_object ? '}' : ']', open);
+            nuj__get_tape_words(writer->tape)[open] = NUJ_TAPE_WORD(in_object ? '{' : '[', ((unsigned long long)child_count << 32) | (writer->word_count - 1));
+        }
+        break;
+        default:
+        {
+            result = 0;
+        }
+        break;
+    }
+
+    return result;
+}
+
+static inline unsigned long long* nuj__get_tape_words(const NUJTape* tape)
+{
+    return (unsigned long long*)(tape + 1);
+}
+
+static inline char* nuj__get_tape_strings(const NUJTape* tape)
+{
+    return (char*)(nuj__get_tape_words(tape) + tape->word_count);
+}
+
+static inline const char* nuj__get_tape_word_string(const NUJTape* tape, unsigned long long word, unsigned int* length)
+{
+    const char* string = nuj__get_tape_strings(tape) + NUJ_TAPE_PAYLOAD(word);
+
+    if (length)
+    {
+        memcpy(length, string, sizeof(*length));
+    }
+
+    return string + sizeof(*length);
+}
+
+// NOTE: Returns the start of the next line.  JSON strings can't hold
+// a raw newline, so every newline ends a record.
+static inline const unsigned char* nuj__next_line(const unsigned char* current, const unsigned char* end, int* is_blank)
+{
+    const unsigned char* line_end = (const unsigned char*)memchr(current, '\n', (size_t)(end - current));
+
+    if (!line_end)
+    {
+        line_end = end;
+    }
+
+    while (current < line_end && nuj__parse_is_whitespace_char((char)*current))
+    {
+        ++current;
+    }
+
+    *is_blank = current == line_end;
+
+    return line_end < end ? line_end + 1 : end;
+}
+
+// NOTE: Any value is accepted as a record, returns 0 if it is invalid.
+static NUJElement* nuj__parse_record(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags)
+{
+    NUJ_STATS_BEGIN(start_cycles)
+    NUJParser parser = NUJ_ZERO;
+    NUJElement* element = 0;
+
+    nuj__parse_init(&parser, buffer, buffer_size);
+    parser.flags = flags | NUJ_PARSE_SOFT_ERRORS;
+    NUJ_STATS_ATTACH(&parser, handle);
+
+    element = nuj__parse_element_pair_value(handle, &parser);
+
+    if (!nuj__parse_match_token(nuj__parse_get_token(&parser), NUJ_EOF_TYPE) || parser.failed)
+    {
+        element = 0;
+    }
+
+    NUJ_STATS_PARSED(&parser, start_cycles);
+
+    return element;
+}
+
+static void nuj__count_lines_worker(void* lines_worker)
+{
+    NUJLinesWorker* worker = (NUJLinesWorker*)lines_worker;
+    const unsigned char* current = worker->start;
+    int is_blank = 0;
+
+    worker->record_count = 0;
+
+    while (current < worker->end)
+    {
+        current = nuj__next_line(current, worker->end, &is_blank);
+        worker->record_count += !is_blank;
+    }
+}
+
+static void nuj__parse_lines_worker(void* lines_worker)
+{
+    NUJLinesWorker* worker = (NUJLinesWorker*)lines_worker;
+    const unsigned char* current = worker->start;
+    unsigned long long record_index = 0;
+    int is_blank = 0;
+
+    worker->parsed_end = worker->start;
+
+    while (current < worker->end && record_index < worker->root_count)
+    {
+        const unsigned char* line = current;
+
+        current = nuj__next_line(current, worker->end, &is_blank);
+
+        if (!is_blank)
+        {
+            worker->roots[worker->root_offset + record_index++] = nuj__parse_record(worker->handle, line, (unsigned long long)(current - line), worker->flags);
+            worker->parsed_end = current;
+        }
+    }
+}
+
+#if defined(NUJ_PTHREADS)
+static void* nuj__worker_thread(void* thread)
+{
+    ((NUJThread*)thread)->func(((NUJThread*)thread)->worker);
+
+    return 0;
+}
+#elif defined(NUJ_WIN32_THREADS)
+static DWORD WINAPI nuj__worker_thread(LPVOID thread)
+{
+    ((NUJThread*)thread)->func(((NUJThread*)thread)->worker);
+
+    return 0;
+}
+#endif
+
+// NOTE: Calls func for each of the worker_count workers, which are
+// worker_size bytes apart.  Worker 0 runs on the calling thread.  If a
+// thread can't be started its worker runs on the calling thread too.
+static void nuj__run_workers(void* workers, unsigned int worker_size, unsigned int worker_count, NUJWorkerFunc* func)
+{
+    unsigned int i = 0;
+#if defined(NUJ_PTHREADS)
+    NUJThread thread_workers[NUJ_MAX_THREAD_COUNT];
+    pthread_t threads[NUJ_MAX_THREAD_COUNT];
+    int started[NUJ_MAX_THREAD_COUNT] = { 0 };
+#elif defined(NUJ_WIN32_THREADS)
+    NUJThread thread_workers[NUJ_MAX_THREAD_COUNT];
+    HANDLE threads[NUJ_MAX_THREAD_COUNT] = { 0 };
+#endif
+
+    NUJ_ASSERT(worker_count <= NUJ_MAX_THREAD_COUNT);
+
+    for (i = 1; i < worker_count; ++i)
+    {
+        void* worker = (unsigned char*)workers + (unsigned long long)worker_size * i;
+
+#if defined(NUJ_PTHREADS)
+        thread_workers[i].func = func;
+        thread_workers[i].worker = worker;
+        started[i] = !pthread_create(&threads[i], 0, nuj__worker_thread, &thread_workers[i]);
+
+        if (!started[i])
+#elif defined(NUJ_WIN32_THREADS)
+        thread_workers[i].func = func;
+        thread_workers[i].worker = worker;
+        threads[i] = CreateThread(0, 0, nuj__worker_thread, &thread_workers[i], 0, 0);
+
+        if (!threads[i])
+#endif
+        {
+            func(worker);
+        }
+    }
+
+    if (worker_count)
+    {
+        func(workers);
+    }
+
+    for (i = 1; i < worker_count; ++i)
+    {
+#if defined(NUJ_PTHREADS)
+        if (started[i])
+        {
+            pthread_join(threads[i], 0);
+        }
+#elif defined(NUJ_WIN32_THREADS)
+        if (threads[i])
+        {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+#endif
+    }
+}
+
+// NOTE: Without consumed_size the last line doesn't need a newline.
+// With it only whole lines are parsed and consumed_size is where the
+// next call should continue.
+static unsigned long long nuj__parse_lines(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count, unsigned long long* consumed_size)
+{
+    NUJLinesWorker workers[NUJ_MAX_THREAD_COUNT];
+    const unsigned char* start = buffer;
+    const unsigned char* end = buffer + buffer_size;
+    const unsigned char* previous = buffer;
+    unsigned long long record_count = 0;
+    unsigned int worker_count = handle_count < NUJ_MAX_THREAD_COUNT ? handle_count : NUJ_MAX_THREAD_COUNT;
+    unsigned int i = 0;
+
+    NUJ_ASSERT(worker_count);
+    NUJ_ASSERT(nuj__can_share_intern_tables(handles, handle_count));
+
+    if (consumed_size)
+    {
+        while (end > start && end[-1] != '\n')
+        {
+            --end;
+        }
+    }
+
+    // NOTE: Ranges are split evenly and moved forward to line starts.
+    for (i = 0; i < worker_count; ++i)
+    {
+        const unsigned char* range_end = i + 1 < worker_count ? start + (unsigned long long)(end - start) / worker_count * (i + 1) : end;
+
+        if (range_end < previous)
+        {
+            range_end = previous;
+        }
+        else if (range_end > start && range_end < end && range_end[-1] != '\n')
+        {
+            const unsigned char* newline = (const unsigned char*)memchr(range_end, '\n', (size_t)(end - range_end));
+
+            range_end = newline ? newline + 1 : end;
+        }
+
+        workers[i].handle = handles[i];
+        workers[i].start = previous;
+        workers[i].end = range_end;
+        workers[i].flags = flags;
+        workers[i].roots = roots;
+        previous = range_end;
+    }
+
+    nuj__run_workers(workers, sizeof(*workers), worker_count, nuj__count_lines_worker);
+
+    for (i = 0; i < worker_count; ++i)
+    {
+        unsigned long long available = record_count < root_count ? root_count - record_count : 0;
+
+        workers[i].root_offset = record_count;
+        workers[i].root_count = workers[i].record_count < available ? workers[i].record_count : available;
+        record_count += workers[i].root_count;
+    }
+
+    nuj__run_workers(workers, sizeof(*workers), worker_count, nuj__parse_lines_worker);
+
+    if (consumed_size)
+    {
+        *consumed_size = (unsigned long long)(end - buffer);
+
+        for (i = 0; i < worker_count; ++i)
+        {
+            if (workers[i].root_count < workers[i].record_count)
+            {
+                *consumed_size = (unsigned long long)(workers[i].parsed_end - buffer);
+                break;
+            }
+        }
+    }
+
+    return record_count;
+}
+
+// NOTE: A quote is escaped if an odd number of backslashes precede it.
+static inline int nuj__is_escaped(const unsigned char* begin, const unsigned char* quote)
+{
+    const unsigned char* current = quote;
+
+    while (current > begin && current[-1] == '\\')
+    {
+        --current;
+    }
+
+    return (quote - current) & 1;
+}
+
+// NOTE: Returns a comma that is likely to separate two children of the
+// root, or 0.  start can be anywhere, even inside a string, so this is
+// a guess that nuj_parse_parallel checks by parsing.  Quotes inside
+// strings are escaped, so every other quote opens or closes one.  An
+// opening quote follows one of {[,: and a closing quote is followed by
+// one of :,}] so the first quote that fits only one of them tells
+// whether start is inside a string.  Then the first comma at the
+// lowest depth seen before end is taken, but only if that depth is
+// below the one at start.  Without that, start may be inside a child
+// longer than the scan and its commas look like the root's, which
+// makes the slice fail and nuj_parse_parallel parse everything again
+// on one thread.  This can still happen if start is nested deeper than
+// the lowest depth seen.
+static const unsigned char* nuj__find_split(const unsigned char* begin, const unsigned char* start, const unsigned char* end)
+{
+    const unsigned char* current = 0;
+    const unsigned char* split = 0;
+    unsigned int quote_count = 0;
+    int in_string = 0;
+    int depth = 0;
+    int min_depth = 0;
+
+    for (current = start; current < end; ++current)
+    {
+        if (*current == '\"' && !nuj__is_escaped(begin, current))
+        {
+            const unsigned char* previous = current;
+            const unsigned char* next = current + 1;
+            int can_open = 0;
+            int can_close = 0;
+
+            while (previous > begin && nuj__parse_is_whitespace_char((char)previous[-1]))
+            {
+                --previous;
+            }
+
+            while (next < end && nuj__parse_is_whitespace_char((char)*next))
+            {
+                ++next;
+            }
+
+            can_open = previous > begin && memchr("{[,:", previous[-1], 4);
+            can_close = next < end && memchr(":,}]", *next, 4);
+
+            if (can_open != can_close)
+            {
+                in_string = (int)(quote_count & 1) ^ can_close;
+                break;
+            }
+
+            ++quote_count;
+        }
+    }
+
+    for (current = start; current < end; ++current)
+    {
+        unsigned char character = *current;
+
+        if (character == '\"')
+        {
+            in_string ^= !nuj__is_escaped(begin, current);
+        }
+        else if (!in_string)
+        {
+            if (character == '{' || character == '[')
+            {
+                ++depth;
+            }
+            else if (character == '}' || character == ']')
+            {
+                if (--depth < min_depth)
+                {
+                    min_depth = depth;
+                    split = 0;
+                }
+            }
+            else if (character == ',' && depth == min_depth && !split)
+            {
+                split = current;
+            }
+        }
+    }
+
+    return min_depth < 0 ? split : 0;
+}
+
+static void nuj__split_slice_worker(void* slice_worker)
+{
+    NUJSliceWorker* worker = (NUJSliceWorker*)slice_worker;
+    const unsigned char* split = nuj__find_split(worker->begin, worker->start, worker->scan_end);
+
+    worker->start = split ? split + 1 : 0;
+}
+
+// NOTE: The slice must end right before a comma between children of the
+// root, or at its closing token.  Soft errors, because a wrong split
+// can start the slice anywhere.
+static void nuj__parse_slice_worker(void* slice_worker)
+{
+    NUJ_STATS_BEGIN(start_cycles)
+    NUJSliceWorker* worker = (NUJSliceWorker*)slice_worker;
+    NUJParser parser = NUJ_ZERO;
+    NUJToken token = NUJ_ZERO;
+    int done = 0;
+
+    worker->last_element = 0;
+    worker->element_count = 0;
+    worker->failed = worker->start >= worker->end;
+
+    if (!worker->failed)
+    {
+        nuj__parse_init(&parser, worker->start, (unsigned long long)(worker->end - worker->start));
+        parser.flags = worker->flags | NUJ_PARSE_SOFT_ERRORS;
+        NUJ_STATS_ATTACH(&parser, worker->handle);
+
+        while (!done)
+        {
+            worker->element_count += nuj__parse_link_element(nuj__parse_element_pair(worker->handle, &parser, worker->in_object), &worker->last_element);
+
+            token = nuj__parse_get_token(&parser);
+
+            if (!nuj__parse_match_token(token, NUJ_COMMA_TYPE))
+            {
+                if (!nuj__parse_match_token(token, NUJ_EOF_TYPE))
+                {
+                    nuj__parse_error(&parser, token, ',');
+                }
+
+                done = 1;
+            }
+        }
+
+        worker->failed = parser.failed;
+        NUJ_STATS_PARSED(&parser, start_cycles);
+    }
+}
+
+NUJDEF NUJHandle nuj_init(void* memory, unsigned long long size)
+{
+    NUJHandle nuj_handle = (NUJHandle)memory;
+
+    memset(nuj_handle, 0, sizeof(NUJHandleInternal));
+    nuj_handle->buffer = (unsigned char*)memory + sizeof(NUJHandleInternal);
+    nuj_handle->buffer_used = sizeof(NUJHandleInternal);
+    nuj_handle->buffer_size = size - sizeof(NUJHandleInternal);
+
+    return nuj_handle;
+}
+
+// NOTE: Handle grows by allocating new blocks, each one twice the size
+// of the previous one, until max_size bytes are allocated in total.
+// max_size of 0 means there is no limit.  Elements never move, because
+// the blocks are only released by nuj_reset_used_size and nuj_release.
+// Once max_size is reached, or alloc returns 0, the handle is full:
+// the last block is made as large as the cap allows, then pushes that
+// don't fit fail.  Parses return 0 then, whatever their flags, and so
+// do nuj_create_element and the other functions that push.  What was
+// pushed before stays until the handle is reset.  A handle from
+// nuj_init is full when its memory is.
+NUJDEF NUJHandle nuj_init_chained(NUJAllocFunc* alloc, NUJFreeFunc* free, void* user_data, unsigned long long block_size, unsigned long long max_size)
+{
+    NUJHandle nuj_handle = 0;
+
+    NUJ_ASSERT(alloc && free && block_size > sizeof(NUJHandleInternal));
+    NUJ_ASSERT(!max_size || max_size >= block_size);
+
+    nuj_handle = (NUJHandle)alloc(user_data, block_size);
+    NUJ_ASSERT(nuj_handle);
+
+    memset(nuj_handle, 0, sizeof(NUJHandleInternal));
+    nuj_handle->buffer = (unsigned char*)nuj_handle + sizeof(NUJHandleInternal);
+    nuj_handle->buffer_size = block_size - sizeof(NUJHandleInternal);
+    nuj_handle->alloc = alloc;
+    nuj_handle->free = free;
+    nuj_handle->user_data = user_data;
+    nuj_handle->first_block_size = block_size;
+    nuj_handle->last_block_size = block_size;
+    nuj_handle->total_size = block_size;
+    nuj_handle->max_size = max_size;
+
+    return nuj_handle;
+}
+
+// NOTE: Alloc and free functions for nuj_init_chained that back the
+// blocks with huge pages where the system allows it, so large arenas
+// take fewer page faults and TLB misses.  On Linux the blocks are
+// aligned to NUJ_HUGE_PAGE_SIZE and advised as MADV_HUGEPAGE, on
+// Windows large pages are used if the process may lock pages.
+// Otherwise these are plain page allocations, or malloc without mmap.
+NUJDEF void* nuj_alloc_huge_pages(void* user_data, unsigned long long size)
+{
+    void* memory = 0;
+    unsigned long long huge_size = (size + NUJ_HUGE_PAGE_SIZE - 1) / NUJ_HUGE_PAGE_SIZE * NUJ_HUGE_PAGE_SIZE;
+
+    (void)user_data;
+    (void)huge_size;
+
+#if defined(NUJ_POSIX_MMAP) && defined(MAP_ANONYMOUS)
+    {
+        unsigned char* mapped = (unsigned char*)mmap(0, (size_t)(huge_size + NUJ_HUGE_PAGE_SIZE), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mapped != MAP_FAILED)
+        {
+            unsigned char* aligned = (unsigned char*)(((size_t)mapped + NUJ_HUGE_PAGE_SIZE - 1) / NUJ_HUGE_PAGE_SIZE * NUJ_HUGE_PAGE_SIZE);
+
+            // NOTE: The unaligned head and the tail are given back.
+            if (aligned > mapped)
+            {
+                munmap(mapped, (size_t)(aligned - mapped));
+            }
+
+            if (mapped + NUJ_HUGE_PAGE_SIZE > aligned)
+            {
+                munmap(aligned + huge_size, (size_t)(mapped + NUJ_HUGE_PAGE_SIZE - aligned));
+            }
+
+#if defined(MADV_HUGEPAGE)
+            madvise(aligned, (size_t)huge_size, MADV_HUGEPAGE);
+#endif
+            memory = aligned;
+        }
+    }
+#elif defined(NUJ_WIN32_MMAP)
+    {
+        SIZE_T large_page_size = GetLargePageMinimum();
+
+        if (large_page_size && !(size % large_page_size))
+        {
+            memory = VirtualAlloc(0, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+
+        if (!memory)
+        {
+            memory = VirtualAlloc(0, (SIZE_T)size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+    }
+#elif !defined(NUJ_NO_STDLIB)
+    memory = malloc((size_t)size);
+#endif
+
+    return memory;
+}
+
+NUJDEF void nuj_free_huge_pages(void* user_data, void* memory, unsigned long long size)
+{
+    (void)user_data;
+    (void)size;
+
+#if defined(NUJ_POSIX_MMAP) && defined(MAP_ANONYMOUS)
+    munmap(memory, (size_t)((size + NUJ_HUGE_PAGE_SIZE - 1) / NUJ_HUGE_PAGE_SIZE * NUJ_HUGE_PAGE_SIZE));
+#elif defined(NUJ_WIN32_MMAP)
+    VirtualFree(memory, 0, MEM_RELEASE);
+#elif !defined(NUJ_NO_STDLIB)
+    free(memory);
+#endif
+}
+
+// NOTE: Frees all blocks of a chained handle including the handle
+// itself.  Does nothing for handles created by nuj_init.
+NUJDEF void nuj_release(NUJHandle handle)
+{
+    if (handle && handle->alloc)
+    {
+        nuj_reset_used_size(handle);
+        handle->free(handle->user_data, handle, handle->first_block_size);
+    }
+}
+
+// NOTE: Chained handles keep their first block and free the rest.
+NUJDEF void nuj_reset_used_size(NUJHandle handle)
+{
+    while (handle->blocks)
+    {
+        NUJBlock* block = handle->blocks;
+
+        handle->blocks = block->next;
+        handle->free(handle->user_data, block, block->size);
+    }
+
+    if (handle->alloc)
+    {
+        handle->buffer = (unsigned char*)handle + sizeof(NUJHandleInternal);
+        handle->buffer_size = handle->first_block_size - sizeof(NUJHandleInternal);
+        handle->last_block_size = handle->first_block_size;
+        handle->total_size = handle->first_block_size;
+        handle->used_before = 0;
+    }
+
+    handle->buffer_used = 0;
+    memset(handle->free_lists, 0, sizeof(handle->free_lists));
+    handle->free_count = 0;
+}
+
+NUJDEF unsigned long long nuj_get_used_size(const NUJHandle handle)
+{
+    return handle->used_before + handle->buffer_used;
+}
+
+// NOTE: Minimum memory size for nuj_init to have used_size bytes available.
+NUJDEF unsigned long long nuj_get_init_size(unsigned long long used_size)
+{
+    return sizeof(NUJHandleInternal) + used_size + 1;
+}
+
+// NOTE: Copies the counters of handle to stats.  Returns 0 and zeroes
+// stats if they are not compiled in (NUJ_STATS).
+NUJDEF int nuj_get_stats(const NUJHandle handle, NUJStats* stats)
+{
+#ifdef NUJ_STATS
+    *stats = handle->stats;
+
+    return 1;
+#else
+    (void)handle;
+    memset(stats, 0, sizeof(*stats));
+
+    return 0;
+#endif
+}
+
+NUJDEF void nuj_reset_stats(NUJHandle handle)
+{
+#ifdef NUJ_STATS
+    memset(&handle->stats, 0, sizeof(handle->stats));
+#else
+    (void)handle;
+#endif
+}
+
+// NOTE: The nuj_create_element functions return 0 if the handle is
+// full, see nuj_init_chained.
+NUJDEF NUJElement* nuj_create_element(NUJHandle handle, unsigned int type, unsigned int size)
+{
+    NUJElement* element = (NUJElement*)nuj__alloc_size(handle, size);
+
+    if (element)
+    {
+        element->type = type;
+        element->name_length = 0;
+        element->name = 0;
+        element->parent = 0;
+        NUJ_STATS_ADD(&handle->stats, element_counts[type < NUJ_STATS_ELEMENT_TYPE_COUNT ? type : (unsigned int)NUJNone_TYPE], 1);
+    }
+
+    return element;
+}
+
+NUJDEF NUJElement* nuj_create_element_string(NUJHandle handle, const char* string)
+{
+    NUJString* nuj_string = NUJ_CREATE_ELEMENT(handle, NUJString);
+
+    if (nuj_string)
+    {
+        nuj_string->value = string;
+        nuj_string->length = string ? (unsigned int)strlen(string) : 0;
+    }
+
+    return (NUJElement*)nuj_string;
+}
+
+NUJDEF NUJElement* nuj_create_element_integer(NUJHandle handle, long long value)
+{
+    NUJInteger* nuj_integer = NUJ_CREATE_ELEMENT(handle, NUJInteger);
+
+    if (nuj_integer)
+    {
+        nuj_integer->value = value;
+    }
+
+    return (NUJElement*)nuj_integer;
+}
+
+NUJDEF NUJElement* nuj_create_element_double(NUJHandle handle, double value)
+{
+    NUJDouble* nuj_double = NUJ_CREATE_ELEMENT(handle, NUJDouble);
+
+    if (nuj_double)
+    {
+        nuj_double->value = value;
+    }
+
+    return (NUJElement*)nuj_double;
+}
+
+NUJDEF NUJElement* nuj_create_element_boolean(NUJHandle handle, int value)
+{
+    NUJBoolean* nuj_boolean = NUJ_CREATE_ELEMENT(handle, NUJBoolean);
+
+    if (nuj_boolean)
+    {
+        nuj_boolean->value = value;
+    }
+
+    return (NUJElement*)nuj_boolean;
+}
+
+NUJDEF NUJElement* nuj_create_element_null(NUJHandle handle)
+{
+    NUJNull* nuj_null = NUJ_CREATE_ELEMENT(handle, NUJNull);
+
+    if (nuj_null)
+    {
+        nuj_null->value = 0;
+    }
+
+    return (NUJElement*)nuj_null;
+}
+
+NUJDEF NUJElement* nuj_create_element_object(NUJHandle handle, unsigned int element_count)
+{
+    NUJObject* nuj_object = NUJ_CREATE_ELEMENT(handle, NUJObject);
+
+    if (nuj_object)
+    {
+        nuj_object->child_count = 0;
+        nuj_object->max_child_count = element_count;
+        nuj_object->index = 0;
+        nuj_object->children = (NUJElement**)nuj__alloc_size(handle, element_count * sizeof(NUJElement*));
+
+        if (!nuj_object->children)
+        {
+            nuj__free_size(handle, nuj_object, sizeof(NUJObject));
+            nuj_object = 0;
+        }
+    }
+
+    return (NUJElement*)nuj_object;
+}
+
+NUJDEF NUJElement* nuj_create_element_array(NUJHandle handle, unsigned int element_count)
+{
+    NUJArray* nuj_array = NUJ_CREATE_ELEMENT(handle, NUJArray);
+
+    if (nuj_array)
+    {
+        nuj_array->child_count = 0;
+        nuj_array->max_child_count = element_count;
+        nuj_array->index = 0;
+        nuj_array->children = (NUJElement**)nuj__alloc_size(handle, element_count * sizeof(NUJElement*));
+
+        if (!nuj_array->children)
+        {
+            nuj__free_size(handle, nuj_array, sizeof(NUJArray));
+            nuj_array = 0;
+        }
+    }
+
+    return (NUJElement*)nuj_array;
+}
+
+NUJDEF NUJElement* nuj_add_element_element(NUJElement* element, const char* name, NUJElement* child)
+{
+    NUJObject* nuj_object = 0;
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+
+    nuj_object = NUJ_OBJECT(element);
+
+    NUJ_ASSERT(nuj_object->child_count < nuj_object->max_child_count);
+
+    child->name = name;
+    child->name_length = name ? (unsigned int)strlen(name) : 0;
+    nuj_object->children[nuj_object->child_count++] = child;
+    nuj_object->index = 0;
+
+    if (!child->parent)
+    {
+        child->parent = element;
+    }
+
+    return child;
+}
+
+static unsigned int nuj__get_element_size(unsigned int type)
+{
+    unsigned int size = 0;
+
+    switch (type)
+    {
+        case NUJString_TYPE:  { size = sizeof(NUJString);  } break;
+        case NUJInteger_TYPE: { size = sizeof(NUJInteger); } break;
+        case NUJDouble_TYPE:  { size = sizeof(NUJDouble);  } break;
+        case NUJBoolean_TYPE: { size = sizeof(NUJBoolean); } break;
+        case NUJNull_TYPE:    { size = sizeof(NUJNull);    } break;
+        case NUJArray_TYPE:   { size = sizeof(NUJArray);   } break;
+        case NUJObject_TYPE:  { size = sizeof(NUJObject);  } break;
+    }
+
+    return size;
+}
+
+// NOTE: Frees element, its children arrays and key indexes and all of
+// its descendants.  Names and strings are left, they can be views or
+// interned.
+static void nuj__free_element(NUJHandle handle, NUJElement* element)
+{
+    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    {
+        NUJObject* nuj_object = NUJ_OBJECT(element);
+        unsigned int i = 0;
+
+        for (i = 0; i < nuj_object->child_count; ++i)
+        {
+            nuj__free_element(handle, nuj_object->children[i]);
+        }
+
+        nuj__drop_key_index(handle, element);
+        nuj__free_size(handle, nuj_object->children, nuj_object->max_child_count * (unsigned int)sizeof(NUJElement*));
+    }
+
+    nuj__free_size(handle, element, nuj__get_element_size(element->type));
+}
+
+static void nuj__drop_key_index(NUJHandle handle, NUJElement* element)
+{
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+
+    if (nuj_object->index && handle)
+    {
+        nuj__free_size(handle, nuj_object->index, (unsigned int)(sizeof(NUJKeyIndex) + (nuj_object->index->mask + 1) * sizeof(NUJKeyIndexEntry)));
+    }
+
+    nuj_object->index = 0;
+}
+
+// NOTE: Doubles the children array.  A freed block is used first,
+// otherwise it grows in place if it is the last push of the handle,
+// like nuj__grow_size, so appends are amortized O(1) either way.
+// Returns 0 if the handle is full.
+static int nuj__grow_children(NUJHandle handle, NUJElement* element)
+{
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+    unsigned int size = nuj_object->max_child_count * (unsigned int)sizeof(NUJElement*);
+    unsigned int max_child_count = nuj_object->max_child_count < 4 ? 4 : nuj_object->max_child_count * 2;
+    unsigned int extra_size = (max_child_count - nuj_object->max_child_count) * (unsigned int)sizeof(NUJElement*);
+    NUJElement** children = (NUJElement**)nuj__take_free_block(handle, size + extra_size);
+
+    if (!children &&
+        (unsigned char*)nuj_object->children + size == handle->buffer + handle->buffer_used &&
+        handle->buffer_used + extra_size < handle->buffer_size)
+    {
+        handle->buffer_used += extra_size;
+        NUJ_STATS_MAX(&handle->stats, max_used_size, handle->used_before + handle->buffer_used);
+    }
+    else
+    {
+        if (!children)
+        {
+            children = (NUJElement**)nuj__push_size(handle, size + extra_size);
+        }
+
+        if (!children)
+        {
+            return 0;
+        }
+
+        memcpy(children, nuj_object->children, size);
+        nuj__free_size(handle, nuj_object->children, size);
+        nuj_object->children = children;
+    }
+
+    nuj_object->max_child_count = max_child_count;
+
+    return 1;
+}
+
+static unsigned int nuj__get_child_index(const NUJElement* element, const NUJElement* child)
+{
+    const NUJObject* nuj_object = NUJ_COBJECT(element);
+    unsigned int index = 0;
+
+    while (index < nuj_object->child_count && nuj_object->children[index] != child)
+    {
+        ++index;
+    }
+
+    NUJ_ASSERT(index < nuj_object->child_count);
+
+    return index;
+}
+
+// NOTE: Inserts child before the child at index, an index of
+// child_count or more appends.  Unlike nuj_add_element_element the
+// children array grows when it is full, with memory from the free
+// lists of handle if there is some.  name isn't copied, it is 0 in
+// arrays.  The key index is dropped and built again on the next
+// nuj_find_child_by_name.  Returns 0 if the children array can't grow
+// because handle is full.  child must not have a parent, remove it with
+// a handle of 0 first to move it.
+NUJDEF NUJElement* nuj_insert_element(NUJHandle handle, NUJElement* element, unsigned int index, const char* name, NUJElement* child)
+{
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+    NUJ_ASSERT(child != element && !child->parent);
+
+    if (nuj_object->child_count == nuj_object->max_child_count && !nuj__grow_children(handle, element))
+    {
+        return 0;
+    }
+
+    if (index > nuj_object->child_count)
+    {
+        index = nuj_object->child_count;
+    }
+
+    memmove(nuj_object->children + index + 1, nuj_object->children + index, (nuj_object->child_count - index) * sizeof(NUJElement*));
+    nuj_object->children[index] = child;
+    ++nuj_object->child_count;
+
+    child->name = name;
+    child->name_length = name ? (unsigned int)strlen(name) : 0;
+    child->parent = element;
+    nuj__drop_key_index(handle, element);
+
+    return child;
+}
+
+// NOTE: Removes child from its parent.  Its memory, and that of all
+// its descendants, goes to the free lists of handle to be reused by
+// the next elements created there.  With a handle of 0 it is kept, so
+// child can be inserted somewhere else.  Elements must be freed to
+// the handle they were created in.
+NUJDEF void nuj_remove_element(NUJHandle handle, NUJElement* child)
+{
+    NUJElement* element = child->parent;
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+    unsigned int index = 0;
+
+    NUJ_ASSERT(element && (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE));
+
+    index = nuj__get_child_index(element, child);
+
+    --nuj_object->child_count;
+    memmove(nuj_object->children + index, nuj_object->children + index + 1, (nuj_object->child_count - index) * sizeof(NUJElement*));
+    nuj__drop_key_index(handle, element);
+    child->parent = 0;
+
+    if (handle)
+    {
+        nuj__free_element(handle, child);
+    }
+}
+
+// NOTE: Puts value in the place of child, with its name.  child is
+// freed like in nuj_remove_element.  The key index is kept.  value must
+// not have a parent, so it can't be a descendant of child.  Replacing
+// child with itself does nothing.
+NUJDEF NUJElement* nuj_replace_element(NUJHandle handle, NUJElement* child, NUJElement* value)
+{
+    NUJElement* element = child->parent;
+    NUJObject* nuj_object = NUJ_OBJECT(element);
+    unsigned int index = 0;
+
+    NUJ_ASSERT(element && (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE));
+
+    if (value == child)
+    {
+        return child;
+    }
+
+    NUJ_ASSERT(!value->parent);
+
+    index = nuj__get_child_index(element, child);
+
+    nuj_object->children[index] = value;
+    value->name = child->name;
+    value->name_length = child->name_length;
+    value->parent = element;
+
+    if (nuj_object->index && child->name)
+    {
+        NUJKeyIndex* key_index = nuj_object->index;
+        unsigned int slot = nuj__hash_name(child->name, child->name_length) & key_index->mask;
+
+        while (key_index->entries[slot].element != child)
+        {
+            slot = (slot + 1) & key_index->mask;
+        }
+
+        key_index->entries[slot].element = value;
+    }
+
+    child->parent = 0;
+
+    if (handle)
+    {
+        nuj__free_element(handle, child);
+    }
+
+    return value;
+}
+
+// NOTE: name isn't copied or interned.  The key index of the parent is
+// dropped, see nuj_insert_element.
+NUJDEF void nuj_rename_element(NUJHandle handle, NUJElement* child, const char* name)
+{
+    NUJ_ASSERT(child->parent && child->parent->type == NUJObject_TYPE);
+
+    child->name = name;
+    child->name_length = (unsigned int)strlen(name);
+    nuj__drop_key_index(handle, child->parent);
+}
+
+NUJDEF int nuj_is_last_object_element(const NUJElement* element)
+{
+    NUJElement* parent = element->parent;
+    NUJObject* parent_object = NUJ_OBJECT(parent);
+    int result = (!parent ||
+                  ((parent->type == NUJObject_TYPE || parent->type == NUJArray_TYPE) &&
+                   parent_object->children[parent_object->child_count - 1] == element));
+
+    return result;
+}
+
+// NOTE: Name of an element in an object, not null terminated if it
+// was parsed with NUJ_PARSE_VIEWS.
+NUJDEF const char* nuj_get_name(const NUJElement* element, unsigned int* length)
+{
+    if (length)
+    {
+        *length = element->name_length;
+    }
+
+    return element->name;
+}
+
+// NOTE: Value of a string element as it was in the input, escapes
+// included.  Not null terminated if it was parsed with NUJ_PARSE_VIEWS.
+NUJDEF const char* nuj_get_string(const NUJElement* element, unsigned int* length)
+{
+    NUJ_ASSERT(element->type == NUJString_TYPE);
+
+    if (length)
+    {
+        *length = NUJ_CSTRING(element)->length;
+    }
+
+    return NUJ_CSTRING(element)->value;
+}
+
+// NOTE: Decodes the escape starting with the backslash at current to
+// decoded, see nuj_decode_string.  Returns how many chars of the input
+// it used, never less than *decoded_length, which is at most 4.
+static unsigned int nuj__decode_escape(const char* current, const char* end, char* decoded, unsigned int* decoded_length)
+{
+    const char* start = current;
+    char escaped = 0;
+    unsigned int code_point = 0;
+
+    if (current + 1 < end)
+    {
+        switch (current[1])
+        {
+            case '"':  escaped = '"';  break;
+            case '\\': escaped = '\\'; break;
+            case '/':  escaped = '/';  break;
+            case 'b':  escaped = '\b'; break;
+            case 'f':  escaped = '\f'; break;
+            case 'n':  escaped = '\n'; break;
+            case 'r':  escaped = '\r'; break;
+            case 't':  escaped = '\t'; break;
+        }
+    }
+
+    if (current + 1 < end && current[1] == 'u' && end - current >= 6 && nuj__decode_hex(current + 2, &code_point))
+    {
+        current += 6;
+
+        if (code_point >= 0xD800 && code_point < 0xDC00)
+        {
+            unsigned int low = 0;
+
+            if (end - current >= 6 && current[0] == '\\' && current[1] == 'u' &&
+                nuj__decode_hex(current + 2, &low) && low >= 0xDC00 && low < 0xE000)
+            {
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                current += 6;
+            }
+            else
+            {
+                code_point = 0xFFFD;
+            }
+        }
+        else if (code_point >= 0xDC00 && code_point < 0xE000)
+        {
+            code_point = 0xFFFD;
+        }
+
+        *decoded_length = (unsigned int)(nuj__encode_utf8(decoded, code_point) - decoded);
+    }
+    else if (escaped)
+    {
+        decoded[0] = escaped;
+        *decoded_length = 1;
+        current += 2;
+    }
+    else if (current + 1 < end)
+    {
+        decoded[0] = current[0];
+        decoded[1] = current[1];
+        *decoded_length = 2;
+        current += 2;
+    }
+    else
+    {
+        decoded[0] = current[0];
+        *decoded_length = 1;
+        current += 1;
+    }
+
+    return (unsigned int)(current - start);
+}
+
+// NOTE: Decodes the escapes of string to buffer and returns the decoded
+// length.  It is never more than length, so buffer may be string
+// itself.  \u escapes are written as UTF-8 and unpaired surrogates as
+// U+FFFD, invalid escapes are copied as they are.  Nothing is null
+// terminated.
+NUJDEF unsigned int nuj_decode_string(const char* string, unsigned int length, char* buffer)
+{
+    const char* current = string;
+    const char* end = string + length;
+    char* output = buffer;
+
+    while (current < end)
+    {
+        const char* backslash = (const char*)memchr(current, '\\', (size_t)(end - current));
+        const char* copy_end = backslash ? backslash : end;
+
+        memmove(output, current, (size_t)(copy_end - current));
+        output += copy_end - current;
+        current = copy_end;
+
+        if (current < end)
+        {
+            char decoded[4];
+            unsigned int decoded_length = 0;
+
+            current += nuj__decode_escape(current, end, decoded, &decoded_length);
+            memcpy(output, decoded, decoded_length);
+            output += decoded_length;
+        }
+    }
+
+    return (unsigned int)(output - buffer);
+}
+
+NUJDEF void nuj_printf(const NUJElement* element)
+{
+    nuj__printf(element, 0);
+}
+
+NUJDEF void nuj_print(const NUJElement* element)
+{
+    if (!element)
+        return;
+
+    if (element->name)
+    {
+        printf("\"%.*s\":", (int)element->name_length, element->name);
+    }
+
+    if (element->type == NUJObject_TYPE)
+    {
+        printf("{");
+    }
+    else if (element->type == NUJArray_TYPE)
+    {
+        printf("[");
+    }
+    else
     {
         nuj__print_primitive_element(element);
     }
 
-    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
-    {
-        unsigned int i = 0;
+    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    {
+        unsigned int i = 0;
+
+        for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
+        {
+            nuj_print(NUJ_COBJECT(element)->children[i]);
+        }
+
+        printf("%s", element->type == NUJObject_TYPE ? "}" : element->type == NUJArray_TYPE ? "]" : 0);
+
+        if (!nuj_is_last_object_element(element))
+        {
+            printf(",");
+        }
+    }
+}
+
+// NOTE: Serializes element into buffer and returns the length of the
+// whole output, even if it didn't fit.  Output is null terminated if
+// there is room for it.  Call with buffer 0 to only compute the size.
+NUJDEF unsigned long long nuj_write(const NUJElement* element, char* buffer, unsigned long long buffer_size, unsigned int flags)
+{
+    NUJWriter writer = NUJ_ZERO;
+
+    writer.buffer = buffer;
+    writer.buffer_size = buffer ? buffer_size : 0;
+    writer.flags = flags;
+
+    nuj__write_element(&writer, element, 0);
+
+    if (writer.total_size < writer.buffer_size)
+    {
+        buffer[writer.total_size] = '\0';
+    }
+
+    return writer.total_size;
+}
+
+// NOTE: Serializes element through write, buffer is used to batch the
+// calls.  Returns the length of the output or 0 if write failed.
+NUJDEF unsigned long long nuj_write_to(const NUJElement* element, NUJWriteFunc* write, void* user_data, char* buffer, unsigned long long buffer_size, unsigned int flags)
+{
+    NUJWriter writer = NUJ_ZERO;
+
+    writer.buffer = buffer;
+    writer.buffer_size = buffer_size;
+    writer.write = write;
+    writer.user_data = user_data;
+    writer.flags = flags;
+
+    nuj__write_element(&writer, element, 0);
+
+    if (!writer.failed && writer.buffer_used)
+    {
+        writer.failed = !write(user_data, writer.buffer, writer.buffer_used);
+    }
+
+    return writer.failed ? 0 : writer.total_size;
+}
+
+// NOTE: Searches the whole tree, children first.  Key indexes are
+// used if they exist, use nuj_find_child_by_name for direct lookups.
+NUJDEF NUJElement* nuj_find_element_by_name(const NUJElement* element, const char* name)
+{
+    unsigned int length = (unsigned int)strlen(name);
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+
+    return nuj__find_element_by_name(element, name, length, nuj__hash_name(name, length));
+}
+
+// NOTE: Looks up a direct child of an object.  If handle is given,
+// objects with many children get a key index on their first lookup,
+// so next lookups are O(1).
+NUJDEF NUJElement* nuj_find_child_by_name(NUJHandle handle, NUJElement* element, const char* name)
+{
+    NUJElement* found = 0;
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+
+    if (element->type == NUJObject_TYPE)
+    {
+        unsigned int length = (unsigned int)strlen(name);
+
+        if (handle && !NUJ_OBJECT(element)->index && NUJ_OBJECT(element)->child_count >= NUJ_KEY_INDEX_MIN_COUNT)
+        {
+            nuj__create_key_index(handle, element);
+        }
+
+        found = nuj__find_child(element, name, length, nuj__hash_name(name, length));
+    }
+
+    return found;
+}
+
+// NOTE: Builds the key index of an object regardless of its child count.
+NUJDEF void nuj_index_keys(NUJHandle handle, NUJElement* element)
+{
+    NUJ_ASSERT(element->type == NUJObject_TYPE);
+
+    nuj__create_key_index(handle, element);
+}
+
+// NOTE: Creates a table of distinct names in handle, see
+// nuj_set_intern_table.  capacity is rounded up to a power of two and
+// the table grows when it is half full.  handle must outlive the
+// elements parsed with the table and can't parse itself, parsing
+// resets a handle.  Returns 0 if handle is full.
+NUJDEF NUJInternTable* nuj_create_intern_table(NUJHandle handle, unsigned int capacity)
+{
+    NUJInternTable* table = (NUJInternTable*)nuj__push_size(handle, sizeof(NUJInternTable));
+    NUJInternEntry* entries = 0;
+    unsigned int size = 16;
+
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+
+    entries = table ? (NUJInternEntry*)nuj__push_size(handle, size * (unsigned int)sizeof(NUJInternEntry)) : 0;
+
+    if (entries)
+    {
+        memset(entries, 0, size * sizeof(NUJInternEntry));
+        table->handle = handle;
+        table->entries = entries;
+        table->mask = size - 1;
+        table->count = 0;
+        table->frozen = 0;
+    }
+
+    return entries ? table : 0;
+}
+
+// NOTE: Names of elements parsed by handle are taken from table, so
+// each distinct name is stored once for all the handles that share
+// it, and names can be matched by pointer with
+// nuj_find_child_by_interned_name.  Names are still copied with
+// NUJ_PARSE_VIEWS and nuj_parse_insitu.  A table isn't thread safe,
+// handles that parse at the same time, like those of nuj_parse_lines,
+// can only share a frozen one.  table 0 stops interning.
+NUJDEF void nuj_set_intern_table(NUJHandle handle, NUJInternTable* table)
+{
+    NUJ_ASSERT(!table || table->handle != handle);
+
+    handle->intern_table = table;
+}
+
+// NOTE: Nothing is added to a frozen table, new names are copied as if
+// there was no table.  It is only read, so it can be shared by handles
+// on any number of threads.
+NUJDEF void nuj_freeze_intern_table(NUJInternTable* table)
+{
+    table->frozen = 1;
+}
+
+// NOTE: Returns the interned copy of name, which is added if it isn't
+// in the table yet.  Returns 0 for new names if the table is frozen.
+NUJDEF const char* nuj_intern_name(NUJInternTable* table, const char* name, unsigned int length)
+{
+    return nuj__intern_name(table, name, length, nuj__hash_name(name, length));
+}
+
+// NOTE: Like nuj_find_child_by_name for a name from nuj_intern_name,
+// but names are only compared by pointer and the key index, if there
+// is one, is probed with the hash stored before name.  element must
+// be parsed by a handle with the same table and without
+// NUJ_PARSE_VIEWS, then all of its names that are in the table are
+// interned.
+NUJDEF NUJElement* nuj_find_child_by_interned_name(const NUJElement* element, const char* name)
+{
+    const NUJObject* nuj_object = NUJ_COBJECT(element);
+    NUJElement* found = 0;
+    unsigned int i = 0;
+
+    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+
+    if (element->type == NUJObject_TYPE && nuj_object->index)
+    {
+        const NUJKeyIndex* index = nuj_object->index;
+        unsigned int hash = 0;
+        unsigned int slot = 0;
+
+        memcpy(&hash, name - sizeof(hash), sizeof(hash));
+        slot = hash & index->mask;
+
+        while (!found && index->entries[slot].element)
+        {
+            if (index->entries[slot].element->name == name)
+            {
+                found = index->entries[slot].element;
+            }
+
+            slot = (slot + 1) & index->mask;
+        }
+    }
+    else if (element->type == NUJObject_TYPE)
+    {
+        for (i = 0; !found && i < nuj_object->child_count; ++i)
+        {
+            if (nuj_object->children[i]->name == name)
+            {
+                found = nuj_object->children[i];
+            }
+        }
+    }
+
+    return found;
+}
+
+// NOTE: Compiles a JSON Pointer (RFC 6901) like "/orders/3/price" or
+// a dotted path like "orders.3.price" into the handle.  Paths starting
+// with '/' are JSON Pointers, "" is the element itself.  Returns 0 if
+// the path is not valid or handle is full.  Compiled paths don't
+// depend on any document, so keep them in a handle that is not reset
+// by nuj_parse.
+NUJDEF NUJPath* nuj_compile_path(NUJHandle handle, const char* path)
+{
+    NUJPath* nuj_path = 0;
+    char* names = 0;
+    const char* current = path;
+    unsigned int path_length = (unsigned int)strlen(path);
+    unsigned int segment_count = 0;
+    unsigned int i = 0;
+    int is_pointer = path[0] == '/';
+    char separator = is_pointer ? '/' : '.';
+
+    // NOTE: Escapes are checked before the push, so an invalid path
+    // takes nothing from handle.
+    if (path_length)
+    {
+        segment_count = is_pointer ? 0 : 1;
+
+        for (i = 0; i < path_length; ++i)
+        {
+            if (is_pointer && path[i] == '~' && path[i + 1] != '0' && path[i + 1] != '1')
+            {
+                return 0;
+            }
+
+            segment_count += path[i] == separator;
+        }
+    }
+
+    nuj_path = (NUJPath*)nuj__push_size(handle, sizeof(NUJPath) + segment_count * sizeof(NUJPathSegment) + path_length + segment_count);
+
+    if (!nuj_path)
+    {
+        return 0;
+    }
+
+    nuj_path->segment_count = segment_count;
+    names = (char*)(nuj_path->segments + segment_count);
+
+    if (is_pointer)
+    {
+        ++current;
+    }
+
+    for (i = 0; i < segment_count; ++i)
+    {
+        NUJPathSegment* segment = &nuj_path->segments[i];
+
+        segment->name = names;
+
+        while (*current && *current != separator)
+        {
+            if (is_pointer && *current == '~')
+            {
+                *names++ = current[1] == '0' ? '~' : '/';
+                current += 2;
+            }
+            else
+            {
+                *names++ = *current++;
+            }
+        }
+
+        segment->length = (unsigned int)(names - segment->name);
+        *names++ = '\0';
+        nuj__compile_path_segment(segment);
+
+        if (*current)
+        {
+            ++current;
+        }
+    }
+
+    return nuj_path;
+}
+
+// NOTE: Direct descent, key indexes are used if the objects have them.
+NUJDEF NUJElement* nuj_find_element_by_path(const NUJElement* element, const NUJPath* path)
+{
+    NUJElement* found = (NUJElement*)element;
+    unsigned int i = 0;
+
+    for (i = 0; found && i < path->segment_count; ++i)
+    {
+        const NUJPathSegment* segment = &path->segments[i];
+
+        if (found->type == NUJObject_TYPE)
+        {
+            found = nuj__find_child(found, segment->name, segment->length, segment->hash);
+        }
+        else if (found->type == NUJArray_TYPE && segment->is_index && segment->index < NUJ_CHILD_COUNT(found))
+        {
+            found = NUJ_CHILD(found, segment->index);
+        }
+        else
+        {
+            found = 0;
+        }
+    }
+
+    return found;
+}
+
+// NOTE: results[i * path_count + j] is paths[j] evaluated on elements[i].
+NUJDEF void nuj_find_elements_by_paths(const NUJElement* const* elements, unsigned int element_count, const NUJPath* const* paths, unsigned int path_count, NUJElement** results)
+{
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for (i = 0; i < element_count; ++i)
+    {
+        for (j = 0; j < path_count; ++j)
+        {
+            results[i * path_count + j] = elements[i] ? nuj_find_element_by_path(elements[i], paths[j]) : 0;
+        }
+    }
+}
+
+// NOTE: Copies the tree to a compact document of 16 byte nodes in one
+// push.  Names and strings are copied as they are.  The document has
+// no pointers, so it can be copied as a block of
+// nuj_get_document_size bytes or saved with nuj_save_snapshot.
+// Returns 0 if handle is full.
+NUJDEF NUJDocument* nuj_create_document(NUJHandle handle, const NUJElement* element, unsigned int flags)
+{
+    NUJDocument* document = 0;
+    unsigned long long node_count = 0;
+    unsigned long long string_size = 0;
+    unsigned long long size = 0;
+    unsigned int next_node = 1;
+    unsigned int string_used = 0;
+
+    nuj__count_document_element(element, &node_count, &string_size);
+
+    size = sizeof(NUJDocument) + node_count * sizeof(NUJNode) + string_size;
+
+    if (flags & NUJ_DOCUMENT_PARENTS)
+    {
+        size += node_count * sizeof(unsigned int);
+    }
+
+    NUJ_ASSERT(size < 0xFFFFFFFFULL);
+
+    document = (NUJDocument*)nuj__push_size(handle, (unsigned int)size);
+
+    if (document)
+    {
+        document->node_count = (unsigned int)node_count;
+        document->flags = flags;
+        document->string_size = (unsigned int)string_size;
+        document->reserved = 0;
+
+        nuj__fill_document_node(document, 0, 0, element, &next_node, &string_used);
+    }
+
+    return document;
+}
+
+NUJDEF unsigned long long nuj_get_document_size(const NUJDocument* document)
+{
+    return (unsigned long long)(nuj__get_document_strings(document) - (const char*)document) + document->string_size;
+}
+
+NUJDEF unsigned int nuj_get_node_type(const NUJDocument* document, unsigned int node)
+{
+    return nuj__get_document_nodes(document)[node].tag & NUJ_NODE_TYPE_MASK;
+}
+
+// NOTE: Returns 0 if the node isn't in an object.
+NUJDEF const char* nuj_get_node_name(const NUJDocument* document, unsigned int node, unsigned int* length)
+{
+    const NUJNode* nuj_node = nuj__get_document_nodes(document) + node;
+    const char* name = 0;
+
+    if (nuj_node->tag & NUJ_NODE_HAS_NAME)
+    {
+        name = nuj__get_document_strings(document) + nuj_node->name;
+    }
+
+    if (length)
+    {
+        *length = nuj_node->tag >> NUJ_NODE_NAME_SHIFT;
+    }
+
+    return name;
+}
+
+NUJDEF const char* nuj_get_node_string(const NUJDocument* document, unsigned int node, unsigned int* length)
+{
+    const NUJNode* nuj_node = nuj__get_document_nodes(document) + node;
+
+    NUJ_ASSERT(nuj_get_node_type(document, node) == NUJString_TYPE);
+
+    if (length)
+    {
+        *length = nuj_node->value.string.length;
+    }
+
+    return nuj__get_document_strings(document) + nuj_node->value.string.offset;
+}
+
+NUJDEF long long nuj_get_node_integer(const NUJDocument* document, unsigned int node)
+{
+    NUJ_ASSERT(nuj_get_node_type(document, node) == NUJInteger_TYPE);
+
+    return nuj__get_document_nodes(document)[node].value.integer;
+}
+
+NUJDEF double nuj_get_node_double(const NUJDocument* document, unsigned int node)
+{
+    NUJ_ASSERT(nuj_get_node_type(document, node) == NUJDouble_TYPE);
+
+    return nuj__get_document_nodes(document)[node].value.number;
+}
+
+NUJDEF int nuj_get_node_boolean(const NUJDocument* document, unsigned int node)
+{
+    NUJ_ASSERT(nuj_get_node_type(document, node) == NUJBoolean_TYPE);
+
+    return nuj__get_document_nodes(document)[node].value.integer != 0;
+}
+
+NUJDEF unsigned int nuj_get_node_child_count(const NUJDocument* document, unsigned int node)
+{
+    unsigned int type = nuj_get_node_type(document, node);
+
+    return (type == NUJObject_TYPE || type == NUJArray_TYPE) ? nuj__get_document_nodes(document)[node].value.children.count : 0;
+}
+
+NUJDEF unsigned int nuj_get_node_child(const NUJDocument* document, unsigned int node, unsigned int index)
+{
+    NUJ_ASSERT(index < nuj_get_node_child_count(document, node));
+
+    return nuj__get_document_nodes(document)[node].value.children.first + index;
+}
+
+// NOTE: Returns 0 for the root.  Without NUJ_DOCUMENT_PARENTS the
+// parent is found by descending from the root.  Descendants of the
+// container children of a node come after all its children, in the
+// order of the children, so at each level the child to descend into
+// is the last container child whose children start at or before node.
+NUJDEF unsigned int nuj_get_node_parent(const NUJDocument* document, unsigned int node)
+{
+    unsigned int parent = 0;
+
+    if (document->flags & NUJ_DOCUMENT_PARENTS)
+    {
+        parent = nuj__get_document_parents(document)[node];
+    }
+    else if (node)
+    {
+        const NUJNode* nodes = nuj__get_document_nodes(document);
+
+        while (node - nodes[parent].value.children.first >= nodes[parent].value.children.count)
+        {
+            unsigned int low = nodes[parent].value.children.first;
+            unsigned int high = low + nodes[parent].value.children.count;
+
+            // NOTE: Binary search, leaf children are skipped forwards.
+            while (low < high)
+            {
+                unsigned int middle = low + (high - low) / 2;
+                unsigned int child = middle;
+                unsigned int type = 0;
+
+                for (; child < high; ++child)
+                {
+                    type = nodes[child].tag & NUJ_NODE_TYPE_MASK;
+
+                    if (type == NUJObject_TYPE || type == NUJArray_TYPE)
+                    {
+                        break;
+                    }
+                }
+
+                if (child < high && nodes[child].value.children.first <= node)
+                {
+                    parent = child;
+                    low = child + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+        }
+    }
+
+    return parent;
+}
+
+// NOTE: Looks up a direct child of an object node, returns 0 if there
+// is none.
+NUJDEF unsigned int nuj_find_node_by_name(const NUJDocument* document, unsigned int node, const char* name)
+{
+    const NUJNode* nodes = nuj__get_document_nodes(document);
+    const char* strings = nuj__get_document_strings(document);
+    unsigned int length = (unsigned int)strlen(name);
+    unsigned int tag = NUJ_NODE_HAS_NAME | (length << NUJ_NODE_NAME_SHIFT);
+    unsigned int found = 0;
+    unsigned int i = 0;
+
+    if (nuj_get_node_type(document, node) == NUJObject_TYPE)
+    {
+        unsigned int first = nodes[node].value.children.first;
+
+        for (i = first; !found && i < first + nodes[node].value.children.count; ++i)
+        {
+            if ((nodes[i].tag & ~NUJ_NODE_TYPE_MASK) == tag && !memcmp(strings + nodes[i].name, name, length))
+            {
+                found = i;
+            }
+        }
+    }
+
+    return found;
+}
+
+static void nuj__init_snapshot(NUJSnapshot* snapshot, const NUJDocument* document)
+{
+    snapshot->magic = NUJ_SNAPSHOT_MAGIC;
+    snapshot->version = NUJ_SNAPSHOT_VERSION;
+    snapshot->byte_order = NUJ_SNAPSHOT_BYTE_ORDER;
+    snapshot->header_size = sizeof(NUJSnapshot);
+    snapshot->document_size = nuj_get_document_size(document);
+    snapshot->reserved = 0;
+}
+
+// NOTE: Writes a snapshot header followed by the document.  Returns
+// the number of bytes written, or 0 if write failed.
+NUJDEF unsigned long long nuj_write_snapshot(const NUJDocument* document, NUJWriteFunc* write, void* user_data)
+{
+    NUJSnapshot snapshot;
+    unsigned long long size = 0;
+
+    nuj__init_snapshot(&snapshot, document);
+
+    if (write(user_data, &snapshot, sizeof(snapshot)) && write(user_data, document, snapshot.document_size))
+    {
+        size = sizeof(snapshot) + snapshot.document_size;
+    }
+
+    return size;
+}
+
+// NOTE: Saves a snapshot to a file, returns 0 on failure.
+NUJDEF int nuj_save_snapshot(const NUJDocument* document, const char* path)
+{
+    int result = 0;
+
+#ifndef NUJ_NO_STDIO
+    FILE* file = fopen(path, "wb");
+
+    if (file)
+    {
+        NUJSnapshot snapshot;
+
+        nuj__init_snapshot(&snapshot, document);
+
+        result = fwrite(&snapshot, sizeof(snapshot), 1, file) == 1 &&
+                 fwrite(document, (size_t)snapshot.document_size, 1, file) == 1;
+        result = !fclose(file) && result;
+    }
+#else
+    (void)document;
+    (void)path;
+#endif
+
+    return result;
+}
+
+// NOTE: Returns the document of a snapshot in memory, usually from
+// nuj_map_file, without copying or fixing up anything, so it is only
+// valid as long as the memory is.  The memory has to be 8 byte
+// aligned, which mappings are.  Only the header and sizes are checked,
+// the nodes are trusted, so only load snapshots you saved yourself.
+// Returns 0 if the memory isn't a snapshot from this version and byte
+// order.
+NUJDEF const NUJDocument* nuj_load_snapshot(const void* memory, unsigned long long size)
+{
+    const NUJSnapshot* snapshot = (const NUJSnapshot*)memory;
+    const NUJDocument* document = 0;
+
+    if (memory && !((unsigned long long)(size_t)memory & 7) && size >= sizeof(NUJSnapshot) + sizeof(NUJDocument) &&
+        snapshot->magic == NUJ_SNAPSHOT_MAGIC && snapshot->version == NUJ_SNAPSHOT_VERSION &&
+        snapshot->byte_order == NUJ_SNAPSHOT_BYTE_ORDER && snapshot->header_size == sizeof(NUJSnapshot) &&
+        snapshot->document_size <= size - sizeof(NUJSnapshot))
+    {
+        const NUJDocument* candidate = (const NUJDocument*)(snapshot + 1);
+        unsigned long long node_size = sizeof(NUJNode);
+
+        if (candidate->flags & NUJ_DOCUMENT_PARENTS)
+        {
+            node_size += sizeof(unsigned int);
+        }
+
+        // NOTE: Sizes are 32 bit, so this can't overflow.
+        if (sizeof(NUJDocument) + candidate->node_count * node_size + candidate->string_size == snapshot->document_size &&
+            candidate->node_count > 0)
+        {
+            document = candidate;
+        }
+    }
+
+    return document;
+}
+
+// NOTE: Parses the buffer to a tape in one pass.  The tape starts with
+// room for a word per 8 bytes of input and strings half its size,
+// which most documents don't outgrow, and what is left over is given
+// back.  Any value is accepted as the root.  Returns 0 if the buffer is
+// invalid or the handle is full, nothing is kept then.
+NUJDEF NUJTape* nuj_parse_tape(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size)
+{
+    NUJParser parser = NUJ_ZERO;
+    NUJTapeWriter writer = NUJ_ZERO;
+    unsigned long long input_size = 0;
+    unsigned long long size = 0;
+    int result = 0;
+
+    nuj__parse_init(&parser, buffer, buffer_size);
+    input_size = (unsigned long long)(parser.end - parser.initial);
+    writer.handle = handle;
+    writer.max_word_count = input_size / 8 + 8;
+    writer.max_string_size = input_size / 2 + 64;
+    size = sizeof(NUJTape) + writer.max_word_count * sizeof(unsigned long long) + writer.max_string_size;
+
+    if (size < 0xFFFFFFFFULL)
+    {
+        writer.tape = (NUJTape*)nuj__push_size(handle, (unsigned int)size);
+    }
+
+    if (!writer.tape)
+    {
+        writer.max_word_count = 8;
+        writer.max_string_size = 64;
+        size = sizeof(NUJTape) + writer.max_word_count * sizeof(unsigned long long) + writer.max_string_size;
+        writer.tape = (NUJTape*)nuj__push_size(handle, (unsigned int)size);
+    }
+
+    if (writer.tape)
+    {
+        writer.tape->word_count = writer.max_word_count;
+        result = nuj__tape_element(&parser, nuj__parse_get_token(&parser), &writer) &&
+                 nuj__parse_match_token(nuj__parse_get_token(&parser), NUJ_EOF_TYPE);
+
+        // NOTE: The tape is still the last push of the handle.
+        size = sizeof(NUJTape) + writer.max_word_count * sizeof(unsigned long long) + writer.max_string_size;
+        handle->buffer_used -= size;
+
+        if (result)
+        {
+            writer.tape->word_count = writer.word_count;
+            writer.tape->string_size = writer.string_size;
+            memmove(nuj__get_tape_strings(writer.tape), nuj__get_tape_words(writer.tape) + writer.max_word_count, writer.string_size);
+            handle->buffer_used += nuj_get_tape_size(writer.tape);
+        }
+    }
+
+    return result ? writer.tape : 0;
+}
+
+NUJDEF unsigned long long nuj_get_tape_size(const NUJTape* tape)
+{
+    return sizeof(NUJTape) + tape->word_count * sizeof(unsigned long long) + tape->string_size;
+}
+
+// NOTE: Type of the value of an entry, as a NUJElementType.
+NUJDEF unsigned int nuj_get_tape_type(const NUJTape* tape, unsigned int entry)
+{
+    unsigned int type = NUJNone_TYPE;
+
+    switch (NUJ_TAPE_TAG(nuj__get_tape_words(tape)[nuj_get_tape_value(tape, entry)]))
+    {
+        case '"': { type = NUJString_TYPE;  } break;
+        case 'l': { type = NUJInteger_TYPE; } break;
+        case 'd': { type = NUJDouble_TYPE;  } break;
+        case 't':
+        case 'f': { type = NUJBoolean_TYPE; } break;
+        case 'n': { type = NUJNull_TYPE;    } break;
+        case '[': { type = NUJArray_TYPE;   } break;
+        case '{': { type = NUJObject_TYPE;  } break;
+    }
+
+    return type;
+}
+
+// NOTE: Returns 0 if the entry isn't in an object.
+NUJDEF const char* nuj_get_tape_name(const NUJTape* tape, unsigned int entry, unsigned int* length)
+{
+    unsigned long long word = nuj__get_tape_words(tape)[entry];
+    const char* name = 0;
+
+    if (NUJ_TAPE_TAG(word) == 'k')
+    {
+        name = nuj__get_tape_word_string(tape, word, length);
+    }
+    else if (length)
+    {
+        *length = 0;
+    }
+
+    return name;
+}
+
+// NOTE: Index of the value word of an entry, it follows the key in
+// objects.
+NUJDEF unsigned int nuj_get_tape_value(const NUJTape* tape, unsigned int entry)
+{
+    return entry + (NUJ_TAPE_TAG(nuj__get_tape_words(tape)[entry]) == 'k');
+}
+
+NUJDEF const char* nuj_get_tape_string(const NUJTape* tape, unsigned int entry, unsigned int* length)
+{
+    unsigned long long word = nuj__get_tape_words(tape)[nuj_get_tape_value(tape, entry)];
+
+    NUJ_ASSERT(NUJ_TAPE_TAG(word) == '"');
+
+    return nuj__get_tape_word_string(tape, word, length);
+}
+
+NUJDEF long long nuj_get_tape_integer(const NUJTape* tape, unsigned int entry)
+{
+    unsigned int value = nuj_get_tape_value(tape, entry);
+    long long integer = 0;
+
+    NUJ_ASSERT(NUJ_TAPE_TAG(nuj__get_tape_words(tape)[value]) == 'l');
+
+    memcpy(&integer, &nuj__get_tape_words(tape)[value + 1], sizeof(integer));
+
+    return integer;
+}
+
+NUJDEF double nuj_get_tape_double(const NUJTape* tape, unsigned int entry)
+{
+    unsigned int value = nuj_get_tape_value(tape, entry);
+    double number = 0;
+
+    NUJ_ASSERT(NUJ_TAPE_TAG(nuj__get_tape_words(tape)[value]) == 'd');
 
-        for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
-        {
-            nuj__printf(NUJ_COBJECT(element)->children[i], depth + 1);
-        }
+    memcpy(&number, &nuj__get_tape_words(tape)[value + 1], sizeof(number));
 
-        if (!element->parent || (element->parent->type == NUJObject_TYPE || element->parent->type == NUJArray_TYPE))
-        {
-            nuj__print_newline_and_spaces(depth * 3);
-        }
-        printf("%s", element->type == NUJObject_TYPE ? "}" : element->type == NUJArray_TYPE ? "]" : 0);
+    return number;
+}
 
-        if (!nuj_is_last_object_element(element))
-        {
-            printf(",");
-        }
-    }
+NUJDEF int nuj_get_tape_boolean(const NUJTape* tape, unsigned int entry)
+{
+    unsigned char tag = NUJ_TAPE_TAG(nuj__get_tape_words(tape)[nuj_get_tape_value(tape, entry)]);
+
+    NUJ_ASSERT(tag == 't' || tag == 'f');
+
+    return tag == 't';
 }
 
-static void nuj__parse_error(NUJParser* parser, NUJToken token, char expected)
+// NOTE: The count is stored up to NUJ_TAPE_MAX_CHILD_COUNT, bigger
+// containers are counted by walking their children.
+NUJDEF unsigned int nuj_get_tape_child_count(const NUJTape* tape, unsigned int entry)
 {
-    const unsigned char* initial = parser->initial;
-    unsigned int line_count = 1;
-    unsigned int char_count = 0;
+    unsigned long long word = nuj__get_tape_words(tape)[nuj_get_tape_value(tape, entry)];
+    unsigned int child_count = 0;
 
-    while (initial != token.start)
+    if (NUJ_TAPE_TAG(word) == '{' || NUJ_TAPE_TAG(word) == '[')
     {
-        ++char_count;
+        child_count = (unsigned int)(NUJ_TAPE_PAYLOAD(word) >> 32);
 
-        if (*initial++ == '\n')
+        if (child_count == NUJ_TAPE_MAX_CHILD_COUNT)
         {
-            ++line_count;
-            char_count = 0;
-        }
-    }
+            unsigned int child = nuj_get_tape_first_child(tape, entry);
 
-    // NOTE: Subtract (") quote?
-    if (token.type == NUJ_STRING_TYPE)
-    {
-        --char_count;
+            for (child_count = 0; child; ++child_count)
+            {
+                child = nuj_get_tape_next_sibling(tape, child);
+            }
+        }
     }
 
-    fprintf(stderr, "Syntax error: '%c' expected but found (%.*s) at line (%u, %u)!\n", expected, token.length, token.start, line_count, char_count);
-    NUJ_ASSERT(0);
+    return child_count;
 }
 
-static inline int nuj__parse_is_whitespace_char(char character)
+// NOTE: Returns 0 if the value of the entry has no children.
+NUJDEF unsigned int nuj_get_tape_first_child(const NUJTape* tape, unsigned int entry)
 {
-    int result = ((character == ' ')  ||
-                  (character == '\t') ||
-                  (character == '\v') ||
-                  (character == '\f') ||
-                  (character == '\n') ||
-                  (character == '\r'));
+    const unsigned long long* words = nuj__get_tape_words(tape);
+    unsigned int value = nuj_get_tape_value(tape, entry);
+    unsigned int child = 0;
 
-    return result;
+    if ((NUJ_TAPE_TAG(words[value]) == '{' || NUJ_TAPE_TAG(words[value]) == '[') &&
+        (unsigned int)NUJ_TAPE_PAYLOAD(words[value]) != value + 1)
+    {
+        child = value + 1;
+    }
+
+    return child;
 }
 
-static inline void nuj__parse_skip_all_whitespace_chars(NUJParser* parser)
+// NOTE: Returns 0 after the last child.
+NUJDEF unsigned int nuj_get_tape_next_sibling(const NUJTape* tape, unsigned int entry)
 {
-    while (nuj__parse_is_whitespace_char(*parser->current))
-    {
-        ++parser->current;
-    }
+    unsigned int next = nuj_skip_tape_element(tape, entry);
+    unsigned char tag = next < tape->word_count ? NUJ_TAPE_TAG(nuj__get_tape_words(tape)[next]) : '}';
+
+    return (tag != '}' && tag != ']') ? next : 0;
 }
 
-static inline int nuj__parse_is_numeric(char character)
+// NOTE: Index of the word after the value of the entry, containers are
+// skipped in one jump.
+NUJDEF unsigned int nuj_skip_tape_element(const NUJTape* tape, unsigned int entry)
 {
-    int result = 0;
+    const unsigned long long* words = nuj__get_tape_words(tape);
+    unsigned int value = nuj_get_tape_value(tape, entry);
+    unsigned int next = value + 1;
 
-    if (character >= '0' && character <= '9')
-    {
-        result = NUJ_NUMBER_TYPE;
-    }
-    else if (character == '.')
+    switch (NUJ_TAPE_TAG(words[value]))
     {
-        result = NUJ_DOUBLE_TYPE;
+        case '{':
+        case '[': { next = (unsigned int)NUJ_TAPE_PAYLOAD(words[value]) + 1; } break;
+        case 'l':
+        case 'd': { next = value + 2; } break;
     }
 
-    return result;
+    return next;
 }
 
-static inline int nuj__parse_skip_all_numerics(NUJParser* parser)
+// NOTE: Looks up a direct child of an object, returns the entry of the
+// child or 0 if there is none.
+NUJDEF unsigned int nuj_find_tape_child(const NUJTape* tape, unsigned int entry, const char* name)
 {
-    int result = 0;
-    int is_numeric = nuj__parse_is_numeric(*parser->current);
+    unsigned int length = (unsigned int)strlen(name);
+    unsigned int child = nuj_get_tape_first_child(tape, entry);
+    unsigned int found = 0;
 
-    while (is_numeric)
+    while (!found && child)
     {
-        ++parser->current;
+        unsigned int child_length = 0;
+        const char* child_name = nuj_get_tape_name(tape, child, &child_length);
 
-        if (result < is_numeric)
+        if (child_name && child_length == length && !memcmp(child_name, name, length))
         {
-            result = is_numeric;
+            found = child;
         }
 
-        is_numeric = nuj__parse_is_numeric(*parser->current);
+        child = nuj_get_tape_next_sibling(tape, child);
     }
 
-    return result;
+    return found;
 }
 
-static NUJToken nuj__parse_get_token(NUJParser* parser)
+// NOTE: current is an opening bracket.  Returns the char after its
+// closing bracket, or 0 if the input ends first.  Only quotes and
+// brackets are looked at, nothing inside is validated.
+static const unsigned char* nuj__skip_container(const unsigned char* current, const unsigned char* end)
 {
-    NUJToken token = { 0 };
-    unsigned char current = 0;
-
-    nuj__parse_skip_all_whitespace_chars(parser);
-
-    token.start = parser->current;
-    token.length = 1;
-
-    current = *parser->current;
-    ++parser->current;
+    const unsigned char* result = 0;
+    unsigned int depth = 0;
 
-    switch (current)
+    while (!result && current < end)
     {
-        case '[':  { token.type = NUJ_OBRACKET_TYPE; } break;
-        case '{':  { token.type = NUJ_OBRACE_TYPE;   } break;
-
-        case ']':  { token.type = NUJ_CBRACKET_TYPE; } break;
-        case '}':  { token.type = NUJ_CBRACE_TYPE;   } break;
-
-        case ':':  { token.type = NUJ_COLON_TYPE;    } break;
-        case ',':  { token.type = NUJ_COMMA_TYPE;    } break;
-
-        case '\0': { token.type = NUJ_EOF_TYPE;      } break;
+        unsigned char character = *current++;
 
-        case '"':
+        if (character == '\"')
         {
-            token.type = NUJ_STRING_TYPE;
-            token.start = parser->current;
+            const unsigned char* string = current;
+            const unsigned char* quote = (const unsigned char*)memchr(current, '\"', (size_t)(end - current));
 
-            while (parser->current && *parser->current != '\0')
+            while (quote && nuj__is_escaped(string, quote))
             {
-                if (*parser->current == '\\' && *(parser->current + 1) == '\\')
-                {
-                    parser->current += 1;
-                }
-                else if (*parser->current == '\\' && *(parser->current + 1) == '"')
-                {
-                    parser->current += 1;
-                }
-                else if (*parser->current == '"')
-                {
-                    break;
-                }
-
-                ++parser->current;
+                quote = (const unsigned char*)memchr(quote + 1, '\"', (size_t)(end - quote - 1));
             }
 
-            token.length = (unsigned int)(parser->current - token.start);
-
-            if (*parser->current == '"')
-            {
-                ++parser->current;
-            }
-            else
-            {
-                token.type = NUJ_UNKNOWN_TYPE;
-            }
+            current = quote ? quote + 1 : end;
         }
-        break;
-
-        case 't':
+        else if (character == '{' || character == '[')
         {
-            if (parser->current[0] == 'r' && parser->current[1] == 'u' && parser->current[2] == 'e')
-            {
-                token.type = NUJ_BOOLEAN_TYPE;
-                token.start = (unsigned char*)TRUE;
-                token.length = 1;
-                parser->current += 3;
-            }
-            else
-            {
-                token.type = NUJ_UNKNOWN_TYPE;
-                ++parser->current;
-            }
+            ++depth;
         }
-        break;
-
-        case 'f':
+        else if ((character == '}' || character == ']') && !--depth)
         {
-            if (parser->current[0] == 'a' && parser->current[1] == 'l' &&
-                parser->current[2] == 's' && parser->current[3] == 'e')
-            {
-                token.type = NUJ_BOOLEAN_TYPE;
-                token.start = (unsigned char*)FALSE;
-                token.length = 1;
-                parser->current += 4;
-            }
-            else
-            {
-                token.type = NUJ_UNKNOWN_TYPE;
-                ++parser->current;
-            }
+            result = current;
         }
-        break;
+    }
 
-        case 'n':
+    return result;
+}
+
+// NOTE: Reads the type of the value at current.  Scalars are tokenized
+// here, objects and arrays only by their first char.
+static int nuj__read_cursor(NUJCursor* cursor, const unsigned char* current, const unsigned char* end)
+{
+    NUJParser parser = NUJ_ZERO;
+    NUJToken token = NUJ_ZERO;
+    long long integer = 0;
+    double number = 0;
+
+    while (current < end && nuj__parse_is_whitespace_char((char)*current))
+    {
+        ++current;
+    }
+
+    cursor->start = current;
+    cursor->end = end;
+    cursor->name = 0;
+    cursor->name_length = 0;
+    cursor->length = 0;
+    cursor->type = NUJNone_TYPE;
+
+    if (current < end)
+    {
+        nuj__parse_init(&parser, current, (unsigned long long)(end - current));
+        parser.flags = NUJ_PARSE_SOFT_ERRORS;
+        // NOTE: One token doesn't pay for the structural index.
+        parser.index.classify = 0;
+        token = nuj__parse_get_token(&parser);
+        cursor->length = (unsigned int)(parser.current - current);
+
+        switch (token.type)
         {
-            if (parser->current[0] == 'u' && parser->current[1] == 'l' && parser->current[2] == 'l')
+            case NUJ_OBRACE_TYPE:   { cursor->type = NUJObject_TYPE; cursor->length = 0; } break;
+            case NUJ_OBRACKET_TYPE: { cursor->type = NUJArray_TYPE;  cursor->length = 0; } break;
+            case NUJ_STRING_TYPE:   { cursor->type = NUJString_TYPE;  } break;
+            case NUJ_BOOLEAN_TYPE:  { cursor->type = NUJBoolean_TYPE; } break;
+            case NUJ_NULL_TYPE:     { cursor->type = NUJNull_TYPE;    } break;
+            case NUJ_NUMBER_TYPE:
+            case NUJ_DOUBLE_TYPE:
             {
-                token.type = NUJ_NULL_TYPE;
-                token.start = (unsigned char*)0;
-                token.length = 1;
-                parser->current += 3;
+                cursor->type = nuj__parse_token_to_number(token, &integer, &number) ? NUJInteger_TYPE : NUJDouble_TYPE;
             }
-            else
+            break;
+            default:
             {
-                token.type = NUJ_UNKNOWN_TYPE;
-                ++parser->current;
+                cursor->length = 0;
             }
+            break;
         }
-        break;
+    }
 
-        default:
-        {
-            token.type = NUJ_UNKNOWN_TYPE;
+    return cursor->type != NUJNone_TYPE;
+}
 
-            --parser->current;
+// NOTE: current is right after an opening bracket or a comma.
+static int nuj__read_cursor_child(NUJCursor* child, const unsigned char* current, const unsigned char* end, int in_object)
+{
+    int result = 0;
 
-            if (*parser->current == '-' || *parser->current == '+')
+    if (in_object)
+    {
+        NUJCursor name = NUJ_ZERO;
+
+        if (nuj__read_cursor(&name, current, end) && name.type == NUJString_TYPE)
+        {
+            current = name.start + name.length;
+
+            while (current < end && nuj__parse_is_whitespace_char((char)*current))
             {
-                token.start = parser->current++;
-                token.type = nuj__parse_skip_all_numerics(parser);
-                token.length = (unsigned int)(parser->current - token.start);
+                ++current;
             }
-            else if (nuj__parse_is_numeric(*parser->current))
+
+            if (current < end && *current == ':' && nuj__read_cursor(child, current + 1, end))
             {
-                token.start = parser->current;
-                token.type = nuj__parse_skip_all_numerics(parser);
-                token.length = (unsigned int)(parser->current - token.start);
+                child->name = (const char*)name.start + 1;
+                child->name_length = name.length - 2;
+                result = 1;
             }
         }
-        break;
     }
-
-    return token;
-}
-
-static inline int nuj__parse_match_token(NUJToken token, unsigned int match_token_type)
-{
-    int result = 1;
-
-    if (token.type != match_token_type)
+    else
     {
-        result = 0;
+        result = nuj__read_cursor(child, current, end);
     }
 
     return result;
 }
 
-// NOTE: This is far from being perfect string to double converter but
-// we don't need that much accuracy.  At least, it is much faster than
-// copying and converting.
-static double nuj__parse_token_to_number(NUJToken token, int is_double)
+// NOTE: Names with escapes are decoded one escape at a time while they
+// are compared, so there is no buffer and no limit on their length.
+static int nuj__match_cursor_name(const NUJCursor* cursor, const char* name, unsigned int length)
 {
-    const unsigned char* current = token.start;
-    double number = 0;
-    unsigned char digit = 0;
-    int negative = 1;
-    double coef = 1.0 / 10.0;
+    int result = 0;
 
-    if (*current == '-' || *current == '+')
+    if (cursor->name)
     {
-        if (*current == '-')
-        {
-            negative = -1;
-        }
+        const char* current = cursor->name;
+        const char* end = cursor->name + cursor->name_length;
+        unsigned int matched = 0;
 
-        ++current;
-    }
+        result = 1;
 
-    while ((digit = *current++ - '0') < 10)
-    {
-        number = 10.0 * number + digit;
-    }
+        while (result && current < end)
+        {
+            const char* backslash = (const char*)memchr(current, '\\', (size_t)(end - current));
+            const char* copy_end = backslash ? backslash : end;
+            unsigned int copy_length = (unsigned int)(copy_end - current);
 
-    if (is_double)
-    {
-        NUJ_ASSERT(*(current - 1) == '.');
+            result = copy_length <= length - matched && !memcmp(current, name + matched, copy_length);
+            matched += copy_length;
+            current = copy_end;
 
-        while ((digit = *current++ - '0') < 10)
-        {
-            number = number + coef * digit;
-            coef *= 1.0 / 10.0;
+            if (result && current < end)
+            {
+                char decoded[4];
+                unsigned int decoded_length = 0;
+
+                current += nuj__decode_escape(current, end, decoded, &decoded_length);
+                result = decoded_length <= length - matched && !memcmp(decoded, name + matched, decoded_length);
+                matched += decoded_length;
+            }
         }
+
+        result = result && matched == length;
     }
 
-    number = number * negative;
+    return result;
+}
 
-    return number;
+// NOTE: On demand reading of a document, in the style of simdjson's
+// ondemand.  Nothing is allocated or copied, a cursor is a position in
+// the buffer.  Values are only tokenized when a cursor reaches them and
+// everything in between is skipped by matching brackets, so the cost
+// depends on what is read and where it is, not on the size of the
+// document.  Skipped values aren't validated, so errors are only found
+// in what is read: functions return 0, or the type NUJNone_TYPE, when
+// they meet invalid input.  The buffer must outlive the cursors.
+NUJDEF int nuj_parse_cursor(NUJCursor* cursor, const unsigned char* buffer, unsigned long long buffer_size)
+{
+    return nuj__read_cursor(cursor, buffer, buffer + (buffer_size ? buffer_size : strlen((const char*)buffer)));
 }
 
-static NUJElement* nuj__parse_token_to_element(NUJHandle handle, NUJToken token)
+NUJDEF unsigned int nuj_get_cursor_type(const NUJCursor* cursor)
 {
-    NUJElement* element = 0;
+    return cursor->type;
+}
 
-    switch (token.type)
+// NOTE: Raw key as in the input, 0 outside of objects.
+NUJDEF const char* nuj_get_cursor_name(const NUJCursor* cursor, unsigned int* length)
+{
+    if (length)
     {
-        case NUJ_STRING_TYPE:
-        {
-            char* svalue = 0;
+        *length = cursor->name_length;
+    }
 
-            element = nuj_create_element_string(handle, 0);
+    return cursor->name;
+}
 
-            svalue = nuj__push_size(handle, token.length + 1);
-            memcpy((char*)svalue, token.start, token.length);
-            svalue[token.length] = '\0';
-            NUJ_STRING(element)->value = svalue;
-        }
-        break;
-        case NUJ_NUMBER_TYPE:
-        {
-            long long value = 0;
+// NOTE: Raw string as in the input, nuj_decode_string unescapes it.
+NUJDEF const char* nuj_get_cursor_string(const NUJCursor* cursor, unsigned int* length)
+{
+    const char* string = 0;
 
-            value = (long long)nuj__parse_token_to_number(token, 0);
-            element = nuj_create_element_integer(handle, value);
-        }
-        break;
-        case NUJ_DOUBLE_TYPE:
-        {
-            double value = 0;
+    if (cursor->type == NUJString_TYPE)
+    {
+        string = (const char*)cursor->start + 1;
+    }
+
+    if (length)
+    {
+        *length = string ? cursor->length - 2 : 0;
+    }
+
+    return string;
+}
 
-            value = nuj__parse_token_to_number(token, 1);
-            element = nuj_create_element_double(handle, value);
-        }
-        break;
-        case NUJ_BOOLEAN_TYPE:
-        {
-            long long value = (long long)token.start;
+NUJDEF long long nuj_get_cursor_integer(const NUJCursor* cursor)
+{
+    NUJToken token = NUJ_ZERO;
+    long long integer = 0;
+    double number = 0;
 
-            element = nuj_create_element_boolean(handle, (int)value);
-        }
-        break;
-        case NUJ_NULL_TYPE:
+    if (cursor->type == NUJInteger_TYPE || cursor->type == NUJDouble_TYPE)
+    {
+        token.start = cursor->start;
+        token.length = cursor->length;
+
+        if (!nuj__parse_token_to_number(token, &integer, &number))
         {
-            element = nuj_create_element_null(handle);
+            integer = (long long)number;
         }
-        break;
     }
 
-    return element;
+    return integer;
 }
 
-static NUJElement* nuj__parse_element_pair_value(NUJHandle handle, NUJParser* parser)
+// NOTE: Integers are converted.
+NUJDEF double nuj_get_cursor_double(const NUJCursor* cursor)
 {
-    NUJElement* element = 0;
-    NUJToken token = nuj__parse_get_token(parser);
+    NUJToken token = NUJ_ZERO;
+    long long integer = 0;
+    double number = 0;
 
-    switch (token.type)
+    if (cursor->type == NUJInteger_TYPE || cursor->type == NUJDouble_TYPE)
     {
-        case NUJ_STRING_TYPE:
-        case NUJ_NUMBER_TYPE:
-        case NUJ_DOUBLE_TYPE:
-        case NUJ_BOOLEAN_TYPE:
-        case NUJ_NULL_TYPE:
-        {
-            element = nuj__parse_token_to_element(handle, token);
-        }
-        break;
-        case NUJ_OBRACKET_TYPE:
-        {
-            element = nuj__parse_element_array(handle, parser);
-        }
-        break;
-        case NUJ_OBRACE_TYPE:
+        token.start = cursor->start;
+        token.length = cursor->length;
+
+        if (nuj__parse_token_to_number(token, &integer, &number))
         {
-            element = nuj__parse_element_object(handle, parser);
+            number = (double)integer;
         }
-        break;
     }
 
-    return element;
+    return number;
 }
 
-static inline void nuj__parse_set_element_pair_name(NUJHandle handle, NUJElement* element, NUJToken token)
+NUJDEF int nuj_get_cursor_boolean(const NUJCursor* cursor)
 {
-    char* name = 0;
-
-    name = nuj__push_size(handle, token.length + 1);
-    memcpy(name, token.start, token.length);
-    name[token.length] = '\0';
-    element->name = name;
+    return cursor->type == NUJBoolean_TYPE && *cursor->start == 't';
 }
 
-static NUJElement* nuj__parse_element_pair(NUJHandle handle, NUJParser* parser, int in_object)
+// NOTE: Returns 0 if the cursor is not an object or array, or it is empty.
+NUJDEF int nuj_get_cursor_first_child(const NUJCursor* cursor, NUJCursor* child)
 {
-    NUJElement* element = 0;
+    const unsigned char* current = cursor->start + 1;
+    int result = 0;
 
-    if (in_object)
+    if (cursor->type == NUJObject_TYPE || cursor->type == NUJArray_TYPE)
     {
-        NUJToken string_token = nuj__parse_get_token(parser);
-        NUJToken token = { 0 };
-
-        if (nuj__parse_match_token(string_token, NUJ_STRING_TYPE))
+        while (current < cursor->end && nuj__parse_is_whitespace_char((char)*current))
         {
-            token = nuj__parse_get_token(parser);
-        }
-        else
-        {
-            nuj__parse_error(parser, string_token, '\"');
+            ++current;
         }
 
-        if (nuj__parse_match_token(token, NUJ_COLON_TYPE))
-        {
-            element = nuj__parse_element_pair_value(handle, parser);
-            nuj__parse_set_element_pair_name(handle, element, string_token);
-        }
-        else
+        if (current < cursor->end && *current != '}' && *current != ']')
         {
-            nuj__parse_error(parser, token, ':');
+            result = nuj__read_cursor_child(child, current, cursor->end, cursor->type == NUJObject_TYPE);
         }
     }
-    else
-    {
-        element = nuj__parse_element_pair_value(handle, parser);
-    }
 
-    return element;
+    return result;
 }
 
-static inline void nuj__parse_add_element_element(NUJElement* element, NUJElement* child)
+// NOTE: Skips cursor's value, then reads the value after the comma.
+// Returns 0 after the last child.  sibling can be cursor.
+NUJDEF int nuj_get_cursor_next_sibling(const NUJCursor* cursor, NUJCursor* sibling)
 {
-    NUJObject* nuj_object = NUJ_OBJECT(element);
-
-    NUJ_ASSERT(nuj_object->child_count < nuj_object->max_child_count);
-
-    nuj_object->children[nuj_object->child_count++] = child;
-    child->parent = element;
+    return nuj_get_cursor_sibling_at(cursor, nuj_skip_cursor(cursor), sibling);
 }
 
-static NUJElement* nuj__parse_create_element_object_or_array(NUJElement* element, NUJElement* first_element)
+// NOTE: Like nuj_get_cursor_next_sibling when the end of cursor's
+// value is already known, current is the char after it, so a value
+// whose children were read isn't skipped again.
+NUJDEF int nuj_get_cursor_sibling_at(const NUJCursor* cursor, const unsigned char* current, NUJCursor* sibling)
 {
-    NUJElement* el = 0;
-    unsigned long long element_offset = 0;
-    unsigned int i = 0;
+    int result = 0;
 
-    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+    while (current && current < cursor->end && nuj__parse_is_whitespace_char((char)*current))
+    {
+        ++current;
+    }
 
-    for (i = 0; i < NUJ_OBJECT(element)->max_child_count; ++i)
+    if (current && current < cursor->end && *current == ',')
     {
-        el = (NUJElement*)((unsigned char*)first_element + element_offset);
+        result = nuj__read_cursor_child(sibling, current + 1, cursor->end, cursor->name != 0);
+    }
+
+    return result;
+}
 
-        nuj__parse_add_element_element(element, el);
+NUJDEF int nuj_get_cursor_child(const NUJCursor* cursor, unsigned int index, NUJCursor* child)
+{
+    int result = nuj_get_cursor_first_child(cursor, child);
 
-        switch (el->type)
-        {
-            case NUJObject_TYPE:
-            case NUJArray_TYPE:
-            {
-                element_offset += nuj__get_total_element_object_size(el);
-            }
-            break;
-            case NUJString_TYPE:
-            case NUJDouble_TYPE:
-            case NUJInteger_TYPE:
-            case NUJBoolean_TYPE:
-            case NUJNull_TYPE:
-            {
-                element_offset += nuj__get_element_size(el);
-            }
-            break;
-            default:
-            {
-                NUJ_ASSERT(!"Unexpected type!");
-            }
-            break;
-        }
+    while (result && index--)
+    {
+        result = nuj_get_cursor_next_sibling(child, child);
     }
 
-    return element;
+    return result;
 }
 
-// TODO: Size of NUJObject and NUJArray types depend on how many
-// children they have.  So, we use this function to determine child
-// count they have before creating NUJObject/NUJArray, but this way of
-// counting children is very unefficient because we basically run
-// tokenizer 2 times for each NUJObject/NUJArray.  Also, we work on
-// one big memory chunk and utilize linearity of memory. Allocating
-// elements linearly and having dynamic elements (NUJObject/NUJArray)
-// makes it difficult to change this method of counting.
-static unsigned int nuj__parse_calculate_element_child_count(NUJParser* parser, unsigned int type)
+// NOTE: Walks all children, so it is linear in the size of the value.
+NUJDEF unsigned int nuj_get_cursor_child_count(const NUJCursor* cursor)
 {
-    unsigned int level = 0;
-    NUJParser current_parser = *parser;
-    NUJToken token = { 0 };
-    NUJTokenType last_token_type = type == NUJObject_TYPE ? NUJ_OBRACE_TYPE : NUJ_OBRACKET_TYPE;
-    unsigned int element_count = 0;
-    int done = 0;
+    NUJCursor child = NUJ_ZERO;
+    unsigned int count = 0;
+    int found = nuj_get_cursor_first_child(cursor, &child);
+
+    while (found)
+    {
+        ++count;
+        found = nuj_get_cursor_next_sibling(&child, &child);
+    }
 
-    // TODO: Maybe it is not good idea to do this with tokens?
-    // We could just operate on raw strings but does it matter?
+    return count;
+}
 
-    NUJ_ASSERT(type == NUJObject_TYPE || type == NUJArray_TYPE);
+// NOTE: First child of an object named name, like nuj_find_child_by_name.
+NUJDEF int nuj_find_cursor_child(const NUJCursor* cursor, const char* name, NUJCursor* child)
+{
+    unsigned int length = (unsigned int)strlen(name);
+    int found = 0;
+    int result = 0;
 
-    while (!done)
+    if (cursor->type == NUJObject_TYPE)
     {
-        token = nuj__parse_get_token(&current_parser);
+        found = nuj_get_cursor_first_child(cursor, child);
 
-        switch (token.type)
+        while (found && !result)
         {
-            // NOTE: Error?
-            case NUJ_EOF_TYPE:
-            case NUJ_UNKNOWN_TYPE:
-            {
-                done = 1;
-                element_count = 0;
-            }
-            break;
-            case NUJ_OBRACE_TYPE:
-            case NUJ_OBRACKET_TYPE:
-            {
-                ++level;
-            }
-            break;
-            case NUJ_COMMA_TYPE:
-            {
-                if (level == 0)
-                {
-                    ++element_count;
-                }
-            }
-            break;
-            case NUJ_CBRACE_TYPE:
-            case NUJ_CBRACKET_TYPE:
-            {
-                if (level == 0)
-                {
-                    if (last_token_type == NUJ_OBRACE_TYPE || last_token_type == NUJ_OBRACKET_TYPE)
-                    {
-                        element_count = 0;
-                    }
-                    else
-                    {
-                        ++element_count;
-                    }
+            result = nuj__match_cursor_name(child, name, length);
 
-                    done = 1;
-                }
-                else
-                {
-                    --level;
-                }
+            if (!result)
+            {
+                found = nuj_get_cursor_next_sibling(child, child);
             }
-            break;
         }
+    }
+
+    return result;
+}
+
+// NOTE: Returns the char after the value, or 0 if it isn't closed.
+NUJDEF const unsigned char* nuj_skip_cursor(const NUJCursor* cursor)
+{
+    const unsigned char* result = 0;
 
-        last_token_type = token.type;
+    if (cursor->type == NUJObject_TYPE || cursor->type == NUJArray_TYPE)
+    {
+        result = nuj__skip_container(cursor->start, cursor->end);
+    }
+    else if (cursor->type != NUJNone_TYPE)
+    {
+        result = cursor->start + cursor->length;
     }
 
-    return element_count;
+    return result;
 }
 
-static NUJElement* nuj__parse_element_array(NUJHandle handle, NUJParser* parser)
+NUJDEF NUJElement* nuj_parse(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size)
 {
-    NUJToken token = { 0 };
-    int done = 0;
-    NUJElement* array_element = 0;
-    NUJElement* first_element = 0;
-    unsigned int element_count = nuj__parse_calculate_element_child_count(parser, NUJArray_TYPE);
+    return nuj_parse_flags(handle, buffer, buffer_size, 0);
+}
 
-    array_element = nuj_create_element_array(handle, element_count);
+// NOTE: Parses a buffer that may be overwritten.  Strings and names
+// are decoded in place and null terminated at their closing quote, so
+// they take no space in the handle.  The buffer must outlive the
+// elements, nuj_measure_flags with NUJ_PARSE_VIEWS gives the size.
+NUJDEF NUJElement* nuj_parse_insitu(NUJHandle handle, unsigned char* buffer, unsigned long long buffer_size, unsigned int flags)
+{
+    return nuj_parse_flags(handle, buffer, buffer_size, flags | NUJ_PARSE_VIEWS | NUJ_PARSE_INSITU);
+}
 
-    if (element_count)
+NUJDEF NUJElement* nuj_parse_flags(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags)
+{
+    NUJ_STATS_BEGIN(start_cycles)
+    NUJParser parser = NUJ_ZERO;
+    NUJElement* element = 0;
+    int parsing = 1;
+    NUJToken token = NUJ_ZERO;
+
+    nuj__parse_init(&parser, buffer, buffer_size);
+    parser.flags = flags;
+    NUJ_STATS_ATTACH(&parser, handle);
+    token = nuj__parse_get_token(&parser);
+
+    if (handle && handle->buffer_used && handle->buffer_size)
     {
-        first_element = nuj__parse_element_pair(handle, parser, 0);
+        nuj_reset_used_size(handle);
     }
 
-    while (!done)
+    if (nuj__parse_match_token(token, NUJ_OBRACE_TYPE))
     {
-        token = nuj__parse_get_token(parser);
+        element = nuj__parse_element_object(handle, &parser);
 
-        switch (token.type)
+        while (parsing)
         {
-            case NUJ_COMMA_TYPE:
-            {
-                nuj__parse_element_pair(handle, parser, 0);
-            }
-            break;
-            case NUJ_CBRACKET_TYPE:
-            {
-                done = 1;
-            }
-            break;
-            default:
+            token = nuj__parse_get_token(&parser);
+
+            switch (token.type)
             {
-                nuj__parse_error(parser, token, ',');
+                case NUJ_EOF_TYPE:
+                case NUJ_CBRACE_TYPE:
+                {
+                    parsing = 0;
+                }
+                break;
+
+                default:
+                {
+                    nuj__parse_error(&parser, token, '}');
+                }
+                break;
             }
-            break;
         }
     }
-
-    if (element_count)
+    else
     {
-        array_element = nuj__parse_create_element_object_or_array(array_element, first_element);
+        nuj__parse_error(&parser, token, '{');
     }
 
-    return array_element;
+    NUJ_STATS_PARSED(&parser, start_cycles);
+
+    return parser.failed ? 0 : element;
 }
 
-static NUJElement* nuj__parse_element_object(NUJHandle handle, NUJParser* parser)
+// NOTE: Maps a file read only, *size is set to its size.  Parsers
+// stop at buffer_size, so the mapping can be passed to them as is, no
+// copy or null terminator needed.  The pages are advised as read
+// sequentially and soon.  Without mmap the file is read into memory
+// from malloc.  Returns 0 if the file can't be mapped or is empty.
+NUJDEF const unsigned char* nuj_map_file(const char* path, unsigned long long* size)
 {
-    NUJToken token = { 0 };
-    int done = 0;
-    NUJElement* object_element = 0;
-    NUJElement* first_element = 0;
-    unsigned int element_count = nuj__parse_calculate_element_child_count(parser, NUJObject_TYPE);
+    const unsigned char* memory = 0;
 
-    object_element = nuj_create_element_object(handle, element_count);
-
-    // NOTE: If it is object with 0 child skip this and find '}' token.
-    if (element_count)
-    {
-        first_element = nuj__parse_element_pair(handle, parser, 1);
-    }
+    *size = 0;
 
-    while (!done)
+#if defined(NUJ_POSIX_MMAP)
     {
-        token = nuj__parse_get_token(parser);
+        int file = open(path, O_RDONLY);
+        struct stat file_stat;
 
-        switch (token.type)
+        if (file >= 0)
         {
-            case NUJ_COMMA_TYPE:
-            {
-                nuj__parse_element_pair(handle, parser, 1);
-            }
-            break;
-            case NUJ_CBRACE_TYPE:
+            if (!fstat(file, &file_stat) && file_stat.st_size > 0)
             {
-                done = 1;
+                void* mapped = mmap(0, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+                if (mapped != MAP_FAILED)
+                {
+#if defined(MADV_SEQUENTIAL)
+                    madvise(mapped, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+                    madvise(mapped, (size_t)file_stat.st_size, MADV_WILLNEED);
+#elif defined(POSIX_MADV_SEQUENTIAL)
+                    posix_madvise(mapped, (size_t)file_stat.st_size, POSIX_MADV_SEQUENTIAL);
+                    posix_madvise(mapped, (size_t)file_stat.st_size, POSIX_MADV_WILLNEED);
+#endif
+                    memory = (const unsigned char*)mapped;
+                    *size = (unsigned long long)file_stat.st_size;
+                }
             }
-            break;
-            default:
+
+            close(file);
+        }
+    }
+#elif defined(NUJ_WIN32_MMAP)
+    {
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        LARGE_INTEGER file_size;
+
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
             {
-                nuj__parse_error(parser, token, ',');
+                // NOTE: The view keeps the mapping open.
+                HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+
+                if (mapping)
+                {
+                    memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    *size = memory ? (unsigned long long)file_size.QuadPart : 0;
+                    CloseHandle(mapping);
+                }
             }
-            break;
+
+            CloseHandle(file);
         }
     }
-
-    if (element_count)
+#elif !defined(NUJ_NO_STDIO) && !defined(NUJ_NO_STDLIB)
     {
-        object_element = nuj__parse_create_element_object_or_array(object_element, first_element);
-    }
-
-    return object_element;
-}
+        FILE* file = fopen(path, "rb");
 
-// NOTE: Pre-allocated buffer by size.
-NUJDEF NUJHandle nuj_init(void* memory, unsigned long long size)
-{
-    NUJHandle nuj_handle = (NUJHandle)memory;
+        if (file)
+        {
+            long file_size = 0;
 
-    nuj_handle->buffer = (unsigned char*)memory + sizeof(NUJHandleInternal);
-    nuj_handle->buffer_used = sizeof(NUJHandleInternal);
-    nuj_handle->buffer_size = size - sizeof(NUJHandleInternal);
+            if (!fseek(file, 0, SEEK_END) && (file_size = ftell(file)) > 0 && !fseek(file, 0, SEEK_SET))
+            {
+                unsigned char* buffer = (unsigned char*)malloc((size_t)file_size);
 
-    return nuj_handle;
-}
+                if (buffer && fread(buffer, 1, (size_t)file_size, file) == (size_t)file_size)
+                {
+                    memory = buffer;
+                    *size = (unsigned long long)file_size;
+                }
+                else
+                {
+                    free(buffer);
+                }
+            }
 
-NUJDEF void nuj_reset_used_size(NUJHandle handle)
-{
-    handle->buffer_used = 0;
-}
+            fclose(file);
+        }
+    }
+#else
+    (void)path;
+#endif
 
-NUJDEF unsigned long long nuj_get_used_size(const NUJHandle handle)
-{
-    return handle->buffer_used;
+    return memory;
 }
 
-NUJDEF NUJElement* nuj_create_element(NUJHandle handle, unsigned int type, unsigned int size)
+NUJDEF void nuj_unmap_file(const unsigned char* memory, unsigned long long size)
 {
-    NUJElement* element = nuj__push_size(handle, size);
-
-    element->type = (unsigned long long)type;
-    element->parent = 0;
+    (void)size;
 
-    return element;
+    if (memory)
+    {
+#if defined(NUJ_POSIX_MMAP)
+        munmap((void*)memory, (size_t)size);
+#elif defined(NUJ_WIN32_MMAP)
+        UnmapViewOfFile(memory);
+#elif !defined(NUJ_NO_STDIO) && !defined(NUJ_NO_STDLIB)
+        free((void*)memory);
+#endif
+    }
 }
 
-NUJDEF NUJElement* nuj_create_element_string(NUJHandle handle, const char* string)
+// NOTE: Parses a file through nuj_map_file.  The file is unmapped
+// before returning, so strings are always copied and NUJ_PARSE_VIEWS
+// is ignored, map the file yourself to keep views into it.  Returns 0
+// if the file can't be read, the handle is full or, with
+// NUJ_PARSE_SOFT_ERRORS, the file is invalid.
+NUJDEF NUJElement* nuj_parse_file(NUJHandle handle, const char* path, unsigned int flags)
 {
-    NUJString* nuj_string = NUJ_CREATE_ELEMENT(handle, NUJString);
+    unsigned long long size = 0;
+    const unsigned char* memory = nuj_map_file(path, &size);
+    NUJElement* element = 0;
 
-    nuj_string->value = string;
+    if (memory)
+    {
+        element = nuj_parse_flags(handle, memory, size, flags & ~(unsigned int)NUJ_PARSE_VIEWS);
+        nuj_unmap_file(memory, size);
+    }
 
-    return &nuj_string->element;
+    return element;
 }
 
-NUJDEF NUJElement* nuj_create_element_integer(NUJHandle handle, long long value)
+// NOTE: Returns exactly how many bytes nuj_parse will push to a
+// handle without an intern table for this buffer (what
+// nuj_get_used_size returns after it), or 0 if the buffer is not a
+// valid JSON object.  With a table, names it has are not pushed, so
+// this is an upper bound.  Only tokens are visited and nothing is
+// written, so this is much cheaper than parsing.
+NUJDEF unsigned long long nuj_measure(const unsigned char* buffer, unsigned long long buffer_size)
 {
-    NUJInteger* nuj_integer = NUJ_CREATE_ELEMENT(handle, NUJInteger);
-
-    nuj_integer->value = value;
-
-    return &nuj_integer->element;
+    return nuj_measure_flags(buffer, buffer_size, 0);
 }
 
-NUJDEF NUJElement* nuj_create_element_double(NUJHandle handle, double value)
+NUJDEF unsigned long long nuj_measure_flags(const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags)
 {
-    NUJDouble* nuj_double = NUJ_CREATE_ELEMENT(handle, NUJDouble);
-
-    nuj_double->value = value;
+    NUJParser parser = NUJ_ZERO;
+    NUJToken token = NUJ_ZERO;
+    unsigned long long size = 0;
 
-    return &nuj_double->element;
-}
+    nuj__parse_init(&parser, buffer, buffer_size);
+    parser.flags = flags;
+    token = nuj__parse_get_token(&parser);
 
-NUJDEF NUJElement* nuj_create_element_boolean(NUJHandle handle, int value)
-{
-    NUJBoolean* nuj_boolean = NUJ_CREATE_ELEMENT(handle, NUJBoolean);
+    if (nuj__parse_match_token(token, NUJ_OBRACE_TYPE))
+    {
+        size = nuj__measure_element(&parser, token);
+    }
 
-    nuj_boolean->value = value;
+    // NOTE: Anything after the root fails nuj_parse, so it must not be
+    // measured.
+    if (size && !nuj__parse_match_token(nuj__parse_get_token(&parser), NUJ_EOF_TYPE))
+    {
+        size = 0;
+    }
 
-    return &nuj_boolean->element;
+    return size;
 }
 
-NUJDEF NUJElement* nuj_create_element_null(NUJHandle handle)
+// NOTE: Number of records in newline delimited JSON, blank lines are
+// not records.
+NUJDEF unsigned long long nuj_count_lines(const unsigned char* buffer, unsigned long long buffer_size)
 {
-    NUJNull* nuj_null = NUJ_CREATE_ELEMENT(handle, NUJNull);
+    NUJLinesWorker worker = NUJ_ZERO;
 
-    nuj_null->value = 0;
+    worker.start = buffer;
+    worker.end = buffer + buffer_size;
+    nuj__count_lines_worker(&worker);
 
-    return &nuj_null->element;
+    return worker.record_count;
 }
 
-NUJDEF NUJElement* nuj_create_element_object(NUJHandle handle, unsigned int element_count)
+// NOTE: Parses newline delimited JSON (JSON Lines) on handle_count
+// threads, each one pushing to its own handle, which isn't reset.
+// roots[i] is the i-th record, or 0 if it is invalid or its handle is
+// full.  At most root_count records are parsed, returns how many were.
+// Handles should be chained if the size isn't known, chained handles
+// allocate from several threads at once.
+NUJDEF unsigned long long nuj_parse_lines(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count)
 {
-    NUJObject* nuj_object = NUJ_CREATE_ELEMENT(handle, NUJObject);
-
-    nuj_object->child_count = 0;
-    nuj_object->max_child_count = element_count;
-    nuj_object->children = nuj__push_size(handle, element_count * sizeof(NUJElement*));
-
-    return &nuj_object->element;
+    return nuj__parse_lines(handles, handle_count, buffer, buffer_size, flags, roots, root_count, 0);
 }
 
-NUJDEF NUJElement* nuj_create_element_array(NUJHandle handle, unsigned int element_count)
+// NOTE: Like nuj_parse_lines for streams, only lines ending with a
+// newline are parsed.  consumed_size is set to the end of the lines
+// that were parsed, the rest of the buffer is for the next call.
+NUJDEF unsigned long long nuj_parse_lines_partial(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags, NUJElement** roots, unsigned long long root_count, unsigned long long* consumed_size)
 {
-    NUJArray* nuj_array = NUJ_CREATE_ELEMENT(handle, NUJArray);
+    NUJ_ASSERT(consumed_size);
 
-    nuj_array->child_count = 0;
-    nuj_array->max_child_count = element_count;
-    nuj_array->children = nuj__push_size(handle, element_count * sizeof(NUJElement*));
-
-    return &nuj_array->element;
+    return nuj__parse_lines(handles, handle_count, buffer, buffer_size, flags, roots, root_count, consumed_size);
 }
 
-NUJDEF NUJElement* nuj_add_element_element(NUJElement* element, const char* name, NUJElement* child)
+// NOTE: Parses a document whose root is an object or an array on
+// handle_count threads.  The root is cut into slices at commas found by
+// nuj__find_split and each slice is parsed to its own handle.  A slice
+// that doesn't end exactly at the next one's comma means a split was
+// wrong, then the document is parsed again on handles[0] alone.  That
+// mostly happens to roots with a few children, each much larger than
+// NUJ_PARALLEL_SLICE_SIZE, which are better parsed by nuj_parse.  The
+// root and its children array are pushed to handles[0].  Handles are
+// reset like in nuj_parse and should be chained.  Returns 0 if the
+// document is invalid or a handle is full.
+NUJDEF NUJElement* nuj_parse_parallel(NUJHandle* handles, unsigned int handle_count, const unsigned char* buffer, unsigned long long buffer_size, unsigned int flags)
 {
-    NUJObject* nuj_object = 0;
+    NUJSliceWorker workers[NUJ_MAX_THREAD_COUNT];
+    const unsigned char* start = buffer;
+    const unsigned char* end = buffer + (buffer_size ? buffer_size : strlen((const char*)buffer));
+    NUJElement* root = 0;
+    NUJElement** children = 0;
+    unsigned long long slice_size = 0;
+    unsigned long long child_count = 0;
+    unsigned int worker_count = handle_count < NUJ_MAX_THREAD_COUNT ? handle_count : NUJ_MAX_THREAD_COUNT;
+    unsigned int slice_count = 0;
+    unsigned int i = 0;
+    int in_object = 0;
 
-    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+    NUJ_ASSERT(worker_count);
+    NUJ_ASSERT(nuj__can_share_intern_tables(handles, handle_count));
 
-    nuj_object = NUJ_OBJECT(element);
+    for (i = 0; i < handle_count; ++i)
+    {
+        if (handles[i]->buffer_used && handles[i]->buffer_size)
+        {
+            nuj_reset_used_size(handles[i]);
+        }
+    }
 
-    NUJ_ASSERT(nuj_object->child_count < nuj_object->max_child_count);
+    while (start < end && nuj__parse_is_whitespace_char((char)*start))
+    {
+        ++start;
+    }
 
-    child->name = name;
-    nuj_object->children[nuj_object->child_count++] = child;
+    while (end > start && nuj__parse_is_whitespace_char((char)end[-1]))
+    {
+        --end;
+    }
 
-    if (!child->parent)
+    if (end - start < 2 || !((*start == '[' && end[-1] == ']') || (*start == '{' && end[-1] == '}')))
     {
-        child->parent = element;
+        return 0;
     }
 
-    return child;
-}
+    in_object = *start == '{';
+    root = in_object ? nuj_create_element_object(handles[0], 0) : nuj_create_element_array(handles[0], 0);
 
-NUJDEF int nuj_is_last_object_element(const NUJElement* element)
-{
-    NUJElement* parent = element->parent;
-    NUJObject* parent_object = NUJ_OBJECT(parent);
-    int result = (!parent ||
-                  ((parent->type == NUJObject_TYPE || parent->type == NUJArray_TYPE) &&
-                   parent_object->children[parent_object->child_count - 1] == element));
+    // NOTE: From here on start and end are the inside of the root.
+    ++start;
+    --end;
 
-    return result;
-}
+    while (start < end && nuj__parse_is_whitespace_char((char)*start))
+    {
+        ++start;
+    }
 
-NUJDEF void nuj_printf(const NUJElement* element)
-{
-    nuj__printf(element, 0);
-}
+    if (start == end || !root)
+    {
+        return root;
+    }
 
-NUJDEF void nuj_print(const NUJElement* element)
-{
-    if (!element)
-        return;
+    slice_size = (unsigned long long)(end - start) / worker_count;
 
-    if (element->name)
+    if (slice_size < NUJ_PARALLEL_SLICE_SIZE)
     {
-        printf("\"%s\":", element->name);
+        slice_size = NUJ_PARALLEL_SLICE_SIZE;
+        worker_count = (unsigned int)((unsigned long long)(end - start) / slice_size) + 1;
     }
 
-    if (element->type == NUJObject_TYPE)
+    for (i = 0; i < worker_count; ++i)
     {
-        printf("{");
+        const unsigned char* scan_end = start + slice_size * (i + 1);
+
+        workers[i].handle = handles[i];
+        workers[i].begin = buffer;
+        workers[i].start = start + slice_size * i;
+        workers[i].scan_end = scan_end < end ? scan_end : end;
+        workers[i].flags = flags;
+        workers[i].in_object = in_object;
     }
-    else if (element->type == NUJArray_TYPE)
+
+    nuj__run_workers(workers + 1, sizeof(*workers), worker_count - 1, nuj__split_slice_worker);
+
+    // NOTE: Workers that found no split, or the same one as a worker
+    // before them, are dropped.  Each slice ends at the comma before the
+    // next one.
+    slice_count = 1;
+
+    for (i = 1; i < worker_count; ++i)
     {
-        printf("[");
+        if (workers[i].start && workers[i].start > workers[slice_count - 1].start)
+        {
+            workers[slice_count - 1].end = workers[i].start - 1;
+            workers[slice_count].handle = handles[slice_count];
+            workers[slice_count].start = workers[i].start;
+            ++slice_count;
+        }
     }
-    else
+
+    workers[slice_count - 1].end = end;
+
+    nuj__run_workers(workers, sizeof(*workers), slice_count, nuj__parse_slice_worker);
+
+    for (i = 0; i < slice_count; ++i)
     {
-        nuj__print_primitive_element(element);
+        if (workers[i].failed)
+        {
+            break;
+        }
     }
 
-    if (element->type == NUJObject_TYPE || element->type == NUJArray_TYPE)
+    if (i < slice_count)
     {
-        unsigned int i = 0;
-
-        for (i = 0; i < NUJ_COBJECT(element)->child_count; ++i)
+        for (i = 0; i < slice_count; ++i)
         {
-            nuj_print(NUJ_COBJECT(element)->children[i]);
+            if (handles[i]->buffer_used && handles[i]->buffer_size)
+            {
+                nuj_reset_used_size(handles[i]);
+            }
         }
 
-        printf("%s", element->type == NUJObject_TYPE ? "}" : element->type == NUJArray_TYPE ? "]" : 0);
+        root = in_object ? nuj_create_element_object(handles[0], 0) : nuj_create_element_array(handles[0], 0);
+        workers[0].start = start;
+        workers[0].end = end;
+        slice_count = 1;
+        nuj__parse_slice_worker(&workers[0]);
 
-        if (!nuj_is_last_object_element(element))
+        if (workers[0].failed || !root)
         {
-            printf(",");
+            return 0;
         }
     }
-}
 
-// TODO: Probably, it is not good idea to iterate all elements until we find it.
-// Hash or something similar would be better but how we should do it?
-NUJDEF NUJElement* nuj_find_element_by_name(const NUJElement* element, const char* name)
-{
-    NUJElement* found = 0;
-    NUJElement* el = 0;
-    unsigned int i = 0;
+    for (i = 0; i < slice_count; ++i)
+    {
+        child_count += workers[i].element_count;
+    }
 
-    NUJ_ASSERT(element->type == NUJObject_TYPE || element->type == NUJArray_TYPE);
+    NUJ_ASSERT(child_count <= 0xFFFFFFFFu / sizeof(NUJElement*));
 
-    for (i = 0; !found && i < NUJ_COBJECT(element)->child_count; ++i)
-    {
-        el = NUJ_OBJECT(element)->children[i];
+    children = (NUJElement**)nuj__push_size(handles[0], (unsigned int)(child_count * sizeof(NUJElement*)));
 
-        if (el->name && !strcmp(el->name, name))
-        {
-            found = el;
-        }
+    if (!children)
+    {
+        return 0;
     }
 
-    if (!found)
+    NUJ_OBJECT(root)->children = children;
+    NUJ_OBJECT(root)->child_count = (unsigned int)child_count;
+    NUJ_OBJECT(root)->max_child_count = (unsigned int)child_count;
+
+    // NOTE: Children are linked backwards, so slices are stitched from
+    // the last one.
+    for (i = slice_count; i--;)
     {
-        for (i = 0; !found && i < NUJ_COBJECT(element)->child_count; ++i)
+        NUJElement* element = workers[i].last_element;
+        unsigned int j = workers[i].element_count;
+
+        while (j--)
         {
-            el = NUJ_OBJECT(element)->children[i];
+            NUJElement* previous = element->parent;
 
-            if (el->type == NUJObject_TYPE || el->type == NUJArray_TYPE)
-            {
-                found = nuj_find_element_by_name(el, name);
-            }
+            children[--child_count] = element;
+            element->parent = root;
+            element = previous;
         }
     }
 
-    return found;
+    if (in_object && (flags & NUJ_PARSE_INDEX_KEYS) && NUJ_CHILD_COUNT(root) >= NUJ_KEY_INDEX_MIN_COUNT)
+    {
+        nuj__create_key_index(handles[0], root);
+    }
+
+    return root;
 }
 
-NUJDEF NUJElement* nuj_parse(NUJHandle handle, const unsigned char* buffer, unsigned long long buffer_size)
+// NOTE: Runs the tokenizer and reports every value to the callbacks
+// without building elements, the handle is not needed at all.  Any
+// value is accepted as the root.  Returns 1 if the whole buffer was
+// parsed.
+NUJDEF int nuj_sax_parse(const NUJCallbacks* callbacks, const unsigned char* buffer, unsigned long long buffer_size)
 {
-    NUJParser parser = { .initial = buffer, .current = buffer };
-    NUJElement* element = 0;
-    int parsing = 1;
-    NUJToken token = nuj__parse_get_token(&parser);
+    NUJParser parser = NUJ_ZERO;
+    int result = 0;
 
-    if (handle && handle->buffer_used && handle->buffer_size)
+    nuj__parse_init(&parser, buffer, buffer_size);
+
+    result = nuj__sax_element(&parser, nuj__parse_get_token(&parser), callbacks) &&
+             nuj__parse_match_token(nuj__parse_get_token(&parser), NUJ_EOF_TYPE);
+
+    return result;
+}
+
+// NOTE: Starts an incremental parse into the handle.  Chunks are fed
+// with nuj_push_feed as they arrive and don't have to outlive the
+// call, and nuj_push_end returns the same tree nuj_parse would build
+// for the whole input.  The handle is reset, and the parser state is
+// kept in it too.  Strings are always copied, NUJ_PARSE_VIEWS is
+// ignored.  Returns 0 if the handle can't hold the state, nuj_push_feed
+// returns 0 when the handle is full.
+NUJDEF NUJPushParser* nuj_push_begin(NUJHandle handle, unsigned int flags)
+{
+    NUJPushParser* parser = 0;
+
+    nuj_reset_used_size(handle);
+
+    parser = (NUJPushParser*)nuj__push_size(handle, sizeof(NUJPushParser));
+
+    if (parser)
     {
-        nuj_reset_used_size(handle);
+        memset(parser, 0, sizeof(NUJPushParser));
+        parser->handle = handle;
+        parser->flags = flags;
+        parser->state = NUJ_PUSH_ROOT_STATE;
     }
 
-    // TODO: Probably we should use this.
-    (void)buffer_size;
+    return parser;
+}
 
-    if (nuj__parse_match_token(token, NUJ_OBRACE_TYPE))
+// NOTE: Returns 0 once the input is known to be invalid, or the handle
+// is full.
+NUJDEF int nuj_push_feed(NUJPushParser* parser, const unsigned char* chunk, unsigned long long chunk_size)
+{
+    const unsigned char* current = chunk;
+    const unsigned char* end = chunk + chunk_size;
+    int result = 1;
+
+    while (result && current < end)
     {
-        element = nuj__parse_element_object(handle, &parser);
+        unsigned char character = *current;
 
-        while (parsing)
+        switch (parser->state)
         {
-            token = nuj__parse_get_token(&parser);
+            case NUJ_PUSH_STRING_STATE:
+            {
+                const unsigned char* start = current;
+                int escaped = parser->escaped;
 
-            switch (token.type)
+                while (current < end)
+                {
+                    character = *current;
+
+                    if (escaped)
+                    {
+                        escaped = 0;
+                    }
+                    else if (character == '\\')
+                    {
+                        escaped = 1;
+                    }
+                    else if (character == '"' || character == '\0')
+                    {
+                        break;
+                    }
+
+                    ++current;
+                }
+
+                if (current != start)
+                {
+                    unsigned int length = (unsigned int)(current - start);
+                    char* string = (char*)nuj__grow_size(parser->handle, parser->string, parser->string_length, length);
+
+                    if (string)
+                    {
+                        memcpy(string + parser->string_length, start, length);
+                        parser->string = string;
+                        parser->string_length += length;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+
+                parser->escaped = escaped;
+
+                if (result && current < end)
+                {
+                    result = character == '"' && nuj__push_end_string(parser);
+                    ++current;
+                }
+            }
+            break;
+            case NUJ_PUSH_NUMBER_STATE:
             {
-                case NUJ_EOF_TYPE:
-                case NUJ_CBRACE_TYPE:
+                if (nuj__parse_is_numeric((char)character) || character == '-' || character == '+' ||
+                    character == 'e' || character == 'E')
                 {
-                    parsing = 0;
+                    result = parser->number_length < NUJ_PUSH_MAX_NUMBER_LENGTH;
+                    parser->number[parser->number_length++] = (char)character;
+                    ++current;
                 }
-                break;
+                else
+                {
+                    // NOTE: Delimiter is handled by the next state.
+                    result = nuj__push_end_number(parser);
+                }
+            }
+            break;
+            case NUJ_PUSH_LITERAL_STATE:
+            {
+                result = character == (unsigned char)parser->literal[parser->literal_index++];
 
-                default:
+                if (result && !parser->literal[parser->literal_index])
                 {
-                    nuj__parse_error(&parser, token, '}');
+                    NUJElement* element = parser->literal[0] == 'n' ? nuj_create_element_null(parser->handle) :
+                                          nuj_create_element_boolean(parser->handle, parser->literal[0] == 't');
+
+                    result = nuj__push_add_element(parser, element);
                 }
-                break;
+
+                ++current;
+            }
+            break;
+            case NUJ_PUSH_ERROR_STATE:
+            {
+                result = 0;
+            }
+            break;
+            default:
+            {
+                if (nuj__parse_is_whitespace_char((char)character))
+                {
+                    ++current;
+                    break;
+                }
+
+                switch (parser->state)
+                {
+                    case NUJ_PUSH_ROOT_STATE:
+                    {
+                        result = character == '{' && nuj__push_begin_value(parser, character);
+                    }
+                    break;
+                    case NUJ_PUSH_VALUE_OR_CLOSE_STATE:
+                    case NUJ_PUSH_VALUE_STATE:
+                    {
+                        if (character == ']' && parser->state == NUJ_PUSH_VALUE_OR_CLOSE_STATE)
+                        {
+                            result = nuj__push_close_element(parser, character);
+                        }
+                        else
+                        {
+                            result = nuj__push_begin_value(parser, character);
+                        }
+                    }
+                    break;
+                    case NUJ_PUSH_KEY_OR_CLOSE_STATE:
+                    case NUJ_PUSH_KEY_STATE:
+                    {
+                        if (character == '}' && parser->state == NUJ_PUSH_KEY_OR_CLOSE_STATE)
+                        {
+                            result = nuj__push_close_element(parser, character);
+                        }
+                        else if (character == '"')
+                        {
+                            parser->in_key = 1;
+                            parser->escaped = 0;
+                            parser->string = (char*)nuj__push_size(parser->handle, 0);
+                            parser->string_length = 0;
+                            parser->state = NUJ_PUSH_STRING_STATE;
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
+                    }
+                    break;
+                    case NUJ_PUSH_COLON_STATE:
+                    {
+                        result = character == ':';
+                        parser->state = NUJ_PUSH_VALUE_STATE;
+                    }
+                    break;
+                    case NUJ_PUSH_COMMA_OR_CLOSE_STATE:
+                    {
+                        if (character == ',')
+                        {
+                            parser->state = parser->frames[parser->depth - 1].element->type == NUJObject_TYPE ?
+                                            NUJ_PUSH_KEY_STATE : NUJ_PUSH_VALUE_STATE;
+                        }
+                        else
+                        {
+                            result = nuj__push_close_element(parser, character);
+                        }
+                    }
+                    break;
+                    default:
+                    {
+                        result = 0;
+                    }
+                    break;
+                }
+
+                ++current;
             }
+            break;
         }
     }
-    else
+
+    if (!result)
     {
-        nuj__parse_error(&parser, token, '{');
+        parser->state = NUJ_PUSH_ERROR_STATE;
+    }
+
+    return result;
+}
+
+// NOTE: Returns the root element, or 0 if the input was invalid or
+// incomplete.
+NUJDEF NUJElement* nuj_push_end(NUJPushParser* parser)
+{
+    NUJElement* element = 0;
+
+    if (parser->state == NUJ_PUSH_DONE_STATE)
+    {
+        element = parser->root;
     }
 
     return element;
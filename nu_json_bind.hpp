@@ -0,0 +1,332 @@
+#ifndef H_NUJ_BIND_HPP
+
+// NOTE: C++ binding that reads JSON straight into structs.  It walks
+// the document with the NUJCursor functions, so there is no element
+// tree and no handle.  The fields of a struct are declared once, with
+// NUJ_FIELDS in the struct's namespace:
+//
+//     struct Point
+//     {
+//         int x;
+//         double y;
+//         std::string name;
+//         std::vector<int> tags;
+//     };
+//
+//     NUJ_FIELDS(Point, x, y, name, tags)
+//
+//     Point point;
+//     bool ok = nuj::parse(point, buffer, buffer_size);
+//
+// Keys are dispatched with a switch on a hash of the name that is
+// computed at compile time.  Two fields of a struct with the same hash
+// don't compile, so the switch is a perfect hash of the fields.
+// Unknown keys are skipped.  Missing keys and nulls leave the field as
+// it is.  A field can be bool, an integer, a float, std::string, a
+// struct with NUJ_FIELDS, or a std::vector of any of them.  Values of
+// the wrong type or out of range fail the parse.
+//
+// The functions of nu_json.h are used, so include this where its
+// implementation is, see NUJDEF.
+
+// NOTE: nu_json.h needs these for booleans.
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#include "nu_json.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#define NUJ_EXPAND(x) x
+
+#define NUJ_FOR_EACH_1(macro, x) macro(x)
+#define NUJ_FOR_EACH_2(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_1(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_3(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_2(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_4(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_3(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_5(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_4(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_6(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_5(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_7(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_6(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_8(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_7(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_9(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_8(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_10(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_9(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_11(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_10(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_12(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_11(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_13(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_12(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_14(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_13(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_15(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_14(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_16(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_15(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_17(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_16(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_18(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_17(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_19(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_18(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_20(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_19(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_21(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_20(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_22(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_21(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_23(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_22(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_24(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_23(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_25(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_24(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_26(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_25(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_27(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_26(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_28(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_27(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_29(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_28(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_30(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_29(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_31(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_30(macro, __VA_ARGS__))
+#define NUJ_FOR_EACH_32(macro, x, ...) macro(x) NUJ_EXPAND(NUJ_FOR_EACH_31(macro, __VA_ARGS__))
+
+#define NUJ_FOR_EACH_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+                       _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+
+// NOTE: Calls macro with every argument, up to 32 of them.
+#define NUJ_FOR_EACH(macro, ...) \
+    NUJ_EXPAND(NUJ_FOR_EACH_N(__VA_ARGS__, \
+                              NUJ_FOR_EACH_32, NUJ_FOR_EACH_31, NUJ_FOR_EACH_30, NUJ_FOR_EACH_29, \
+                              NUJ_FOR_EACH_28, NUJ_FOR_EACH_27, NUJ_FOR_EACH_26, NUJ_FOR_EACH_25, \
+                              NUJ_FOR_EACH_24, NUJ_FOR_EACH_23, NUJ_FOR_EACH_22, NUJ_FOR_EACH_21, \
+                              NUJ_FOR_EACH_20, NUJ_FOR_EACH_19, NUJ_FOR_EACH_18, NUJ_FOR_EACH_17, \
+                              NUJ_FOR_EACH_16, NUJ_FOR_EACH_15, NUJ_FOR_EACH_14, NUJ_FOR_EACH_13, \
+                              NUJ_FOR_EACH_12, NUJ_FOR_EACH_11, NUJ_FOR_EACH_10, NUJ_FOR_EACH_9, \
+                              NUJ_FOR_EACH_8, NUJ_FOR_EACH_7, NUJ_FOR_EACH_6, NUJ_FOR_EACH_5, \
+                              NUJ_FOR_EACH_4, NUJ_FOR_EACH_3, NUJ_FOR_EACH_2, NUJ_FOR_EACH_1)(macro, __VA_ARGS__))
+
+// NOTE: The hash only picks the case, the name is still compared.
+#define NUJ_FIELD_CASE(field) \
+    case nuj::hash(#field, sizeof(#field) - 1): \
+    { \
+        if (length == sizeof(#field) - 1 && !memcmp(name, #field, sizeof(#field) - 1)) \
+        { \
+            return nuj::read_value(object.field, value); \
+        } \
+    } \
+    break;
+
+// NOTE: Defines nuj_read_field for Type, which nuj::read finds by
+// argument dependent lookup.  It returns the char after the value, or
+// 0 if the value can't be read.
+#define NUJ_FIELDS(Type, ...) \
+    inline const unsigned char* nuj_read_field(Type& object, unsigned int hash, const char* name, unsigned int length, const NUJCursor* value) \
+    { \
+        switch (hash) \
+        { \
+            NUJ_FOR_EACH(NUJ_FIELD_CASE, __VA_ARGS__) \
+            default: break; \
+        } \
+        \
+        return nuj_skip_cursor(value); \
+    }
+
+namespace nuj
+{
+    // NOTE: FNV-1a, constexpr so it can be a case label.
+    constexpr unsigned int hash(const char* name, unsigned int length, unsigned int value = 2166136261u)
+    {
+        return length ? hash(name + 1, length - 1, (value ^ (unsigned char)*name) * 16777619u) : value;
+    }
+
+    inline const unsigned char* skip_whitespace(const unsigned char* current, const unsigned char* end)
+    {
+        while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r'))
+        {
+            ++current;
+        }
+
+        return current;
+    }
+
+    // NOTE: current is after the last child, or after the opening
+    // bracket if there are none.  Returns the char after the closing
+    // bracket.
+    inline const unsigned char* read_close(const NUJCursor* value, const unsigned char* current, unsigned char close)
+    {
+        current = skip_whitespace(current, value->end);
+
+        return current < value->end && *current == close ? current + 1 : 0;
+    }
+
+    inline const unsigned char* read(bool& out, const NUJCursor* value);
+    inline const unsigned char* read(std::string& out, const NUJCursor* value);
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, const unsigned char*>::type read(T& out, const NUJCursor* value);
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, const unsigned char*>::type read(T& out, const NUJCursor* value);
+
+    template <typename T, typename Allocator>
+    const unsigned char* read(std::vector<T, Allocator>& out, const NUJCursor* value);
+
+    template <typename T>
+    auto read(T& object, const NUJCursor* value) -> decltype(nuj_read_field(object, 0u, (const char*)0, 0u, value));
+
+    // NOTE: Nulls are skipped and leave out as it is.
+    template <typename T>
+    const unsigned char* read_value(T& out, const NUJCursor* value)
+    {
+        return value->type == NUJNull_TYPE ? nuj_skip_cursor(value) : read(out, value);
+    }
+
+    inline const unsigned char* read(bool& out, const NUJCursor* value)
+    {
+        const unsigned char* end = 0;
+
+        if (value->type == NUJBoolean_TYPE)
+        {
+            out = nuj_get_cursor_boolean(value) != 0;
+            end = nuj_skip_cursor(value);
+        }
+
+        return end;
+    }
+
+    inline const unsigned char* read(std::string& out, const NUJCursor* value)
+    {
+        const unsigned char* end = 0;
+        unsigned int length = 0;
+        const char* string = nuj_get_cursor_string(value, &length);
+
+        if (string)
+        {
+            if (memchr(string, '\\', length))
+            {
+                out.resize(length);
+                out.resize(nuj_decode_string(string, length, &out[0]));
+            }
+            else
+            {
+                out.assign(string, length);
+            }
+
+            end = nuj_skip_cursor(value);
+        }
+
+        return end;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, const unsigned char*>::type read(T& out, const NUJCursor* value)
+    {
+        const unsigned char* end = 0;
+
+        if (value->type == NUJInteger_TYPE)
+        {
+            long long integer = nuj_get_cursor_integer(value);
+            T converted = (T)integer;
+
+            if ((long long)converted == integer && (std::is_signed<T>::value || integer >= 0))
+            {
+                out = converted;
+                end = nuj_skip_cursor(value);
+            }
+        }
+
+        return end;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, const unsigned char*>::type read(T& out, const NUJCursor* value)
+    {
+        const unsigned char* end = 0;
+
+        if (value->type == NUJInteger_TYPE || value->type == NUJDouble_TYPE)
+        {
+            out = (T)nuj_get_cursor_double(value);
+            end = nuj_skip_cursor(value);
+        }
+
+        return end;
+    }
+
+    // NOTE: The vector is replaced by the elements of the array.
+    template <typename T, typename Allocator>
+    const unsigned char* read(std::vector<T, Allocator>& out, const NUJCursor* value)
+    {
+        const unsigned char* end = 0;
+
+        if (value->type == NUJArray_TYPE)
+        {
+            NUJCursor child;
+            const unsigned char* current = value->start + 1;
+            int found = nuj_get_cursor_first_child(value, &child);
+
+            out.clear();
+
+            while (found)
+            {
+                out.emplace_back();
+                current = read_value(out.back(), &child);
+                found = current && nuj_get_cursor_sibling_at(&child, current, &child);
+            }
+
+            end = current ? read_close(value, current, ']') : 0;
+        }
+
+        return end;
+    }
+
+    template <typename T>
+    auto read(T& object, const NUJCursor* value) -> decltype(nuj_read_field(object, 0u, (const char*)0, 0u, value))
+    {
+        const unsigned char* end = 0;
+
+        if (value->type == NUJObject_TYPE)
+        {
+            NUJCursor child;
+            const unsigned char* current = value->start + 1;
+            int found = nuj_get_cursor_first_child(value, &child);
+
+            while (found)
+            {
+                unsigned int length = 0;
+                const char* name = nuj_get_cursor_name(&child, &length);
+                char decoded[256];
+
+                // NOTE: Longer escaped names can't be a field anyway.
+                if (memchr(name, '\\', length) && length <= sizeof(decoded))
+                {
+                    length = nuj_decode_string(name, length, decoded);
+                    name = decoded;
+                }
+
+                current = nuj_read_field(object, hash(name, length), name, length, &child);
+                found = current && nuj_get_cursor_sibling_at(&child, current, &child);
+            }
+
+            end = current ? read_close(value, current, '}') : 0;
+        }
+
+        return end;
+    }
+
+    // NOTE: Reads the document into object, which is only partly
+    // written if it fails.  As with nuj_parse_cursor a buffer_size of 0
+    // means the buffer is null terminated.  Only what is read is
+    // validated, skipped values aren't.
+    template <typename T>
+    bool parse(T& object, const unsigned char* buffer, unsigned long long buffer_size)
+    {
+        NUJCursor root;
+        const unsigned char* end = 0;
+
+        if (nuj_parse_cursor(&root, buffer, buffer_size))
+        {
+            end = read_value(object, &root);
+        }
+
+        return end && skip_whitespace(end, root.end) == root.end;
+    }
+
+    template <typename T>
+    bool parse(T& object, const std::string& text)
+    {
+        return parse(object, (const unsigned char*)text.c_str(), text.size());
+    }
+}
+
+#define H_NUJ_BIND_HPP
+#endif
@@ -0,0 +1,200 @@
+// NOTE: nuj::parse must fill the fields named in the document, keys
+// escaped or not, leave fields alone for nulls and missing keys, and
+// fail on values of the wrong type, out of range integers and
+// anything after the root.
+
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json_bind.hpp"
+#include "nu_json_test.h"
+
+#include <stdint.h>
+
+struct TestInner
+{
+    int a = 0;
+    std::string s;
+};
+
+NUJ_FIELDS(TestInner, a, s)
+
+struct TestRecord
+{
+    bool flag = false;
+    int8_t small = 0;
+    uint16_t port = 0;
+    int count = 0;
+    unsigned int id = 0;
+    long long big = 0;
+    float ratio = 0;
+    double value = 0;
+    std::string name;
+    std::vector<int> ints;
+    std::vector<std::string> names;
+    std::vector<TestInner> inners;
+    std::vector<std::vector<double> > matrix;
+    TestInner inner;
+};
+
+NUJ_FIELDS(TestRecord, flag, small, port, count, id, big, ratio, value, name, ints, names, inners, matrix, inner)
+
+static bool test_parse(TestRecord& record, const char* text)
+{
+    record = TestRecord();
+
+    return nuj::parse(record, (const unsigned char*)text, 0);
+}
+
+static void test_fields()
+{
+    TestRecord record;
+    const char* text =
+        "{\"flag\":true,\"small\":-128,\"port\":65535,\"count\":-2147483648,\"id\":4294967295,"
+        "\"big\":-9223372036854775808,\"ratio\":2,\"value\":-1.5e-3,\"name\":\"a\\\"b\\u00e9\","
+        "\"ints\":[1,-2,3],\"names\":[\"x\",\"\",\"\\n\"],\"inners\":[{\"a\":1},{\"s\":\"t\",\"a\":2}],"
+        "\"matrix\":[[1,2.5],[],[-3]],\"inner\":{\"a\":7,\"s\":\"in\"}}";
+
+    TEST_CHECK(test_parse(record, text));
+    TEST_CHECK(record.flag && record.small == -128 && record.port == 65535);
+    TEST_CHECK(record.count == INT32_MIN && record.id == 4294967295u && record.big == INT64_MIN);
+    TEST_CHECK(record.ratio == 2.0f && record.value == -1.5e-3);
+    TEST_CHECK(record.name == "a\"b\xC3\xA9");
+    TEST_CHECK(record.ints == std::vector<int>({ 1, -2, 3 }));
+    TEST_CHECK(record.names == std::vector<std::string>({ "x", "", "\n" }));
+    TEST_CHECK(record.inners.size() == 2 && record.inners[0].a == 1 && record.inners[0].s.empty());
+    TEST_CHECK(record.inners.size() == 2 && record.inners[1].a == 2 && record.inners[1].s == "t");
+    TEST_CHECK(record.matrix.size() == 3 && record.matrix[0] == std::vector<double>({ 1, 2.5 }));
+    TEST_CHECK(record.matrix.size() == 3 && record.matrix[1].empty() && record.matrix[2] == std::vector<double>({ -3 }));
+    TEST_CHECK(record.inner.a == 7 && record.inner.s == "in");
+
+    // NOTE: The std::string overload, with whitespace around the root.
+    record = TestRecord();
+    TEST_CHECK(nuj::parse(record, std::string(" \n{ \"count\" : 3 , \"name\" : \"n\" }\r\n ")));
+    TEST_CHECK(record.count == 3 && record.name == "n");
+}
+
+// NOTE: Integers must fit their field, a failed value fails the parse.
+static void test_ranges()
+{
+    static const char* valid[] =
+    {
+        "{\"small\":127}", "{\"small\":-128}", "{\"port\":0}", "{\"port\":65535}",
+        "{\"count\":2147483647}", "{\"id\":0}", "{\"big\":9223372036854775807}",
+        "{\"value\":1}", "{\"ratio\":1e-3}", "{\"value\":-0.0}",
+    };
+    static const char* invalid[] =
+    {
+        "{\"small\":128}", "{\"small\":-129}", "{\"port\":-1}", "{\"port\":65536}",
+        "{\"count\":2147483648}", "{\"count\":-2147483649}", "{\"id\":-1}", "{\"id\":4294967296}",
+        "{\"count\":1.5}", "{\"count\":1e2}", "{\"count\":\"1\"}", "{\"count\":true}",
+        "{\"flag\":1}", "{\"flag\":\"true\"}", "{\"name\":1}", "{\"name\":[]}", "{\"value\":\"1\"}",
+        "{\"ints\":{}}", "{\"ints\":1}", "{\"ints\":[1,\"2\"]}", "{\"ints\":[1,2.5]}",
+        "{\"inner\":[]}", "{\"inner\":1}", "{\"inners\":[{\"a\":\"x\"}]}", "{\"matrix\":[1]}",
+    };
+    TestRecord record;
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(valid) / sizeof(*valid); ++i)
+    {
+        if (!TEST_CHECK(test_parse(record, valid[i])))
+        {
+            fprintf(stderr, "  %s\n", valid[i]);
+        }
+    }
+
+    for (i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+    {
+        if (!TEST_CHECK(!test_parse(record, invalid[i])))
+        {
+            fprintf(stderr, "  %s\n", invalid[i]);
+        }
+    }
+
+    // NOTE: A value out of range is not written.
+    record.count = 5;
+    TEST_CHECK(!nuj::parse(record, (const unsigned char*)"{\"count\":2147483648}", 0) && record.count == 5);
+}
+
+// NOTE: Keys are compared decoded, and unknown keys are skipped.
+static void test_keys()
+{
+    TestRecord record;
+
+    TEST_CHECK(test_parse(record, "{\"n\\u0061me\":\"x\",\"\\u0063ount\":4,\"inn\\u0065r\":{\"\\u0061\":5}}"));
+    TEST_CHECK(record.name == "x" && record.count == 4 && record.inner.a == 5);
+
+    TEST_CHECK(test_parse(record, "{\"na\\\\me\":\"x\",\"Name\":\"y\",\"name \":\"z\",\"nam\":\"w\"}"));
+    TEST_CHECK(record.name.empty());
+
+    // NOTE: Skipped values aren't validated, only their brackets.
+    TEST_CHECK(test_parse(record, "{\"unknown\":{\"a\":[1,{\"b\":\"]}\"}]},\"other\":[[]],\"count\":1}"));
+    TEST_CHECK(record.count == 1);
+
+    // NOTE: The last of duplicated keys wins.
+    TEST_CHECK(test_parse(record, "{\"count\":1,\"count\":2}"));
+    TEST_CHECK(record.count == 2);
+}
+
+// NOTE: Nulls and missing keys leave the fields as they were, a null
+// in an array is a default value.
+static void test_nulls()
+{
+    TestRecord record;
+
+    record.count = 9;
+    record.name = "kept";
+    record.ints.assign(3, 1);
+    record.inner.a = 8;
+    TEST_CHECK(nuj::parse(record, (const unsigned char*)"{\"count\":null,\"name\":null,\"ints\":null,\"inner\":null,\"flag\":null}", 0));
+    TEST_CHECK(record.count == 9 && record.name == "kept" && record.ints.size() == 3 && record.inner.a == 8 && !record.flag);
+
+    TEST_CHECK(nuj::parse(record, (const unsigned char*)"{}", 0));
+    TEST_CHECK(record.count == 9 && record.name == "kept");
+
+    // NOTE: Arrays replace what the vector held.
+    TEST_CHECK(nuj::parse(record, (const unsigned char*)"{\"ints\":[4,null,6],\"inners\":[null,{\"a\":1}]}", 0));
+    TEST_CHECK(record.ints == std::vector<int>({ 4, 0, 6 }));
+    TEST_CHECK(record.inners.size() == 2 && record.inners[0].a == 0 && record.inners[1].a == 1);
+
+    TEST_CHECK(nuj::parse(record, (const unsigned char*)"null", 0));
+}
+
+// NOTE: Only whitespace may follow the root, and the document must be
+// whole.
+static void test_syntax()
+{
+    static const char* invalid[] =
+    {
+        "", " ", "{", "{\"count\":1", "{\"count\":1,}", "{\"count\":}", "{\"count\" 1}", "{count:1}",
+        "{\"count\":1} x", "{\"count\":1}}", "{\"count\":1},", "{\"count\":1}{}", "{\"ints\":[1,2}",
+        "{\"ints\":[1,,2]}", "{\"ints\":[1,2,]}", "{\"name\":\"unterminated}",
+    };
+    TestRecord record;
+    std::vector<int> ints;
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+    {
+        if (!TEST_CHECK(!test_parse(record, invalid[i])))
+        {
+            fprintf(stderr, "  %s\n", invalid[i]);
+        }
+    }
+
+    // NOTE: buffer_size ends the document before the garbage.
+    TEST_CHECK(nuj::parse(record, (const unsigned char*)"{\"count\":1} x", 11) && record.count == 1);
+
+    // NOTE: The root can be any value a field can.
+    TEST_CHECK(nuj::parse(ints, (const unsigned char*)" [1, 2] ", 0) && ints == std::vector<int>({ 1, 2 }));
+    TEST_CHECK(!nuj::parse(ints, (const unsigned char*)"[1] [2]", 0));
+}
+
+int main()
+{
+    test_fields();
+    test_ranges();
+    test_keys();
+    test_nulls();
+    test_syntax();
+
+    return test_finish("nu_json_bind_test");
+}
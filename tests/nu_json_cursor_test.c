@@ -0,0 +1,222 @@
+// NOTE: Walking a document with cursors must read the same tree that
+// nuj_parse makes of it, and nuj_find_cursor_child must match decoded
+// names, escaped or not and of any length.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static int test_same_bytes(const char* a, unsigned int a_length, const char* b, unsigned int b_length)
+{
+    return a_length == b_length && !memcmp(a, b, a_length);
+}
+
+// NOTE: Decoded name of child i of element, null terminated.  The
+// caller frees it.
+static char* test_decode_name(const NUJElement* element, unsigned int i)
+{
+    const NUJElement* child = NUJ_CHILD(element, i);
+    char* name = (char*)malloc(child->name_length + 1);
+
+    name[nuj_decode_string(child->name, child->name_length, name)] = '\0';
+
+    return name;
+}
+
+// NOTE: Index of the first child of element whose decoded name is name.
+static unsigned int test_first_named(const NUJElement* element, const char* name)
+{
+    unsigned int found = ~0u;
+    unsigned int i = 0;
+
+    for (i = 0; found == ~0u && i < NUJ_CHILD_COUNT(element); ++i)
+    {
+        char* child_name = test_decode_name(element, i);
+
+        found = strcmp(child_name, name) ? found : i;
+        free(child_name);
+    }
+
+    return found;
+}
+
+static int test_compare_cursor(const NUJCursor* cursor, const NUJElement* element, int named)
+{
+    const char* name = 0;
+    const char* string = 0;
+    unsigned int length = 0;
+    int result = nuj_get_cursor_type(cursor) == element->type;
+
+    name = nuj_get_cursor_name(cursor, &length);
+    result = result && (named ? name && test_same_bytes(name, length, element->name, element->name_length) : !name);
+
+    switch (result ? element->type : NUJNone_TYPE)
+    {
+        case NUJString_TYPE:
+        {
+            string = nuj_get_cursor_string(cursor, &length);
+            result = test_same_bytes(string, length, NUJ_CSTRING(element)->value, NUJ_CSTRING(element)->length);
+        }
+        break;
+        case NUJInteger_TYPE:
+        {
+            result = nuj_get_cursor_integer(cursor) == NUJ_CINTEGER(element)->value &&
+                     nuj_get_cursor_double(cursor) == (double)NUJ_CINTEGER(element)->value;
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            double number = nuj_get_cursor_double(cursor);
+
+            result = !memcmp(&number, &NUJ_CDOUBLE(element)->value, sizeof(number));
+        }
+        break;
+        case NUJBoolean_TYPE:
+        {
+            result = nuj_get_cursor_boolean(cursor) == (NUJ_CBOOLEAN(element)->value != 0);
+        }
+        break;
+        case NUJObject_TYPE:
+        case NUJArray_TYPE:
+        {
+            NUJCursor child = NUJ_ZERO;
+            NUJCursor other = NUJ_ZERO;
+            NUJCursor named = NUJ_ZERO;
+            int found = nuj_get_cursor_first_child(cursor, &child);
+            unsigned int i = 0;
+
+            result = nuj_get_cursor_child_count(cursor) == NUJ_CHILD_COUNT(element) && found == (NUJ_CHILD_COUNT(element) != 0);
+
+            for (i = 0; result && i < NUJ_CHILD_COUNT(element); ++i)
+            {
+                result = found && test_compare_cursor(&child, NUJ_CHILD(element, i), element->type == NUJObject_TYPE);
+
+                // NOTE: By index, and from the end of the previous one.
+                result = result && nuj_get_cursor_child(cursor, i, &other) && other.start == child.start;
+
+                if (result && element->type == NUJObject_TYPE)
+                {
+                    char* child_name = test_decode_name(element, i);
+                    unsigned int first = test_first_named(element, child_name);
+
+                    // NOTE: Of duplicated names the first one is found.
+                    result = nuj_find_cursor_child(cursor, child_name, &other) &&
+                             nuj_get_cursor_child(cursor, first, &named) && other.start == named.start;
+                    free(child_name);
+                }
+
+                if (result)
+                {
+                    int sibling = nuj_get_cursor_sibling_at(&child, nuj_skip_cursor(&child), &other);
+
+                    found = nuj_get_cursor_next_sibling(&child, &child);
+                    result = found == sibling && found == (i + 1 < NUJ_CHILD_COUNT(element)) && (!found || other.start == child.start);
+                }
+            }
+
+            if (result && element->type == NUJObject_TYPE)
+            {
+                result = !nuj_find_cursor_child(cursor, "missing", &other);
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+static void test_cursor(const char* text)
+{
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)text, 0);
+    NUJCursor cursor = NUJ_ZERO;
+    const unsigned char* end = (const unsigned char*)text + strlen(text);
+    const unsigned char* skipped = 0;
+
+    if (TEST_CHECK(root && nuj_parse_cursor(&cursor, (const unsigned char*)text, 0)))
+    {
+        if (!TEST_CHECK(test_compare_cursor(&cursor, root, 0)))
+        {
+            fprintf(stderr, "  %.60s\n", text);
+        }
+
+        // NOTE: The root ends at its closing brace.
+        skipped = nuj_skip_cursor(&cursor);
+        TEST_CHECK(skipped && skipped[-1] == '}');
+
+        while (skipped && skipped < end && (*skipped == ' ' || *skipped == '\n'))
+        {
+            ++skipped;
+        }
+
+        TEST_CHECK(skipped == end);
+    }
+
+    nuj_release(handle);
+}
+
+// NOTE: Escaped names longer than any buffer of the decoder.
+static void test_long_names(void)
+{
+    char* text = (char*)malloc(8192);
+    char* name = (char*)malloc(2048);
+    NUJCursor cursor = NUJ_ZERO;
+    NUJCursor child = NUJ_ZERO;
+    unsigned int text_length = 0;
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    text_length += (unsigned int)sprintf(text, "{\"short\":0,\"");
+
+    for (i = 0; i < 1000; ++i)
+    {
+        if (i % 3 == 1)
+        {
+            text_length += (unsigned int)sprintf(text + text_length, "\\u00e9");
+            name[length++] = (char)0xC3;
+            name[length++] = (char)0xA9;
+        }
+        else
+        {
+            text[text_length++] = (char)('a' + i % 26);
+            name[length++] = (char)('a' + i % 26);
+        }
+    }
+
+    sprintf(text + text_length, "\":1,\"tail\\\"\":2}");
+    name[length] = '\0';
+
+    if (TEST_CHECK(nuj_parse_cursor(&cursor, (const unsigned char*)text, 0)))
+    {
+        TEST_CHECK(nuj_find_cursor_child(&cursor, name, &child) && nuj_get_cursor_integer(&child) == 1);
+        TEST_CHECK(nuj_find_cursor_child(&cursor, "tail\"", &child) && nuj_get_cursor_integer(&child) == 2);
+
+        // NOTE: Longer names, prefixes and raw escapes don't match.
+        name[length] = 'x';
+        name[length + 1] = '\0';
+        TEST_CHECK(!nuj_find_cursor_child(&cursor, name, &child));
+        name[length - 1] = '\0';
+        TEST_CHECK(!nuj_find_cursor_child(&cursor, name, &child));
+        TEST_CHECK(!nuj_find_cursor_child(&cursor, "tail", &child));
+        TEST_CHECK(!nuj_find_cursor_child(&cursor, "tail\\\"", &child));
+    }
+
+    free(name);
+    free(text);
+}
+
+int main(void)
+{
+    unsigned int i = 0;
+
+    for (i = 0; test_get_document(i); ++i)
+    {
+        test_cursor(test_get_document(i));
+    }
+
+    test_long_names();
+
+    return test_finish("nu_json_cursor_test");
+}
@@ -0,0 +1,149 @@
+// NOTE: A NUJDocument must hold the same tree as the elements it was
+// created from, with and without NUJ_DOCUMENT_PARENTS, and still after
+// it is copied somewhere else as a block.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static int test_same_bytes(const char* a, unsigned int a_length, const char* b, unsigned int b_length)
+{
+    return a_length == b_length && !memcmp(a, b, a_length);
+}
+
+// NOTE: Index of the first child of element named like child i.
+static unsigned int test_first_named(const NUJElement* element, unsigned int i)
+{
+    const NUJElement* child = NUJ_CHILD(element, i);
+    unsigned int j = 0;
+
+    while (!test_same_bytes(NUJ_CHILD(element, j)->name, NUJ_CHILD(element, j)->name_length, child->name, child->name_length))
+    {
+        ++j;
+    }
+
+    return j;
+}
+
+static int test_compare_node(const NUJDocument* document, unsigned int node, const NUJElement* element)
+{
+    const char* name = 0;
+    const char* string = 0;
+    unsigned int length = 0;
+    unsigned int i = 0;
+    int result = nuj_get_node_type(document, node) == element->type;
+
+    name = nuj_get_node_name(document, node, &length);
+    result = result && (element->name ? name && test_same_bytes(name, length, element->name, element->name_length) : !name);
+
+    switch (result ? element->type : NUJNone_TYPE)
+    {
+        case NUJString_TYPE:
+        {
+            string = nuj_get_node_string(document, node, &length);
+            result = test_same_bytes(string, length, NUJ_CSTRING(element)->value, NUJ_CSTRING(element)->length);
+        }
+        break;
+        case NUJInteger_TYPE:
+        {
+            result = nuj_get_node_integer(document, node) == NUJ_CINTEGER(element)->value;
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            double number = nuj_get_node_double(document, node);
+
+            result = !memcmp(&number, &NUJ_CDOUBLE(element)->value, sizeof(number));
+        }
+        break;
+        case NUJBoolean_TYPE:
+        {
+            result = nuj_get_node_boolean(document, node) == (NUJ_CBOOLEAN(element)->value != 0);
+        }
+        break;
+        case NUJObject_TYPE:
+        case NUJArray_TYPE:
+        {
+            result = nuj_get_node_child_count(document, node) == NUJ_CHILD_COUNT(element);
+
+            for (i = 0; result && i < NUJ_CHILD_COUNT(element); ++i)
+            {
+                unsigned int child = nuj_get_node_child(document, node, i);
+
+                result = nuj_get_node_parent(document, child) == node &&
+                         test_compare_node(document, child, NUJ_CHILD(element, i));
+
+                // NOTE: Of duplicated names the first one is found.
+                if (result && element->type == NUJObject_TYPE)
+                {
+                    result = nuj_find_node_by_name(document, node, NUJ_CHILD(element, i)->name) ==
+                             nuj_get_node_child(document, node, test_first_named(element, i));
+                }
+            }
+
+            if (result && element->type == NUJObject_TYPE)
+            {
+                result = !nuj_find_node_by_name(document, node, "missing");
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+static void test_document(const char* text, unsigned int flags)
+{
+    NUJHandle handle = test_create_handle();
+    NUJHandle document_handle = test_create_handle();
+    unsigned long long used_size = nuj_get_used_size(document_handle);
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)text, 0);
+    NUJDocument* document = root ? nuj_create_document(document_handle, root, flags) : 0;
+
+    if (TEST_CHECK(root && document))
+    {
+        unsigned long long size = nuj_get_document_size(document);
+        void* copy = malloc((size_t)size);
+
+        if (!TEST_CHECK(test_compare_node(document, 0, root)))
+        {
+            fprintf(stderr, "  flags %u: %.60s\n", flags, text);
+        }
+
+        TEST_CHECK(nuj_get_node_parent(document, 0) == 0);
+
+        // NOTE: The document is one push of exactly its size.
+        TEST_CHECK(nuj_get_used_size(document_handle) - used_size == size);
+
+        // NOTE: Nothing in it points to itself, so a copy reads the
+        // same after the original is gone.
+        memcpy(copy, document, (size_t)size);
+        nuj_release(document_handle);
+        document_handle = 0;
+        TEST_CHECK(test_compare_node((const NUJDocument*)copy, 0, root));
+
+        free(copy);
+    }
+
+    if (document_handle)
+    {
+        nuj_release(document_handle);
+    }
+
+    nuj_release(handle);
+}
+
+int main(void)
+{
+    unsigned int i = 0;
+
+    for (i = 0; test_get_document(i); ++i)
+    {
+        test_document(test_get_document(i), 0);
+        test_document(test_get_document(i), NUJ_DOCUMENT_PARENTS);
+    }
+
+    return test_finish("nu_json_document_test");
+}
@@ -0,0 +1,282 @@
+// NOTE: Inserting, removing, replacing and renaming children must keep
+// the written tree, the parent pointers and the key index right, and
+// memory given back by remove and replace must be used again by the
+// next elements of the same size.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+#define TEST_KEY_COUNT 40
+
+static char test_keys[TEST_KEY_COUNT][8];
+
+static int test_written(const NUJElement* element, const char* expected)
+{
+    char* text = test_write(element);
+    int result = TEST_CHECK(!strcmp(text, expected));
+
+    if (!result)
+    {
+        fprintf(stderr, "  expected %s\n  actual   %s\n", expected, text);
+    }
+
+    free(text);
+
+    return result;
+}
+
+// NOTE: Every child must be found by its name, through the key index
+// once the object has NUJ_KEY_INDEX_MIN_COUNT of them.
+static int test_found(NUJHandle handle, NUJElement* element)
+{
+    unsigned int i = 0;
+
+    for (i = 0; i < NUJ_CHILD_COUNT(element); ++i)
+    {
+        if (nuj_find_child_by_name(handle, element, NUJ_CHILD(element, i)->name) != NUJ_CHILD(element, i))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void test_insert(NUJHandle handle)
+{
+    NUJElement* object = nuj_create_element_object(handle, 0);
+    NUJElement* array = nuj_create_element_array(handle, 1);
+    unsigned int i = 0;
+
+    // NOTE: Front, end, middle and past the end, growing from 0.
+    nuj_insert_element(handle, object, 0, "b", nuj_create_element_integer(handle, 2));
+    nuj_insert_element(handle, object, 1, "d", nuj_create_element_integer(handle, 4));
+    nuj_insert_element(handle, object, 0, "a", nuj_create_element_integer(handle, 1));
+    nuj_insert_element(handle, object, 2, "c", nuj_create_element_integer(handle, 3));
+    nuj_insert_element(handle, object, 100, "e", nuj_create_element_integer(handle, 5));
+    test_written(object, "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5}");
+    TEST_CHECK(NUJ_OBJECT(object)->max_child_count >= 5);
+    TEST_CHECK(test_parents(object));
+
+    for (i = 0; i < TEST_KEY_COUNT; ++i)
+    {
+        TEST_CHECK(nuj_insert_element(handle, object, i % 2 ? 0 : ~0u, test_keys[i], nuj_create_element_integer(handle, i)) != 0);
+        TEST_CHECK(test_found(handle, object));
+    }
+
+    TEST_CHECK(NUJ_CHILD_COUNT(object) == TEST_KEY_COUNT + 5);
+    TEST_CHECK(NUJ_OBJECT(object)->index != 0);
+    TEST_CHECK(test_parents(object));
+    TEST_CHECK(!nuj_find_child_by_name(handle, object, "missing"));
+
+    // NOTE: Arrays take children without names.
+    for (i = 0; i < 5; ++i)
+    {
+        nuj_insert_element(handle, array, i / 2, 0, nuj_create_element_integer(handle, i));
+    }
+
+    test_written(array, "[1,3,4,2,0]");
+    TEST_CHECK(test_parents(array));
+}
+
+static void test_remove(NUJHandle handle)
+{
+    NUJElement* object = nuj_create_element_object(handle, 0);
+    NUJElement* other = nuj_create_element_object(handle, 0);
+    NUJElement* moved = 0;
+    unsigned int i = 0;
+
+    for (i = 0; i < TEST_KEY_COUNT; ++i)
+    {
+        nuj_insert_element(handle, object, i, test_keys[i], nuj_create_element_integer(handle, i));
+    }
+
+    TEST_CHECK(test_found(handle, object));
+
+    // NOTE: First, last and every third in between.
+    nuj_remove_element(handle, NUJ_CHILD(object, 0));
+    nuj_remove_element(handle, NUJ_CHILD(object, NUJ_CHILD_COUNT(object) - 1));
+
+    for (i = NUJ_CHILD_COUNT(object); i-- > 0;)
+    {
+        if (i % 3 == 1)
+        {
+            nuj_remove_element(handle, NUJ_CHILD(object, i));
+        }
+    }
+
+    TEST_CHECK(NUJ_CHILD_COUNT(object) == 25);
+    TEST_CHECK(test_parents(object));
+    TEST_CHECK(test_found(handle, object));
+    TEST_CHECK(!nuj_find_child_by_name(handle, object, test_keys[0]));
+    TEST_CHECK(!nuj_find_child_by_name(handle, object, test_keys[2]));
+    TEST_CHECK(!nuj_find_child_by_name(handle, object, test_keys[TEST_KEY_COUNT - 1]));
+
+    for (i = 0; i < NUJ_CHILD_COUNT(object); ++i)
+    {
+        TEST_CHECK(!strcmp(NUJ_CHILD(object, i)->name, test_keys[NUJ_INTEGER(NUJ_CHILD(object, i))->value]));
+    }
+
+    // NOTE: Without a handle the child is kept and can be moved.
+    moved = NUJ_CHILD(object, 0);
+    nuj_remove_element(0, moved);
+    TEST_CHECK(!moved->parent && NUJ_CHILD_COUNT(object) == 24);
+    nuj_insert_element(handle, other, 0, "moved", moved);
+    TEST_CHECK(moved->parent == other);
+    test_written(other, "{\"moved\":1}");
+
+    while (NUJ_CHILD_COUNT(object))
+    {
+        nuj_remove_element(handle, NUJ_CHILD(object, NUJ_CHILD_COUNT(object) / 2));
+    }
+
+    test_written(object, "{}");
+}
+
+static void test_replace(NUJHandle handle)
+{
+    NUJElement* object = nuj_create_element_object(handle, 0);
+    NUJElement* child = 0;
+    NUJElement* value = 0;
+    unsigned int i = 0;
+
+    for (i = 0; i < 10; ++i)
+    {
+        nuj_insert_element(handle, object, i, test_keys[i], nuj_create_element_integer(handle, i));
+    }
+
+    // NOTE: The key index is built here and kept by replace.
+    TEST_CHECK(test_found(handle, object));
+    TEST_CHECK(NUJ_OBJECT(object)->index != 0);
+
+    child = NUJ_CHILD(object, 3);
+    value = nuj_create_element_string(handle, "three");
+    TEST_CHECK(nuj_replace_element(handle, child, value) == value);
+    TEST_CHECK(NUJ_CHILD(object, 3) == value && value->parent == object);
+    TEST_CHECK(!strcmp(value->name, test_keys[3]));
+    TEST_CHECK(NUJ_OBJECT(object)->index != 0);
+    TEST_CHECK(nuj_find_child_by_name(handle, object, test_keys[3]) == value);
+    TEST_CHECK(test_found(handle, object));
+
+    // NOTE: Replacing a child with itself does nothing.
+    TEST_CHECK(nuj_replace_element(handle, value, value) == value);
+    TEST_CHECK(NUJ_CHILD(object, 3) == value && value->parent == object);
+    TEST_CHECK(nuj_find_child_by_name(handle, object, test_keys[3]) == value);
+
+    // NOTE: A subtree can replace a child, and be replaced.
+    value = nuj_create_element_array(handle, 2);
+    nuj_add_element_element(value, 0, nuj_create_element_boolean(handle, 1));
+    nuj_add_element_element(value, 0, nuj_create_element_null(handle));
+    nuj_replace_element(handle, NUJ_CHILD(object, 0), value);
+    TEST_CHECK(test_parents(value));
+    nuj_replace_element(handle, NUJ_CHILD(object, 9), nuj_create_element_double(handle, 9.5));
+    test_written(object, "{\"k0\":[true,null],\"k1\":1,\"k2\":2,\"k3\":\"three\",\"k4\":4,\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,\"k9\":9.5}");
+    TEST_CHECK(test_parents(object));
+    TEST_CHECK(test_found(handle, object));
+
+    // NOTE: Rename drops the index, both names must be right after.
+    nuj_rename_element(handle, NUJ_CHILD(object, 5), "renamed");
+    TEST_CHECK(!nuj_find_child_by_name(handle, object, test_keys[5]));
+    TEST_CHECK(nuj_find_child_by_name(handle, object, "renamed") == NUJ_CHILD(object, 5));
+    TEST_CHECK(test_found(handle, object));
+}
+
+// NOTE: Edits of a parsed tree, whose children arrays are exactly full.
+static void test_parsed(NUJHandle handle)
+{
+    static const char document[] = "{\"a\":[1,2],\"b\":{\"c\":true},\"d\":\"x\",\"e\":1,\"f\":2,\"g\":3,\"h\":4,\"i\":5}";
+    NUJElement* root = nuj_parse_flags(handle, (const unsigned char*)document, 0, NUJ_PARSE_INDEX_KEYS);
+    NUJElement* array = 0;
+
+    TEST_CHECK(root != 0);
+
+    if (!root)
+    {
+        return;
+    }
+
+    array = nuj_find_child_by_name(handle, root, "a");
+    TEST_CHECK(nuj_insert_element(handle, array, 1, 0, nuj_create_element_integer(handle, 7)) != 0);
+    TEST_CHECK(nuj_insert_element(handle, root, 0, "first", nuj_create_element_null(handle)) != 0);
+    nuj_remove_element(handle, nuj_find_child_by_name(handle, root, "b"));
+    nuj_replace_element(handle, nuj_find_child_by_name(handle, root, "d"), nuj_create_element_integer(handle, 0));
+    test_written(root, "{\"first\":null,\"a\":[1,7,2],\"d\":0,\"e\":1,\"f\":2,\"g\":3,\"h\":4,\"i\":5}");
+    TEST_CHECK(test_parents(root) && test_parents(array));
+    TEST_CHECK(test_found(handle, root));
+}
+
+// NOTE: After the first round every element, children array and key
+// index comes from the free lists, so the handle stops growing.
+static void test_reuse(NUJHandle handle)
+{
+    NUJElement* root = nuj_create_element_object(handle, 0);
+    unsigned long long used_size = 0;
+    unsigned int round = 0;
+    unsigned int i = 0;
+
+    nuj_insert_element(handle, root, 0, "x", nuj_create_element_null(handle));
+
+    for (round = 0; round < 100; ++round)
+    {
+        NUJElement* object = nuj_create_element_object(handle, 0);
+
+        for (i = 0; i < 20; ++i)
+        {
+            nuj_insert_element(handle, object, 0, test_keys[i], nuj_create_element_integer(handle, i));
+        }
+
+        TEST_CHECK(test_found(handle, object));
+
+        if (round % 2)
+        {
+            nuj_replace_element(handle, NUJ_CHILD(root, 0), object);
+        }
+        else
+        {
+            nuj_remove_element(handle, NUJ_CHILD(root, 0));
+            nuj_insert_element(handle, root, 0, "x", object);
+        }
+
+        if (round == 1)
+        {
+            used_size = nuj_get_used_size(handle);
+        }
+        else if (round > 1 && !TEST_CHECK(nuj_get_used_size(handle) == used_size))
+        {
+            fprintf(stderr, "  round %u used %llu bytes, was %llu\n", round, nuj_get_used_size(handle), used_size);
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    NUJHandle handle = test_create_handle();
+    static long long memory[1 << 13];
+    NUJHandle fixed_handle = nuj_init(memory, sizeof(memory));
+    unsigned int i = 0;
+
+    for (i = 0; i < TEST_KEY_COUNT; ++i)
+    {
+        snprintf(test_keys[i], sizeof(test_keys[i]), "k%u", i);
+    }
+
+    test_insert(handle);
+    test_remove(handle);
+    test_replace(handle);
+    test_parsed(handle);
+    test_reuse(handle);
+
+    nuj_reset_used_size(handle);
+    test_reuse(handle);
+
+    test_insert(fixed_handle);
+    test_reuse(fixed_handle);
+
+    nuj_release(handle);
+
+    return test_finish("nu_json_edit_test");
+}
@@ -0,0 +1,205 @@
+// NOTE: Lookups through a key index, built by the parser with
+// NUJ_PARSE_INDEX_KEYS or on the first lookup with a handle, must find
+// the same child as a linear search, and an index must be dropped when
+// a child is added.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+#define TEST_KEY_COUNT 100
+
+static char test_keys[TEST_KEY_COUNT][8];
+
+// NOTE: An object with count members k0..k(count-1), each one's value
+// its number, then a duplicated k0 and a nested object "n" of its own
+// count members.
+static char* test_create_object(unsigned int count)
+{
+    char* document = (char*)malloc(count * 32 + 64);
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    length += (unsigned int)sprintf(document, "{");
+
+    for (i = 0; i < count; ++i)
+    {
+        length += (unsigned int)sprintf(document + length, "\"%s\":%u,", test_keys[i], i);
+    }
+
+    length += (unsigned int)sprintf(document + length, "\"k0\":-1,\"n\":{");
+
+    for (i = 0; i < count; ++i)
+    {
+        length += (unsigned int)sprintf(document + length, "%s\"%s\":%u", i ? "," : "", test_keys[i], i + 1000);
+    }
+
+    memcpy(document + length, "}}", 3);
+
+    return document;
+}
+
+// NOTE: Every name is found, and is the same child a search without a
+// handle finds, which only uses an index that already exists.
+static int test_lookups(NUJHandle handle, NUJElement* object, unsigned int count, long long offset)
+{
+    unsigned int i = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        NUJElement* child = nuj_find_child_by_name(handle, object, test_keys[i]);
+
+        // NOTE: Of duplicated names the first one is found.
+        if (!child || child != nuj_find_child_by_name(0, object, test_keys[i]) ||
+            child->type != NUJInteger_TYPE || NUJ_INTEGER(child)->value != i + offset)
+        {
+            return 0;
+        }
+    }
+
+    return !nuj_find_child_by_name(handle, object, "missing") && !nuj_find_child_by_name(handle, object, "") &&
+           !nuj_find_child_by_name(handle, object, "k");
+}
+
+static void test_eager(unsigned int count)
+{
+    char* document = test_create_object(count);
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse_flags(handle, (const unsigned char*)document, 0, NUJ_PARSE_INDEX_KEYS);
+    NUJElement* nested = 0;
+    int indexed = count + 2 >= NUJ_KEY_INDEX_MIN_COUNT;
+
+    if (TEST_CHECK(root != 0))
+    {
+        nested = nuj_find_child_by_name(0, root, "n");
+        TEST_CHECK(nested != 0 && nested->type == NUJObject_TYPE);
+        TEST_CHECK((NUJ_OBJECT(root)->index != 0) == indexed);
+        TEST_CHECK((NUJ_OBJECT(nested)->index != 0) == (count >= NUJ_KEY_INDEX_MIN_COUNT));
+        TEST_CHECK(test_lookups(0, root, count, 0));
+        TEST_CHECK(test_lookups(0, nested, count, 1000));
+
+        // NOTE: The deep search uses the indexes and finds the root's
+        // child before the nested one.
+        TEST_CHECK(nuj_find_element_by_name(root, test_keys[count - 1]) == NUJ_CHILD(root, count - 1));
+        TEST_CHECK(nuj_find_element_by_name(nested, test_keys[count - 1]) == NUJ_CHILD(nested, count - 1));
+    }
+
+    nuj_release(handle);
+    free(document);
+}
+
+static void test_lazy(unsigned int count)
+{
+    char* document = test_create_object(count);
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)document, 0);
+    unsigned long long used_size = 0;
+
+    if (TEST_CHECK(root != 0))
+    {
+        // NOTE: Without a handle nothing is built.
+        TEST_CHECK(!NUJ_OBJECT(root)->index);
+        TEST_CHECK(test_lookups(0, root, count, 0));
+        TEST_CHECK(!NUJ_OBJECT(root)->index);
+
+        TEST_CHECK(test_lookups(handle, root, count, 0));
+        TEST_CHECK((NUJ_OBJECT(root)->index != 0) == (count + 2 >= NUJ_KEY_INDEX_MIN_COUNT));
+
+        // NOTE: The index is built once.
+        used_size = nuj_get_used_size(handle);
+        TEST_CHECK(test_lookups(handle, root, count, 0));
+        TEST_CHECK(nuj_get_used_size(handle) == used_size);
+
+        // NOTE: Small objects are indexed on request.
+        if (!NUJ_OBJECT(root)->index)
+        {
+            nuj_index_keys(handle, root);
+            TEST_CHECK(NUJ_OBJECT(root)->index != 0);
+            TEST_CHECK(test_lookups(0, root, count, 0));
+        }
+    }
+
+    nuj_release(handle);
+    free(document);
+}
+
+// NOTE: nuj_add_element_element clears the index, the next lookup
+// with a handle builds it again with the new child in it.
+static void test_add(void)
+{
+    NUJHandle handle = test_create_handle();
+    NUJElement* object = nuj_create_element_object(handle, TEST_KEY_COUNT);
+    unsigned int i = 0;
+
+    for (i = 0; i < TEST_KEY_COUNT / 2; ++i)
+    {
+        nuj_add_element_element(object, test_keys[i], nuj_create_element_integer(handle, i));
+    }
+
+    TEST_CHECK(test_lookups(handle, object, TEST_KEY_COUNT / 2, 0));
+    TEST_CHECK(NUJ_OBJECT(object)->index != 0);
+
+    for (; i < TEST_KEY_COUNT; ++i)
+    {
+        nuj_add_element_element(object, test_keys[i], nuj_create_element_integer(handle, i));
+        TEST_CHECK(!NUJ_OBJECT(object)->index);
+
+        // NOTE: Every other child is looked up right away, the rest
+        // after the next one is added.
+        if (i % 2)
+        {
+            TEST_CHECK(test_lookups(handle, object, i + 1, 0));
+            TEST_CHECK(NUJ_OBJECT(object)->index != 0);
+        }
+        else
+        {
+            TEST_CHECK(test_lookups(0, object, i + 1, 0));
+        }
+    }
+
+    TEST_CHECK(test_lookups(handle, object, TEST_KEY_COUNT, 0));
+    nuj_release(handle);
+}
+
+// NOTE: Without room for the index lookups are linear, and still right.
+static void test_full(void)
+{
+    static long long memory[1 << 12];
+    char* document = test_create_object(40);
+    unsigned long long size = nuj_measure_flags((const unsigned char*)document, 0, 0);
+    NUJHandle handle = nuj_init(memory, nuj_get_init_size(size));
+    NUJElement* root = nuj_parse_flags(handle, (const unsigned char*)document, 0, NUJ_PARSE_INDEX_KEYS);
+
+    if (TEST_CHECK(root != 0))
+    {
+        TEST_CHECK(!NUJ_OBJECT(root)->index);
+        TEST_CHECK(test_lookups(handle, root, 40, 0));
+        TEST_CHECK(!NUJ_OBJECT(root)->index);
+    }
+
+    free(document);
+}
+
+int main(void)
+{
+    static const unsigned int counts[] = { 1, 5, 6, 7, 8, 9, 15, 16, 17, 40, TEST_KEY_COUNT };
+    unsigned int i = 0;
+
+    for (i = 0; i < TEST_KEY_COUNT; ++i)
+    {
+        snprintf(test_keys[i], sizeof(test_keys[i]), "k%u", i);
+    }
+
+    for (i = 0; i < sizeof(counts) / sizeof(*counts); ++i)
+    {
+        test_eager(counts[i]);
+        test_lazy(counts[i]);
+    }
+
+    test_add();
+    test_full();
+
+    return test_finish("nu_json_index_test");
+}
@@ -0,0 +1,305 @@
+// NOTE: Handles that share an intern table must give the same name the
+// same pointer, nuj_find_child_by_interned_name must find what
+// nuj_find_child_by_name finds, a frozen table must take no new names
+// and with a table nuj_measure must stay an upper bound.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+// NOTE: a and b are the same tree parsed by handles sharing table.
+// Every name is the interned one, in both trees.
+static int test_same_names(NUJInternTable* table, NUJElement* a, NUJElement* b)
+{
+    unsigned int i = 0;
+    int result = a->type == b->type;
+
+    if (result && a->name)
+    {
+        result = a->name == b->name && a->name == nuj_intern_name(table, a->name, a->name_length);
+    }
+
+    if (result && (a->type == NUJObject_TYPE || a->type == NUJArray_TYPE))
+    {
+        result = NUJ_CHILD_COUNT(a) == NUJ_CHILD_COUNT(b);
+
+        for (i = 0; result && i < NUJ_CHILD_COUNT(a); ++i)
+        {
+            NUJElement* child = NUJ_CHILD(a, i);
+
+            result = test_same_names(table, child, NUJ_CHILD(b, i));
+
+            // NOTE: Of duplicated names both find the same one.
+            if (result && a->type == NUJObject_TYPE)
+            {
+                result = nuj_find_child_by_interned_name(a, child->name) == nuj_find_child_by_name(0, a, child->name);
+            }
+        }
+    }
+
+    if (result && a->type == NUJObject_TYPE)
+    {
+        result = !nuj_find_child_by_interned_name(a, nuj_intern_name(table, "missing", 7));
+    }
+
+    return result;
+}
+
+static void test_shared(unsigned int flags)
+{
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle a = test_create_handle();
+    NUJHandle b = test_create_handle();
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 0);
+    unsigned int i = 0;
+
+    nuj_set_intern_table(a, table);
+    nuj_set_intern_table(b, table);
+
+    for (i = 0; table && test_get_document(i); ++i)
+    {
+        const char* text = test_get_document(i);
+        NUJElement* a_root = nuj_parse_flags(a, (const unsigned char*)text, 0, flags);
+        NUJElement* b_root = nuj_parse_flags(b, (const unsigned char*)text, 0, flags);
+
+        if (!TEST_CHECK(a_root && b_root && test_same_names(table, a_root, b_root)))
+        {
+            fprintf(stderr, "  %.60s\n", text);
+        }
+    }
+
+    // NOTE: With views names point into the buffer instead.
+    if (table)
+    {
+        const char* text = "{\"view\":1}";
+        NUJElement* root = nuj_parse_flags(a, (const unsigned char*)text, 0, NUJ_PARSE_VIEWS);
+
+        TEST_CHECK(root && NUJ_CHILD(root, 0)->name == text + 2);
+    }
+
+    TEST_CHECK(table != 0);
+
+    nuj_release(b);
+    nuj_release(a);
+    nuj_release(table_handle);
+}
+
+// NOTE: The push parser interns names split across chunks too.
+static void test_push(void)
+{
+    static const char text[] = "{\"alpha\":[{\"beta\":1,\"gamma\":{\"alpha\":2}}],\"beta\":3}";
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle handle = test_create_handle();
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 4);
+    NUJPushParser* parser = 0;
+    NUJElement* root = 0;
+    unsigned int i = 0;
+
+    nuj_set_intern_table(handle, table);
+    parser = nuj_push_begin(handle, 0);
+
+    for (i = 0; parser && i < sizeof(text) - 1; i += 3)
+    {
+        TEST_CHECK(nuj_push_feed(parser, (const unsigned char*)text + i, sizeof(text) - 1 - i < 3 ? sizeof(text) - 1 - i : 3));
+    }
+
+    root = parser ? nuj_push_end(parser) : 0;
+
+    if (TEST_CHECK(root != 0))
+    {
+        NUJElement* alpha = NUJ_CHILD(root, 0);
+        NUJElement* inner = NUJ_CHILD(alpha, 0);
+
+        TEST_CHECK(alpha->name == nuj_intern_name(table, "alpha", 5));
+        TEST_CHECK(NUJ_CHILD(root, 1)->name == nuj_intern_name(table, "beta", 4));
+        TEST_CHECK(NUJ_CHILD(inner, 0)->name == NUJ_CHILD(root, 1)->name);
+        TEST_CHECK(NUJ_CHILD(NUJ_CHILD(inner, 1), 0)->name == alpha->name);
+        TEST_CHECK(nuj_find_child_by_interned_name(root, nuj_intern_name(table, "beta", 4)) == NUJ_CHILD(root, 1));
+    }
+
+    nuj_release(handle);
+    nuj_release(table_handle);
+}
+
+// NOTE: A frozen table only gives names it had before, the others are
+// copied as if there was no table.
+static void test_frozen(void)
+{
+    static const char text[] = "{\"known\":1,\"new\":{\"known\":2,\"new\":3}}";
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle handle = test_create_handle();
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 0);
+    const char* known = table ? nuj_intern_name(table, "known", 5) : 0;
+    unsigned long long table_size = nuj_get_used_size(table_handle);
+    NUJElement* root = 0;
+
+    if (TEST_CHECK(known != 0))
+    {
+        nuj_freeze_intern_table(table);
+        nuj_set_intern_table(handle, table);
+        root = nuj_parse(handle, (const unsigned char*)text, 0);
+    }
+
+    if (TEST_CHECK(root != 0))
+    {
+        NUJElement* child = NUJ_CHILD(root, 1);
+
+        TEST_CHECK(NUJ_CHILD(root, 0)->name == known && NUJ_CHILD(child, 0)->name == known);
+        TEST_CHECK(!strcmp(child->name, "new") && !strcmp(NUJ_CHILD(child, 1)->name, "new"));
+        TEST_CHECK(child->name != NUJ_CHILD(child, 1)->name);
+        TEST_CHECK(nuj_find_child_by_interned_name(child, known) == NUJ_CHILD(child, 0));
+        TEST_CHECK(!nuj_intern_name(table, "new", 3));
+        TEST_CHECK(nuj_intern_name(table, "known", 5) == known);
+        TEST_CHECK(nuj_get_used_size(table_handle) == table_size && table->count == 1);
+    }
+
+    nuj_release(handle);
+    nuj_release(table_handle);
+}
+
+// NOTE: Lines parsed on several handles share a frozen table.
+static void test_lines(void)
+{
+    static const char text[] = "{\"id\":1,\"tag\":\"a\"}\n{\"id\":2,\"other\":0}\n{\"tag\":\"b\",\"id\":3}\n";
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle handles[3];
+    NUJElement* roots[3] = { 0 };
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 0);
+    const char* id = table ? nuj_intern_name(table, "id", 2) : 0;
+    const char* tag = table ? nuj_intern_name(table, "tag", 3) : 0;
+    unsigned int i = 0;
+
+    if (table)
+    {
+        nuj_freeze_intern_table(table);
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        handles[i] = test_create_handle();
+        nuj_set_intern_table(handles[i], table);
+    }
+
+    if (TEST_CHECK(table && nuj_parse_lines(handles, 3, (const unsigned char*)text, sizeof(text) - 1, 0, roots, 3) == 3))
+    {
+        TEST_CHECK(NUJ_CHILD(roots[0], 0)->name == id && NUJ_CHILD(roots[1], 0)->name == id && NUJ_CHILD(roots[2], 1)->name == id);
+        TEST_CHECK(NUJ_CHILD(roots[0], 1)->name == tag && NUJ_CHILD(roots[2], 0)->name == tag);
+        TEST_CHECK(!strcmp(NUJ_CHILD(roots[1], 1)->name, "other") && table->count == 2);
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        nuj_release(handles[i]);
+    }
+
+    nuj_release(table_handle);
+}
+
+// NOTE: Many more names than the first capacity, each stays interned
+// as the table grows, and names that don't fit a full table handle are
+// copied instead.
+static void test_grow(void)
+{
+    static long long memory[1 << 10];
+    char* text = (char*)malloc(2000 * 16);
+    char name[16];
+    NUJHandle handle = test_create_handle();
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle small_handle = 0;
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 16);
+    NUJElement* root = 0;
+    unsigned int length = 0;
+    unsigned int i = 0;
+    int result = 1;
+
+    text[length++] = '{';
+
+    for (i = 0; i < 2000; ++i)
+    {
+        length += (unsigned int)sprintf(text + length, "%s\"n%u\":%u", i ? "," : "", i, i);
+    }
+
+    memcpy(text + length, "}", 2);
+
+    nuj_set_intern_table(handle, table);
+    root = table ? nuj_parse_flags(handle, (const unsigned char*)text, 0, NUJ_PARSE_INDEX_KEYS) : 0;
+
+    if (TEST_CHECK(root && NUJ_CHILD_COUNT(root) == 2000))
+    {
+        for (i = 0; result && i < 2000; ++i)
+        {
+            const char* interned = nuj_intern_name(table, name, (unsigned int)sprintf(name, "n%u", i));
+
+            result = NUJ_CHILD(root, i)->name == interned && nuj_find_child_by_interned_name(root, interned) == NUJ_CHILD(root, i);
+        }
+
+        TEST_CHECK(result);
+        TEST_CHECK(table->count == 2000 && table->count * 2 <= table->mask + 1);
+    }
+
+    // NOTE: The table fills its handle after a few names.
+    small_handle = nuj_init(memory, sizeof(memory));
+    table = nuj_create_intern_table(small_handle, 16);
+    nuj_set_intern_table(handle, table);
+    root = table ? nuj_parse(handle, (const unsigned char*)text, 0) : 0;
+
+    if (TEST_CHECK(root && NUJ_CHILD_COUNT(root) == 2000))
+    {
+        TEST_CHECK(table->count < 2000 && !nuj_intern_name(table, "n1999", 5));
+        TEST_CHECK(!strcmp(NUJ_CHILD(root, 1999)->name, "n1999"));
+        TEST_CHECK(NUJ_CHILD(root, 0)->name == nuj_intern_name(table, "n0", 2));
+    }
+
+    nuj_release(table_handle);
+    nuj_release(handle);
+    free(text);
+}
+
+// NOTE: nuj_measure is what a handle without a table uses, and a bound
+// of what one with a table uses, whether the table has the names yet
+// or not.
+static void test_measure(void)
+{
+    NUJHandle table_handle = test_create_handle();
+    NUJHandle handle = test_create_handle();
+    NUJInternTable* table = nuj_create_intern_table(table_handle, 0);
+    unsigned int i = 0;
+
+    for (i = 0; table && test_get_document(i); ++i)
+    {
+        const unsigned char* text = (const unsigned char*)test_get_document(i);
+        unsigned long long size = nuj_measure(text, 0);
+        unsigned long long first_size = 0;
+
+        nuj_set_intern_table(handle, 0);
+        TEST_CHECK(nuj_parse(handle, text, 0) && nuj_get_used_size(handle) == size);
+
+        nuj_set_intern_table(handle, table);
+        TEST_CHECK(nuj_parse(handle, text, 0) && nuj_get_used_size(handle) <= size);
+        first_size = nuj_get_used_size(handle);
+
+        // NOTE: Once the table has them no name is pushed.
+        TEST_CHECK(nuj_parse(handle, text, 0) && nuj_get_used_size(handle) == first_size);
+        TEST_CHECK(i < 1 || first_size < size);
+    }
+
+    TEST_CHECK(table != 0);
+
+    nuj_release(handle);
+    nuj_release(table_handle);
+}
+
+int main(void)
+{
+    test_shared(0);
+    test_shared(NUJ_PARSE_INDEX_KEYS);
+    test_push();
+    test_frozen();
+    test_lines();
+    test_grow();
+    test_measure();
+
+    return test_finish("nu_json_intern_test");
+}
@@ -0,0 +1,265 @@
+// NOTE: nuj_parse_lines must return the records in the order of their
+// lines on any number of handles, with blank lines skipped and invalid
+// records as 0, and nuj_parse_lines_partial fed a stream in pieces
+// must consume exactly the lines it parsed.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+#define TEST_HANDLE_COUNT 8
+#define TEST_LINE_COUNT 3000
+
+typedef struct TestLines
+{
+    char* text;
+    unsigned int length;
+    // NOTE: Written form of each record, "(null)" if it is invalid.
+    char* records[TEST_LINE_COUNT];
+    unsigned int record_count;
+} TestLines;
+
+static void test_append(TestLines* lines, const char* text)
+{
+    unsigned int size = (unsigned int)strlen(text);
+
+    lines->text = (char*)realloc(lines->text, lines->length + size + 1);
+    memcpy(lines->text + lines->length, text, size + 1);
+    lines->length += size;
+}
+
+static void test_append_record(TestLines* lines, const char* line, const char* record)
+{
+    test_append(lines, line);
+    lines->records[lines->record_count] = (char*)malloc(strlen(record) + 1);
+    strcpy(lines->records[lines->record_count++], record);
+}
+
+// NOTE: Records of every kind of value and of many lengths, between
+// blank lines, with spaces and carriage returns around them.
+static void test_create_lines(TestLines* lines)
+{
+    char line[512];
+    char record[256];
+    unsigned int i = 0;
+
+    memset(lines, 0, sizeof(*lines));
+
+    for (i = 0; i < TEST_LINE_COUNT; ++i)
+    {
+        switch (i % 9)
+        {
+            case 0:
+            {
+                sprintf(record, "{\"id\":%u,\"name\":\"n%.*s\"}", i, (int)(i % 37), "abcdefghijklmnopqrstuvwxyz0123456789,");
+                sprintf(line, "%s\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+            case 1:
+            {
+                sprintf(record, "[%u,\"x\\\"\\n\"]", i);
+                sprintf(line, "%s\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+            case 2: { test_append(lines, "\n");     } break;
+            case 3: { test_append(lines, "  \t\n"); } break;
+            case 4:
+            {
+                sprintf(record, "{\"id\":%u}", i);
+                sprintf(line, "  %s  \r\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+            case 5:
+            {
+                sprintf(line, "{\"id\":%u,\n", i);
+                test_append_record(lines, line, "(null)");
+            }
+            break;
+            case 6:
+            {
+                sprintf(record, "\"s%u\"", i);
+                sprintf(line, "%s\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+            case 7:
+            {
+                sprintf(record, "%u", i);
+                sprintf(line, "%s\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+            case 8:
+            {
+                sprintf(record, "{\"nested\":{\"a\":[%u,{\"b\":null}]},\"t\":true}", i);
+                sprintf(line, "%s\n", record);
+                test_append_record(lines, line, record);
+            }
+            break;
+        }
+    }
+}
+
+static void test_free_lines(TestLines* lines)
+{
+    unsigned int i = 0;
+
+    for (i = 0; i < lines->record_count; ++i)
+    {
+        free(lines->records[i]);
+    }
+
+    free(lines->text);
+}
+
+// NOTE: roots[i] is written as records[first + i].
+static int test_roots(const TestLines* lines, unsigned int first, NUJElement** roots, unsigned long long root_count)
+{
+    unsigned long long i = 0;
+    int result = 1;
+
+    for (i = 0; result && i < root_count; ++i)
+    {
+        char* text = test_write(roots[i]);
+
+        result = !strcmp(text, lines->records[first + i]);
+
+        if (!result)
+        {
+            fprintf(stderr, "  record %llu: expected %s, actual %s\n", first + i, lines->records[first + i], text);
+        }
+
+        free(text);
+    }
+
+    return result;
+}
+
+static void test_lines(NUJHandle* handles, const TestLines* lines, NUJElement** roots)
+{
+    unsigned int handle_count = 0;
+
+    TEST_CHECK(nuj_count_lines((const unsigned char*)lines->text, lines->length) == lines->record_count);
+
+    for (handle_count = 1; handle_count <= TEST_HANDLE_COUNT; ++handle_count)
+    {
+        unsigned long long count = nuj_parse_lines(handles, handle_count, (const unsigned char*)lines->text, lines->length, 0, roots, lines->record_count);
+
+        TEST_CHECK(count == lines->record_count);
+        TEST_CHECK(test_roots(lines, 0, roots, count));
+
+        // NOTE: At most root_count are parsed, the rest of roots is
+        // left alone.
+        roots[100] = (NUJElement*)roots;
+        count = nuj_parse_lines(handles, handle_count, (const unsigned char*)lines->text, lines->length, 0, roots, 100);
+        TEST_CHECK(count == 100 && test_roots(lines, 0, roots, count));
+        TEST_CHECK(roots[100] == (NUJElement*)roots);
+    }
+
+    // NOTE: Without a newline at its end the last line is a record.
+    TEST_CHECK(nuj_parse_lines(handles, 3, (const unsigned char*)"{}\n\n[1]", 7, 0, roots, 10) == 2);
+    TEST_CHECK(roots[0] && roots[0]->type == NUJObject_TYPE && roots[1] && roots[1]->type == NUJArray_TYPE);
+    TEST_CHECK(nuj_parse_lines(handles, 3, (const unsigned char*)"\n \n", 3, 0, roots, 10) == 0);
+    TEST_CHECK(nuj_parse_lines(handles, 3, (const unsigned char*)"", 0, 0, roots, 10) == 0);
+}
+
+// NOTE: The stream arrives in pieces of odd sizes, each call gets what
+// wasn't consumed before and the next piece, and takes at most
+// max_root_count records.
+static void test_partial(NUJHandle* handles, unsigned int handle_count, const TestLines* lines, NUJElement** roots, unsigned long long max_root_count)
+{
+    unsigned long long offset = 0;
+    unsigned long long available = 0;
+    unsigned int record_count = 0;
+    unsigned int piece = 0;
+    int result = 1;
+
+    while (result && offset < lines->length)
+    {
+        unsigned long long consumed_size = ~0ull;
+        unsigned long long count = 0;
+        const char* newline = 0;
+
+        available += 1 + (piece++ * 7919) % 1500;
+
+        if (offset + available > lines->length)
+        {
+            available = lines->length - offset;
+        }
+
+        count = nuj_parse_lines_partial(handles, handle_count, (const unsigned char*)lines->text + offset, available, 0, roots, max_root_count, &consumed_size);
+
+        // NOTE: Everything up to the last newline is consumed, unless
+        // roots ran out, then up to the end of the last record.
+        result = consumed_size <= available && (!consumed_size || lines->text[offset + consumed_size - 1] == '\n');
+        result = result && test_roots(lines, record_count, roots, count);
+
+        if (result && count < max_root_count)
+        {
+            newline = (const char*)memchr(lines->text + offset + consumed_size, '\n', (size_t)(available - consumed_size));
+            result = !newline;
+        }
+        else if (result)
+        {
+            result = nuj_count_lines((const unsigned char*)lines->text + offset, consumed_size) == count;
+        }
+
+        record_count += (unsigned int)count;
+        offset += consumed_size;
+        available -= consumed_size;
+    }
+
+    if (!TEST_CHECK(result && record_count == lines->record_count && offset == lines->length))
+    {
+        fprintf(stderr, "  %u handles, %llu roots: %u of %u records, %llu of %u bytes\n",
+                handle_count, max_root_count, record_count, lines->record_count, offset, lines->length);
+    }
+}
+
+int main(void)
+{
+    static const unsigned long long max_root_counts[] = { 1, 7, 100, TEST_LINE_COUNT };
+    static TestLines lines;
+    NUJHandle handles[TEST_HANDLE_COUNT];
+    NUJElement** roots = (NUJElement**)malloc(sizeof(NUJElement*) * (TEST_LINE_COUNT + 1));
+    unsigned long long consumed_size = 0;
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for (i = 0; i < TEST_HANDLE_COUNT; ++i)
+    {
+        handles[i] = test_create_handle();
+    }
+
+    test_create_lines(&lines);
+    test_lines(handles, &lines, roots);
+
+    for (i = 1; i <= TEST_HANDLE_COUNT; i += 3)
+    {
+        for (j = 0; j < sizeof(max_root_counts) / sizeof(*max_root_counts); ++j)
+        {
+            test_partial(handles, i, &lines, roots, max_root_counts[j]);
+        }
+    }
+
+    // NOTE: A line without its newline is left for the next call.
+    TEST_CHECK(nuj_parse_lines_partial(handles, 2, (const unsigned char*)"{}\n[1]", 6, 0, roots, 10, &consumed_size) == 1);
+    TEST_CHECK(consumed_size == 3);
+    TEST_CHECK(nuj_parse_lines_partial(handles, 2, (const unsigned char*)"[1]", 3, 0, roots, 10, &consumed_size) == 0);
+    TEST_CHECK(consumed_size == 0);
+
+    for (i = 0; i < TEST_HANDLE_COUNT; ++i)
+    {
+        nuj_release(handles[i]);
+    }
+
+    test_free_lines(&lines);
+    free(roots);
+
+    return test_finish("nu_json_lines_test");
+}
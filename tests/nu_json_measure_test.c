@@ -0,0 +1,126 @@
+// NOTE: nuj_measure_flags must return exactly what nuj_parse_flags
+// pushes for every flag, so a handle of nuj_get_init_size of it is
+// just large enough and one byte less is not.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static const char* test_documents[] =
+{
+    "{}",
+    "{\"a\":1}",
+    "{\"a\":[],\"b\":{},\"c\":[[]],\"d\":[{}]}",
+    "{\"s\":\"plain\",\"e\":\"\",\"t\":true,\"f\":false,\"n\":null,\"i\":-42,\"d\":1.5e-3}",
+    "{\"esc\":\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\",\"u\":\"\\u00e9\\u20ac\\ud83d\\ude00\",\"k\\u00e9y\":\"v\"}",
+    "{\"k0\":0,\"k1\":1,\"k2\":2,\"k3\":3,\"k4\":4,\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,\"k9\":9,\"nested\":{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}}",
+    "{\"deep\":[[[[[[[[[[[[[[[[[[[[\"x\"]]]]]]]]]]]]]]]]]]]]}",
+    " \t\n{ \"spaced\" : [ 1 , 2 , 3 ] , \"out\" : { } } \n",
+};
+
+static const char* test_invalid_documents[] =
+{
+    "",
+    "[1,2]",
+    "{",
+    "{\"a\":}",
+    "{\"a\":1,}",
+    "{\"a\":1} x",
+};
+
+// NOTE: An object of count records with repeated keys and strings of
+// every length, large enough to need several blocks of a chained
+// handle.
+static char* test_create_records(unsigned int count)
+{
+    char* document = (char*)malloc(count * 96 + 16);
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    length += (unsigned int)sprintf(document, "{\"records\":[");
+
+    for (i = 0; i < count; ++i)
+    {
+        length += (unsigned int)sprintf(document + length, "%s{\"id\":%u,\"name\":\"%.*s\",\"score\":%g,\"tags\":[\"t%u\"]}",
+                                        i ? "," : "", i, (int)(i % 23), "abcdefghijklmnopqrstuvwxyz", i / 8.0, i % 5);
+    }
+
+    memcpy(document + length, "]}", 3);
+
+    return document;
+}
+
+static void test_measure(const char* document, unsigned int flags)
+{
+    static long long memory[1 << 18];
+    unsigned long long length = strlen(document);
+    unsigned long long size = nuj_measure_flags((const unsigned char*)document, length, flags);
+    unsigned long long init_size = nuj_get_init_size(size);
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse_flags(handle, (const unsigned char*)document, length, flags);
+
+    if (!TEST_CHECK(root && size == nuj_get_used_size(handle)))
+    {
+        fprintf(stderr, "  flags %u measured %llu, used %llu: %.60s\n", flags, size, nuj_get_used_size(handle), document);
+    }
+
+    nuj_release(handle);
+
+    // NOTE: Exactly enough memory, then one byte short.
+    if (TEST_CHECK(init_size <= sizeof(memory)))
+    {
+        handle = nuj_init(memory, init_size);
+        TEST_CHECK(nuj_parse_flags(handle, (const unsigned char*)document, length, flags) != 0);
+        TEST_CHECK(nuj_get_used_size(handle) == size);
+
+        // NOTE: Key indexes are left out when they don't fit, so the
+        // parse can still succeed, just without one of them.
+        handle = nuj_init(memory, init_size - 1);
+        root = nuj_parse_flags(handle, (const unsigned char*)document, length, flags);
+        TEST_CHECK(!root || ((flags & NUJ_PARSE_INDEX_KEYS) && nuj_get_used_size(handle) < size));
+    }
+
+    // NOTE: In place parsing takes what views take.
+    if (flags & NUJ_PARSE_VIEWS)
+    {
+        unsigned char* copy = (unsigned char*)malloc(length + 1);
+
+        memcpy(copy, document, length + 1);
+        handle = test_create_handle();
+        TEST_CHECK(nuj_parse_insitu(handle, copy, length, flags) != 0);
+        TEST_CHECK(nuj_get_used_size(handle) == size);
+        nuj_release(handle);
+        free(copy);
+    }
+}
+
+int main(void)
+{
+    static const unsigned int flags[] = { 0, NUJ_PARSE_INDEX_KEYS, NUJ_PARSE_VIEWS, NUJ_PARSE_VIEWS | NUJ_PARSE_INDEX_KEYS };
+    char* records = test_create_records(2000);
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for (j = 0; j < sizeof(flags) / sizeof(*flags); ++j)
+    {
+        for (i = 0; i < sizeof(test_documents) / sizeof(*test_documents); ++i)
+        {
+            test_measure(test_documents[i], flags[j]);
+        }
+
+        test_measure(records, flags[j]);
+
+        for (i = 0; i < sizeof(test_invalid_documents) / sizeof(*test_invalid_documents); ++i)
+        {
+            TEST_CHECK(!nuj_measure_flags((const unsigned char*)test_invalid_documents[i], strlen(test_invalid_documents[i]), flags[j]));
+        }
+    }
+
+    TEST_CHECK(nuj_measure((const unsigned char*)records, 0) == nuj_measure_flags((const unsigned char*)records, strlen(records), 0));
+
+    free(records);
+
+    return test_finish("nu_json_measure_test");
+}
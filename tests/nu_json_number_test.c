@@ -0,0 +1,305 @@
+// NOTE: Numbers must parse to the integer or the correctly rounded
+// double that the compiler makes of the same literal, and doubles
+// written by nuj_write must be the shortest that read back as the same
+// bits.  Runs again under a locale with a decimal comma if there is
+// one.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+#include <float.h>
+#include <locale.h>
+
+typedef struct TestNumber
+{
+    const char* text;
+    double value;
+} TestNumber;
+
+static const TestNumber test_doubles[] =
+{
+    { "9223372036854775808", 9223372036854775808.0 },
+    { "-9223372036854775809", -9223372036854775809.0 },
+    { "9223372036854775809", 9223372036854775809.0 },
+    { "12345678901234567890", 12345678901234567890.0 },
+    { "18446744073709551615", 18446744073709551615.0 },
+    { "18446744073709551616", 18446744073709551616.0 },
+    { "1.5", 1.5 },
+    { "-0.0", -0.0 },
+    { "0.1", 0.1 },
+    { "0.30000000000000004", 0.30000000000000004 },
+    { "1e22", 1e22 },
+    { "1e23", 1e23 },
+    { "1E+2", 1e2 },
+    { "-3.25e-7", -3.25e-7 },
+    { "123.456e-2", 1.23456 },
+    { "1e308", 1e308 },
+    { "1.7976931348623157e308", DBL_MAX },
+    { "1.7976931348623158e308", DBL_MAX },
+    { "2.2250738585072014e-308", 2.2250738585072014e-308 },
+    { "2.2250738585072011e-308", 2.2250738585072011e-308 },
+    { "4.9406564584124654e-324", 4.9406564584124654e-324 },
+    { "2.4703282292062328e-324", 4.9406564584124654e-324 },
+    { "2.4703282292062327e-324", 0.0 },
+    { "1e-400", 0.0 },
+    { "9007199254740993.0", 9007199254740992.0 },
+    { "9007199254740995.0", 9007199254740996.0 },
+    { "9007199254740993.0000000000000000000001", 9007199254740994.0 },
+    { "123456789012345678901234567890", 123456789012345678901234567890.0 },
+    { "0.1000000000000000055511151231257827021181583404541015625", 0.1 },
+    { "0.100000000000000012490009027033011079765856266021728515625", 0.1 },
+    { "0.100000000000000012490009027033011079765856266021728515626", 0.10000000000000002 },
+    { "7.3177701707893310e+15", 7.3177701707893310e+15 },
+    { "2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324",
+      0.0 },
+};
+
+typedef struct TestInteger
+{
+    const char* text;
+    long long value;
+} TestInteger;
+
+static const TestInteger test_integers[] =
+{
+    { "0", 0 },
+    { "-0", 0 },
+    { "7", 7 },
+    { "-7", -7 },
+    { "9007199254740993", 9007199254740993LL },
+    { "9223372036854775807", 9223372036854775807LL },
+    { "-9223372036854775807", -9223372036854775807LL },
+    { "-9223372036854775808", -9223372036854775807LL - 1 },
+};
+
+static char test_document[4096];
+
+// NOTE: Parses {"n":text} and returns the child, 0 if that failed.
+static const NUJElement* test_parse(NUJHandle handle, const char* text)
+{
+    NUJElement* root = 0;
+
+    snprintf(test_document, sizeof(test_document), "{\"n\":%s}", text);
+    nuj_reset_used_size(handle);
+    root = nuj_parse_flags(handle, (const unsigned char*)test_document, 0, NUJ_PARSE_SOFT_ERRORS);
+
+    return root && NUJ_CHILD_COUNT(root) == 1 ? NUJ_CHILD(root, 0) : 0;
+}
+
+static int test_same_bits(double a, double b)
+{
+    return !memcmp(&a, &b, sizeof(a));
+}
+
+static void test_parse_double(NUJHandle handle, const char* text, double value)
+{
+    const NUJElement* element = test_parse(handle, text);
+
+    if (!TEST_CHECK(element && element->type == NUJDouble_TYPE && test_same_bits(NUJ_DOUBLE(element)->value, value)))
+    {
+        fprintf(stderr, "  %.40s parsed to %.17g, expected %.17g\n", text,
+                element && element->type == NUJDouble_TYPE ? NUJ_DOUBLE(element)->value : 0.0, value);
+    }
+}
+
+// NOTE: Digits past the 767 that can decide the rounding are only
+// checked for being 0.  9007199254740993 is halfway between two
+// doubles, so it goes to the even one unless any digit after it isn't
+// 0, however far away.
+static void test_long_numbers(NUJHandle handle)
+{
+    static char text[2048];
+    unsigned int length = 0;
+
+    length = (unsigned int)sprintf(text, "9007199254740993.");
+    memset(text + length, '0', 1000);
+    length += 1000;
+    text[length] = '\0';
+    test_parse_double(handle, text, 9007199254740992.0);
+
+    text[length - 1] = '1';
+    test_parse_double(handle, text, 9007199254740994.0);
+
+    // NOTE: 1 with 1200 zeros, scaled back down by the exponent.
+    text[0] = '1';
+    memset(text + 1, '0', 1200);
+    strcpy(text + 1201, "e-1200");
+    test_parse_double(handle, text, 1.0);
+
+    strcpy(text, "0.");
+    memset(text + 2, '0', 320);
+    strcpy(text + 322, "123456789012345678901234567890");
+    test_parse_double(handle, text, 0.123456789012345678901234567890e-320);
+}
+
+static unsigned long long test_random_state = 0x9E3779B97F4A7C15ull;
+
+// NOTE: The shortest check asks the C library, which follows
+// LC_NUMERIC, so it only runs in the "C" locale.
+static int test_check_shortest = 1;
+
+static unsigned long long test_random(void)
+{
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 7;
+    test_random_state ^= test_random_state << 17;
+
+    return test_random_state;
+}
+
+// NOTE: Significant digits of a number written by nuj_write, without
+// the zeros before the first and after the last digit that isn't 0.
+static int test_digit_count(const char* text)
+{
+    int count = 0;
+    int last = 0;
+
+    for (; *text && *text != 'e'; ++text)
+    {
+        if (*text >= '0' && *text <= '9')
+        {
+            count += count || *text != '0';
+            last = *text != '0' ? count : last;
+        }
+    }
+
+    return last;
+}
+
+static void test_round_trip(NUJHandle handle, NUJHandle write_handle, double value)
+{
+    char text[64];
+    const NUJElement* element = 0;
+    unsigned long long length = 0;
+    int digit_count = 0;
+
+    nuj_reset_used_size(write_handle);
+    length = nuj_write(nuj_create_element_double(write_handle, value), text, sizeof(text), 0);
+    element = test_parse(handle, text);
+
+    if (!TEST_CHECK(length < sizeof(text) && element && element->type == NUJDouble_TYPE && test_same_bits(NUJ_DOUBLE(element)->value, value)))
+    {
+        fprintf(stderr, "  %.17g was written as %s\n", value, text);
+    }
+
+    // NOTE: One digit less can't read back, the C library is trusted
+    // to round correctly.
+    digit_count = test_digit_count(text);
+
+    if (test_check_shortest && digit_count > 1)
+    {
+        char shorter[64];
+
+        snprintf(shorter, sizeof(shorter), "%.*e", digit_count - 2, value);
+
+        if (!TEST_CHECK(strtod(shorter, 0) != value))
+        {
+            fprintf(stderr, "  %s is shorter than %s\n", shorter, text);
+        }
+    }
+}
+
+static void test_numbers(NUJHandle handle, NUJHandle write_handle)
+{
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(test_integers) / sizeof(*test_integers); ++i)
+    {
+        const NUJElement* element = test_parse(handle, test_integers[i].text);
+
+        if (!TEST_CHECK(element && element->type == NUJInteger_TYPE && NUJ_INTEGER(element)->value == test_integers[i].value))
+        {
+            fprintf(stderr, "  %s\n", test_integers[i].text);
+        }
+    }
+
+    for (i = 0; i < sizeof(test_doubles) / sizeof(*test_doubles); ++i)
+    {
+        test_parse_double(handle, test_doubles[i].text, test_doubles[i].value);
+    }
+
+    test_long_numbers(handle);
+
+    {
+        const NUJElement* element = test_parse(handle, "1e400");
+
+        TEST_CHECK(element && element->type == NUJDouble_TYPE && NUJ_DOUBLE(element)->value > DBL_MAX);
+    }
+
+    for (i = 0; i < sizeof(test_doubles) / sizeof(*test_doubles); ++i)
+    {
+        if (test_doubles[i].value <= DBL_MAX)
+        {
+            test_round_trip(handle, write_handle, test_doubles[i].value);
+        }
+    }
+
+    for (i = 0; i < 200000; ++i)
+    {
+        unsigned long long bits = test_random();
+        double value = 0.0;
+
+        // NOTE: Every other value is random bits, the rest are short
+        // decimals, whose shortest digits are much shorter than 17.
+        if (i & 1)
+        {
+            memcpy(&value, &bits, sizeof(value));
+        }
+        else
+        {
+            value = (double)(long long)(bits % 2000001 - 1000000) / (double)(1ULL << (bits >> 59)) / 1000.0;
+        }
+
+        if (value == value && value <= DBL_MAX && value >= -DBL_MAX)
+        {
+            test_round_trip(handle, write_handle, value);
+        }
+    }
+
+    {
+        char text[64];
+
+        nuj_reset_used_size(write_handle);
+        nuj_write(nuj_create_element_double(write_handle, 1.5), text, sizeof(text), 0);
+        TEST_CHECK(!strcmp(text, "1.5"));
+        nuj_write(nuj_create_element_double(write_handle, 100.0), text, sizeof(text), 0);
+        TEST_CHECK(!strcmp(text, "100.0"));
+        nuj_write(nuj_create_element_double(write_handle, -0.0), text, sizeof(text), 0);
+        TEST_CHECK(!strcmp(text, "-0.0"));
+        nuj_write(nuj_create_element_double(write_handle, 1e17), text, sizeof(text), 0);
+        TEST_CHECK(!strcmp(text, "1e+17"));
+        nuj_write(nuj_create_element_double(write_handle, 1e-5), text, sizeof(text), 0);
+        TEST_CHECK(!strcmp(text, "1e-5"));
+    }
+}
+
+int main(void)
+{
+    static const char* comma_locales[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR" };
+    NUJHandle handle = test_create_handle();
+    NUJHandle write_handle = test_create_handle();
+    unsigned int i = 0;
+
+    test_numbers(handle, write_handle);
+
+    for (i = 0; i < sizeof(comma_locales) / sizeof(*comma_locales); ++i)
+    {
+        if (setlocale(LC_NUMERIC, comma_locales[i]))
+        {
+            printf("nu_json_number_test: again with LC_NUMERIC %s\n", comma_locales[i]);
+
+            test_check_shortest = 0;
+            test_random_state = 0x9E3779B97F4A7C15ull;
+            test_numbers(handle, write_handle);
+            break;
+        }
+    }
+
+    nuj_release(handle);
+    nuj_release(write_handle);
+
+    return test_finish("nu_json_number_test");
+}
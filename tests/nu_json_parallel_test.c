@@ -0,0 +1,252 @@
+// NOTE: nuj_parse_parallel must build the same tree as nuj_parse on 1
+// to 8 handles.  Slices are made tiny so even short documents are cut
+// in many places, and the documents have strings full of , ] } and
+// escaped quotes for nuj__find_split to guess wrong about.  nuj_parse
+// only takes an object root, so the document is parsed as the value of
+// {"r":...} there.
+
+#define TRUE 1
+#define FALSE 0
+#define NUJ_PARALLEL_SLICE_SIZE 64
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+#define TEST_HANDLE_COUNT 8
+
+static const char* test_documents[] =
+{
+    "[]",
+    "{}",
+    " [ 1 ] ",
+    "[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40]",
+    "[\"],[\",\"}\",\"\\\"\",\",\\\",\",\"{\\\"a\\\":[1,2]},{\",\"\\\\\",\"\\\\\\\"]\",\"]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]\",\"x\"]",
+    "{\"a,\":\"}\",\"b]\":[\"],\",{\"c\\\"\":\"\\\",\\\"\"}],\"}\":{\"\\\\\":\"\\\\\\\\\"},\"d\":null,\"e\":true,\"f\":-1.5e3}",
+    "[[[[[[[[[[1]]]]]]]]],[[[[[[[[[[\",\"]]]]]]]]]],{\"a\":{\"b\":{\"c\":{\"d\":{\"e\":{\"f\":[\"}]\"]}}}}}}]",
+};
+
+// NOTE: Invalid documents, both parsers must return 0.
+static const char* test_invalid_documents[] =
+{
+    "[",
+    "[1,2",
+    "[1,,2]",
+    "[1,2,]",
+    "{\"a\":1,\"b\"}",
+    "[\"unterminated,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30]",
+    "[{\"a\":[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30]},}]",
+};
+
+static char* test_append(char* document, unsigned int* length, const char* text)
+{
+    unsigned int size = (unsigned int)strlen(text);
+
+    document = (char*)realloc(document, *length + size + 1);
+    memcpy(document + *length, text, size + 1);
+    *length += size;
+
+    return document;
+}
+
+// NOTE: An array of records, or an object of them keyed by number.
+// Strings look like JSON that closes the record early.
+static char* test_create_records(unsigned int record_count, int in_object)
+{
+    static const char* strings[] =
+    {
+        "plain",
+        ",",
+        "],[",
+        "},{\\\"id\\\":",
+        "\\\"]}\\\"",
+        "\\\\",
+        "\\\\\\\",\\\"",
+        "\\u0022,\\u005d",
+    };
+    char* document = 0;
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    document = test_append(document, &length, in_object ? "{" : "[");
+
+    for (i = 0; i < record_count; ++i)
+    {
+        char record[256];
+
+        if (in_object)
+        {
+            snprintf(record, sizeof(record), "%s\"key %u %s\":", i ? "," : "", i, strings[i % 8]);
+        }
+        else
+        {
+            snprintf(record, sizeof(record), "%s", i ? "," : "");
+        }
+
+        document = test_append(document, &length, record);
+        snprintf(record, sizeof(record), "{\"id\":%u,\"s\":\"%s\",\"n\":[%u,%g,{\"x\":\"%s\"}],\"t\":%s}",
+                 i, strings[i % 8], i * 7, i / 4.0, strings[(i + 3) % 8], i % 3 ? "true" : "null");
+        document = test_append(document, &length, record);
+
+        // NOTE: Some records are large enough to hold a split point of
+        // their own, the split must not be taken inside them.
+        if (i % 17 == 5)
+        {
+            unsigned int j = 0;
+
+            document[--length] = '\0';
+            document = test_append(document, &length, ",\"big\":[");
+
+            for (j = 0; j < 40; ++j)
+            {
+                document = test_append(document, &length, j ? ",\"],\"" : "\"],\"");
+            }
+
+            document = test_append(document, &length, "]}");
+        }
+    }
+
+    return test_append(document, &length, in_object ? "}" : "]");
+}
+
+static char* test_parse_sequential(NUJHandle handle, const char* document, unsigned int flags)
+{
+    unsigned int length = 0;
+    char* wrapped = test_append(0, &length, "{\"r\":");
+    NUJElement* root = 0;
+    NUJElement* element = 0;
+    char* text = 0;
+
+    wrapped = test_append(wrapped, &length, document);
+    wrapped = test_append(wrapped, &length, "}");
+
+    root = nuj_parse_flags(handle, (const unsigned char*)wrapped, length, flags);
+    element = root && NUJ_CHILD_COUNT(root) == 1 ? NUJ_CHILD(root, 0) : 0;
+
+    // NOTE: Written without its name, like the root of a document, and
+    // before the buffer NUJ_PARSE_VIEWS points into is freed.
+    if (element)
+    {
+        element->name = 0;
+        element->name_length = 0;
+    }
+
+    text = test_write(element);
+    free(wrapped);
+
+    return text;
+}
+
+// NOTE: Returns how many handles the last parse of document was split
+// across.
+static unsigned int test_document(NUJHandle* handles, NUJHandle handle, const char* document, unsigned int flags)
+{
+    char* expected = test_parse_sequential(handle, document, flags);
+    char* actual = 0;
+    unsigned int handle_count = 0;
+    unsigned int used_count = 0;
+
+    for (handle_count = 1; handle_count <= TEST_HANDLE_COUNT; ++handle_count)
+    {
+        NUJElement* root = nuj_parse_parallel(handles, handle_count, (const unsigned char*)document, 0, flags);
+        unsigned int i = 0;
+
+        actual = test_write(root);
+
+        if (!TEST_CHECK(!strcmp(expected, actual)))
+        {
+            fprintf(stderr, "  %u handles, flags %u\n  expected %.200s\n  actual   %.200s\n", handle_count, flags, expected, actual);
+        }
+
+        TEST_CHECK(!root || (!root->parent && test_parents(root)));
+
+        // NOTE: Every child of an indexed root must be found by its
+        // name, whichever slice it came from.
+        for (i = 0; root && (flags & NUJ_PARSE_INDEX_KEYS) && root->type == NUJObject_TYPE && i < NUJ_CHILD_COUNT(root); ++i)
+        {
+            NUJElement* child = NUJ_CHILD(root, i);
+            char name[256];
+
+            if (child->name_length < sizeof(name) && !memchr(child->name, '\\', child->name_length))
+            {
+                memcpy(name, child->name, child->name_length);
+                name[child->name_length] = '\0';
+                TEST_CHECK(nuj_find_child_by_name(handles[0], root, name) == child);
+            }
+        }
+
+        for (used_count = 0; used_count < handle_count && nuj_get_used_size(handles[used_count]); ++used_count)
+        {
+        }
+
+        free(actual);
+    }
+
+    free(expected);
+
+    return used_count;
+}
+
+int main(void)
+{
+    static const unsigned int flags[] = { 0, NUJ_PARSE_INDEX_KEYS, NUJ_PARSE_VIEWS, NUJ_PARSE_SOFT_ERRORS };
+    NUJHandle handles[TEST_HANDLE_COUNT];
+    NUJHandle handle = test_create_handle();
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    for (i = 0; i < TEST_HANDLE_COUNT; ++i)
+    {
+        handles[i] = test_create_handle();
+    }
+
+    for (j = 0; j < sizeof(flags) / sizeof(*flags); ++j)
+    {
+        for (i = 0; i < sizeof(test_documents) / sizeof(*test_documents); ++i)
+        {
+            test_document(handles, handle, test_documents[i], flags[j]);
+        }
+
+        // NOTE: Without NUJ_PARSE_SOFT_ERRORS a syntax error asserts.
+        for (i = 0; (flags[j] & NUJ_PARSE_SOFT_ERRORS) && i < sizeof(test_invalid_documents) / sizeof(*test_invalid_documents); ++i)
+        {
+            char* text = test_parse_sequential(handle, test_invalid_documents[i], flags[j]);
+            unsigned int handle_count = 0;
+
+            TEST_CHECK(!strcmp(text, "(null)"));
+            free(text);
+
+            for (handle_count = 1; handle_count <= TEST_HANDLE_COUNT; ++handle_count)
+            {
+                TEST_CHECK(!nuj_parse_parallel(handles, handle_count, (const unsigned char*)test_invalid_documents[i], 0, flags[j]));
+            }
+        }
+
+        TEST_CHECK(!nuj_parse_parallel(handles, TEST_HANDLE_COUNT, (const unsigned char*)" \"x\" ", 0, flags[j]));
+
+        for (i = 0; i < 2; ++i)
+        {
+            unsigned int record_count = 0;
+
+            for (record_count = 1; record_count <= 200; record_count += record_count < 20 ? 1 : 37)
+            {
+                char* document = test_create_records(record_count, i);
+                unsigned int used_count = test_document(handles, handle, document, flags[j]);
+
+                // NOTE: Otherwise the splits were never tested.  Not every
+                // worker finds one, the keys of the object root are made
+                // to fool the quote guess.
+                TEST_CHECK(record_count < 100 || used_count > 1);
+                free(document);
+            }
+        }
+    }
+
+    for (i = 0; i < TEST_HANDLE_COUNT; ++i)
+    {
+        nuj_release(handles[i]);
+    }
+
+    nuj_release(handle);
+
+    return test_finish("nu_json_parallel_test");
+}
@@ -0,0 +1,158 @@
+// NOTE: JSON Pointers and dotted paths must find what walking the tree
+// by hand finds, with ~0 and ~1 unescaped, and invalid pointers must be
+// rejected without taking anything from the handle.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static const char test_document[] =
+    "{\"orders\":[{\"id\":1,\"price\":9.5},{\"id\":2,\"price\":3},{\"id\":3,\"items\":[10,11,12,13,14,15,16,17,18,19,20]}],"
+    "\"a/b\":1,\"m~n\":2,\"~1\":3,\"\":4,\"0\":5,\"01\":6,\"x.y\":7,"
+    "\"k0\":0,\"k1\":1,\"k2\":2,\"k3\":3,\"k4\":4,\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,\"k9\":9}";
+
+static NUJElement* test_find(NUJHandle path_handle, const NUJElement* root, const char* path)
+{
+    NUJPath* nuj_path = nuj_compile_path(path_handle, path);
+
+    return nuj_path ? nuj_find_element_by_path(root, nuj_path) : 0;
+}
+
+// NOTE: path finds an integer of value, or nothing for a value of -1.
+static void test_path(NUJHandle path_handle, const NUJElement* root, const char* path, long long value)
+{
+    NUJElement* found = test_find(path_handle, root, path);
+    int result = value < 0 ? !found : found && found->type == NUJInteger_TYPE && NUJ_INTEGER(found)->value == value;
+
+    if (!TEST_CHECK(result))
+    {
+        fprintf(stderr, "  path \"%s\", expected %lld\n", path, value);
+    }
+}
+
+static void test_paths(NUJHandle path_handle, const NUJElement* root)
+{
+    NUJElement* orders = nuj_find_element_by_name(root, "orders");
+
+    // NOTE: The root itself, and containers.
+    TEST_CHECK(test_find(path_handle, root, "") == root);
+    TEST_CHECK(test_find(path_handle, root, "/orders") == orders);
+    TEST_CHECK(test_find(path_handle, root, "orders") == orders);
+    TEST_CHECK(test_find(path_handle, root, "/orders/2") == NUJ_CHILD(orders, 2));
+    TEST_CHECK(test_find(path_handle, root, "orders.0.price") == NUJ_CHILD(NUJ_CHILD(orders, 0), 1));
+
+    test_path(path_handle, root, "/orders/0/id", 1);
+    test_path(path_handle, root, "/orders/1/price", 3);
+    test_path(path_handle, root, "orders.2.id", 3);
+    test_path(path_handle, root, "/orders/2/items/0", 10);
+    test_path(path_handle, root, "/orders/2/items/10", 20);
+    test_path(path_handle, root, "orders.2.items.9", 19);
+
+    // NOTE: Array indexes out of range, with leading zeros, signs or
+    // names don't match.
+    test_path(path_handle, root, "/orders/3/id", -1);
+    test_path(path_handle, root, "/orders/2/items/11", -1);
+    test_path(path_handle, root, "/orders/2/items/01", -1);
+    test_path(path_handle, root, "/orders/2/items/-1", -1);
+    test_path(path_handle, root, "/orders/2/items/+1", -1);
+    test_path(path_handle, root, "/orders/id", -1);
+    test_path(path_handle, root, "/orders/4294967296/id", -1);
+
+    // NOTE: Object members named like indexes are names.
+    test_path(path_handle, root, "/0", 5);
+    test_path(path_handle, root, "/01", 6);
+
+    // NOTE: Escapes, and the empty name.
+    test_path(path_handle, root, "/a~1b", 1);
+    test_path(path_handle, root, "/m~0n", 2);
+    test_path(path_handle, root, "/~01", 3);
+    test_path(path_handle, root, "/", 4);
+    test_path(path_handle, root, "/a/b", -1);
+    test_path(path_handle, root, "/x.y", 7);
+    test_path(path_handle, root, "x.y", -1);
+
+    // NOTE: Scalars have no children.
+    test_path(path_handle, root, "/k1/0", -1);
+    test_path(path_handle, root, "k1.x", -1);
+    test_path(path_handle, root, "/missing", -1);
+    test_path(path_handle, root, "/orders/0/missing", -1);
+    test_path(path_handle, root, "/k9", 9);
+}
+
+static void test_batch(NUJHandle path_handle, const NUJElement* root)
+{
+    const NUJElement* elements[3] = { 0 };
+    const NUJPath* paths[2] = { 0 };
+    NUJElement* results[6] = { 0 };
+    NUJElement* orders = nuj_find_element_by_name(root, "orders");
+
+    elements[0] = NUJ_CHILD(orders, 0);
+    elements[1] = 0;
+    elements[2] = NUJ_CHILD(orders, 2);
+    paths[0] = nuj_compile_path(path_handle, "/id");
+    paths[1] = nuj_compile_path(path_handle, "price");
+
+    nuj_find_elements_by_paths(elements, 3, paths, 2, results);
+    TEST_CHECK(results[0] == NUJ_CHILD(elements[0], 0) && results[1] == NUJ_CHILD(elements[0], 1));
+    TEST_CHECK(!results[2] && !results[3]);
+    TEST_CHECK(results[4] == NUJ_CHILD(elements[2], 0) && !results[5]);
+}
+
+// NOTE: A '~' not followed by '0' or '1' is not a valid pointer.
+static void test_invalid(NUJHandle path_handle)
+{
+    static const char* paths[] = { "/~", "/a~", "/~2", "/a~/b", "/~~0", "/a/~x", "/~1~" };
+    unsigned long long used_size = nuj_get_used_size(path_handle);
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(paths) / sizeof(*paths); ++i)
+    {
+        TEST_CHECK(!nuj_compile_path(path_handle, paths[i]));
+        TEST_CHECK(nuj_get_used_size(path_handle) == used_size);
+    }
+
+    // NOTE: Dotted paths have no escapes.
+    TEST_CHECK(nuj_compile_path(path_handle, "a~.b") != 0);
+}
+
+static void test_full(void)
+{
+    static long long memory[1 << 10];
+    NUJHandle handle = nuj_init(memory, nuj_get_init_size(sizeof(NUJHandleInternal) + 256));
+    unsigned int count = 0;
+
+    while (nuj_compile_path(handle, "/orders/0/price") && count < 100)
+    {
+        ++count;
+    }
+
+    TEST_CHECK(count > 0 && count < 100);
+}
+
+int main(void)
+{
+    NUJHandle handle = test_create_handle();
+    NUJHandle path_handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)test_document, 0);
+
+    if (TEST_CHECK(root != 0))
+    {
+        test_paths(path_handle, root);
+        test_batch(path_handle, root);
+
+        // NOTE: Again through the key index.
+        nuj_find_child_by_name(handle, root, "k0");
+        TEST_CHECK(NUJ_OBJECT(root)->index != 0);
+        test_paths(path_handle, root);
+    }
+
+    test_invalid(path_handle);
+    test_full();
+
+    nuj_release(path_handle);
+    nuj_release(handle);
+
+    return test_finish("nu_json_path_test");
+}
@@ -0,0 +1,204 @@
+// NOTE: The push parser must build the same tree as nuj_parse however
+// the input is cut into chunks: at every split point, at every pair of
+// split points of the shorter documents, and in chunks of 1 to 8
+// bytes.  Chunks are fed from a copy that is overwritten after
+// nuj_push_feed, because they don't have to outlive the call.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static const char* test_documents[] =
+{
+    "{}",
+    "{\"a\":1}",
+    " {\"a\" : [ ] , \"b\" : { } } ",
+    "{\"name\":\"value with spaces\",\"n\":-12.5e-3,\"t\":true,\"f\":false,\"z\":null}",
+    "{\"escaped\":\"quote \\\" backslash \\\\ slash \\/ \\u00e9 \\ud83d\\ude00 end\",\"k\\\"ey\":\"\\\\\"}",
+    "{\"nested\":{\"array\":[1,[2,[3,[]]],{\"x\":{}}],\"empty\":{}},\"last\":[true,false,null]}",
+    "{ \"spaced\" :  [ 1 , 2 ,3 ] ,\n\t\"numbers\":[0,-0,1e10,1E+2,-3.25e-7,0.5,123456789012345678,"
+    "9223372036854775807,-9223372036854775808,18446744073709551615]}",
+    "{\"strings\":[\"\",\"a\",\"ab\",\"\\n\",\"\\\\\",\"\\\"\",\",]}\"],\"utf8\":\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"}",
+};
+
+// NOTE: Invalid documents, neither parser may return a tree.
+static const char* test_invalid_documents[] =
+{
+    "",
+    "{",
+    "{\"a\":1",
+    "{\"a\":}",
+    "{\"a\" 1}",
+    "{\"a\":tru}",
+    "{\"a\":nul}",
+    "{\"a\":[1,2}",
+    "{\"a\":1]",
+    "{\"a\":\"unterminated}",
+    "[1,2]",
+};
+
+static unsigned char test_scratch[4096];
+
+static int test_feed(NUJPushParser* parser, const char* chunk, unsigned long long chunk_size)
+{
+    int result = 0;
+
+    memcpy(test_scratch, chunk, (size_t)chunk_size);
+    result = nuj_push_feed(parser, test_scratch, chunk_size);
+    memset(test_scratch, 'x', (size_t)chunk_size);
+
+    return result;
+}
+
+// NOTE: Feeds document cut at the given split points, which are in
+// order, and returns what nuj_push_end returned written out.
+static char* test_push(NUJHandle handle, const char* document, unsigned long long size, const unsigned long long* splits, unsigned int split_count)
+{
+    NUJPushParser* parser = nuj_push_begin(handle, 0);
+    unsigned long long start = 0;
+    unsigned int i = 0;
+    int result = parser != 0;
+
+    for (i = 0; result && i <= split_count; ++i)
+    {
+        unsigned long long end = i < split_count ? splits[i] : size;
+
+        result = test_feed(parser, document + start, end - start);
+        start = end;
+    }
+
+    return test_write(result ? nuj_push_end(parser) : 0);
+}
+
+static void test_document(NUJHandle handle, NUJHandle push_handle, const char* document)
+{
+    unsigned long long size = strlen(document);
+    unsigned long long splits[2048];
+    char* expected = 0;
+    char* actual = 0;
+    unsigned long long i = 0;
+    unsigned long long j = 0;
+    unsigned int chunk_size = 0;
+
+    TEST_CHECK(size < sizeof(test_scratch) && size < sizeof(splits) / sizeof(*splits));
+
+    nuj_reset_used_size(handle);
+    expected = test_write(nuj_parse_flags(handle, (const unsigned char*)document, size, NUJ_PARSE_SOFT_ERRORS));
+
+    for (i = 0; i <= size; ++i)
+    {
+        actual = test_push(push_handle, document, size, &i, 1);
+
+        if (!TEST_CHECK(!strcmp(expected, actual)))
+        {
+            fprintf(stderr, "  split at %llu of %s\n  expected %s\n  actual   %s\n", i, document, expected, actual);
+        }
+
+        free(actual);
+    }
+
+    for (i = 0; size <= 160 && i <= size; ++i)
+    {
+        for (j = i; j <= size; ++j)
+        {
+            unsigned long long pair[2];
+
+            pair[0] = i;
+            pair[1] = j;
+            actual = test_push(push_handle, document, size, pair, 2);
+
+            if (!TEST_CHECK(!strcmp(expected, actual)))
+            {
+                fprintf(stderr, "  splits at %llu and %llu of %s\n", i, j, document);
+            }
+
+            free(actual);
+        }
+    }
+
+    for (chunk_size = 1; chunk_size <= 8; ++chunk_size)
+    {
+        unsigned int split_count = 0;
+
+        for (i = chunk_size; i < size; i += chunk_size)
+        {
+            splits[split_count++] = i;
+        }
+
+        actual = test_push(push_handle, document, size, splits, split_count);
+
+        if (!TEST_CHECK(!strcmp(expected, actual)))
+        {
+            fprintf(stderr, "  chunks of %u of %s\n", chunk_size, document);
+        }
+
+        free(actual);
+    }
+
+    free(expected);
+}
+
+static void test_long_string(NUJHandle handle, NUJHandle push_handle)
+{
+    char document[1024];
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    length += (unsigned int)sprintf(document, "{\"long\":\"");
+
+    for (i = 0; i < 300; ++i)
+    {
+        document[length++] = (char)('a' + i % 26);
+
+        if (i % 50 == 0)
+        {
+            memcpy(document + length, "\\u0041\\\\", 8);
+            length += 8;
+        }
+    }
+
+    memcpy(document + length, "\",\"after\":[1.5,\"x\"]}", 21);
+    test_document(handle, push_handle, document);
+}
+
+int main(void)
+{
+    NUJHandle handle = test_create_handle();
+    NUJHandle push_handle = test_create_handle();
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(test_documents) / sizeof(*test_documents); ++i)
+    {
+        char* text = 0;
+
+        nuj_reset_used_size(handle);
+        text = test_write(nuj_parse_flags(handle, (const unsigned char*)test_documents[i], 0, NUJ_PARSE_SOFT_ERRORS));
+        TEST_CHECK(strcmp(text, "(null)"));
+        free(text);
+
+        test_document(handle, push_handle, test_documents[i]);
+    }
+
+    for (i = 0; i < sizeof(test_invalid_documents) / sizeof(*test_invalid_documents); ++i)
+    {
+        unsigned long long size = strlen(test_invalid_documents[i]);
+        unsigned long long split = 0;
+
+        for (split = 0; split <= size; ++split)
+        {
+            char* text = test_push(push_handle, test_invalid_documents[i], size, &split, 1);
+
+            TEST_CHECK(!strcmp(text, "(null)"));
+            free(text);
+        }
+    }
+
+    test_long_string(handle, push_handle);
+
+    nuj_release(handle);
+    nuj_release(push_handle);
+
+    return test_finish("nu_json_push_test");
+}
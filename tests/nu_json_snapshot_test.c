@@ -0,0 +1,184 @@
+// NOTE: A snapshot written to memory or saved to a file must load back
+// to the same document, and anything that isn't a whole snapshot of
+// this version and byte order must not load.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+typedef struct TestBuffer
+{
+    unsigned long long* words;
+    unsigned long long size;
+    unsigned long long max_size;
+    unsigned long long fail_after;
+} TestBuffer;
+
+// NOTE: Appends to a buffer of 8 byte words, so loads are aligned.
+// Fails once fail_after writes were made, if it isn't 0.
+static int test_buffer_write(void* user_data, const void* data, unsigned long long size)
+{
+    TestBuffer* buffer = (TestBuffer*)user_data;
+    int result = !buffer->fail_after || --buffer->fail_after;
+
+    if (result && buffer->size + size > buffer->max_size)
+    {
+        buffer->max_size = (buffer->size + size) * 2 + 64;
+        buffer->words = (unsigned long long*)realloc(buffer->words, (size_t)buffer->max_size);
+    }
+
+    if (result)
+    {
+        memcpy((char*)buffer->words + buffer->size, data, (size_t)size);
+        buffer->size += size;
+    }
+
+    return result;
+}
+
+static int test_same_document(const NUJDocument* a, const NUJDocument* b)
+{
+    return a && b && nuj_get_document_size(a) == nuj_get_document_size(b) && !memcmp(a, b, (size_t)nuj_get_document_size(a));
+}
+
+// NOTE: Changes to the header and sizes that loading must reject.
+static void test_reject(const TestBuffer* buffer)
+{
+    static const unsigned int offsets[] = { 0, 4, 8, 12, 16 };
+    unsigned long long* words = (unsigned long long*)malloc((size_t)buffer->size + 8);
+    unsigned long long size = 0;
+    unsigned int i = 0;
+
+    memcpy(words, buffer->words, (size_t)buffer->size);
+    TEST_CHECK(nuj_load_snapshot(words, buffer->size) != 0);
+
+    // NOTE: Every truncation fails.
+    for (size = 0; size < buffer->size; size += size < 64 ? 1 : 7)
+    {
+        if (!TEST_CHECK(!nuj_load_snapshot(words, size)))
+        {
+            fprintf(stderr, "  loaded %llu of %llu bytes\n", size, buffer->size);
+        }
+    }
+
+    // NOTE: magic, version, byte order, header size and document size.
+    for (i = 0; i < sizeof(offsets) / sizeof(*offsets); ++i)
+    {
+        ((unsigned char*)words)[offsets[i]] ^= 0x10;
+        TEST_CHECK(!nuj_load_snapshot(words, buffer->size));
+        ((unsigned char*)words)[offsets[i]] ^= 0x10;
+    }
+
+    // NOTE: Misaligned memory.
+    memmove((char*)words + 4, words, (size_t)buffer->size);
+    TEST_CHECK(!nuj_load_snapshot((char*)words + 4, buffer->size));
+
+    TEST_CHECK(!nuj_load_snapshot(0, buffer->size));
+
+    free(words);
+}
+
+static void test_snapshot(const char* text, unsigned int flags, int reject)
+{
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)text, 0);
+    NUJDocument* document = root ? nuj_create_document(handle, root, flags) : 0;
+    TestBuffer buffer = { 0 };
+
+    if (TEST_CHECK(document != 0))
+    {
+        unsigned long long size = nuj_write_snapshot(document, test_buffer_write, &buffer);
+        const NUJDocument* loaded = nuj_load_snapshot(buffer.words, buffer.size);
+
+        TEST_CHECK(size == buffer.size && size == 32 + nuj_get_document_size(document));
+        TEST_CHECK(test_same_document(loaded, document));
+
+        // NOTE: Loaded documents are read in place.
+        TEST_CHECK(loaded && nuj_get_node_child_count(loaded, 0) == NUJ_CHILD_COUNT(root));
+        TEST_CHECK((const char*)loaded == (const char*)buffer.words + 32);
+
+        // NOTE: Trailing bytes after the document are allowed.
+        TEST_CHECK(nuj_load_snapshot(buffer.words, buffer.max_size) == loaded);
+
+        if (reject)
+        {
+            test_reject(&buffer);
+        }
+    }
+
+    free(buffer.words);
+    nuj_release(handle);
+}
+
+static void test_file(void)
+{
+    static const char path[] = "nu_json_snapshot_test.snapshot";
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)test_get_document(9), 0);
+    NUJDocument* document = root ? nuj_create_document(handle, root, NUJ_DOCUMENT_PARENTS) : 0;
+    TestBuffer buffer = { 0 };
+
+    if (TEST_CHECK(document && nuj_save_snapshot(document, path)))
+    {
+        unsigned long long size = 0;
+        const unsigned char* memory = nuj_map_file(path, &size);
+        const NUJDocument* loaded = memory ? nuj_load_snapshot(memory, size) : 0;
+        unsigned int records = loaded ? nuj_find_node_by_name(loaded, 0, "records") : 0;
+
+        // NOTE: The file holds what nuj_write_snapshot writes.
+        nuj_write_snapshot(document, test_buffer_write, &buffer);
+        TEST_CHECK(memory && size == buffer.size && !memcmp(memory, buffer.words, (size_t)size));
+        TEST_CHECK(test_same_document(loaded, document));
+        TEST_CHECK(records && nuj_get_node_child_count(loaded, records) == 3);
+        TEST_CHECK(records && nuj_get_node_parent(loaded, nuj_get_node_child(loaded, records, 2)) == records);
+
+        if (memory)
+        {
+            nuj_unmap_file(memory, size);
+        }
+    }
+
+    TEST_CHECK(!nuj_save_snapshot(document, "missing_directory/nu_json_snapshot_test.snapshot"));
+
+    remove(path);
+    free(buffer.words);
+    nuj_release(handle);
+}
+
+// NOTE: A failed write fails the snapshot.
+static void test_write_failure(void)
+{
+    NUJHandle handle = test_create_handle();
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)test_get_document(1), 0);
+    NUJDocument* document = root ? nuj_create_document(handle, root, 0) : 0;
+    TestBuffer buffer = { 0 };
+    unsigned int i = 0;
+
+    for (i = 1; document && i <= 2; ++i)
+    {
+        buffer.size = 0;
+        buffer.fail_after = i;
+        TEST_CHECK(!nuj_write_snapshot(document, test_buffer_write, &buffer));
+    }
+
+    free(buffer.words);
+    nuj_release(handle);
+}
+
+int main(void)
+{
+    unsigned int i = 0;
+
+    for (i = 0; test_get_document(i); ++i)
+    {
+        test_snapshot(test_get_document(i), 0, i == 1);
+        test_snapshot(test_get_document(i), NUJ_DOCUMENT_PARENTS, i == 2);
+    }
+
+    test_file();
+    test_write_failure();
+
+    return test_finish("nu_json_snapshot_test");
+}
@@ -0,0 +1,197 @@
+// NOTE: Strings and names parsed with NUJ_PARSE_VIEWS must point at
+// the escaped bytes of the input, the ones a copying parse stores, and
+// nuj_parse_insitu must leave them decoded as nuj_decode_string does.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+typedef struct TestString
+{
+    const char* input;
+    const char* decoded;
+    unsigned int decoded_length;
+} TestString;
+
+static const TestString test_strings[] =
+{
+    { "plain",                          "plain",                         5 },
+    { "",                               "",                              0 },
+    { "a\\\"b",                         "a\"b",                          3 },
+    { "\\\\\\/\\b\\f\\n\\r\\t",         "\\/\b\f\n\r\t",                 7 },
+    { "\\u0041\\u00e9\\u20AC",          "A\xC3\xA9\xE2\x82\xAC",         6 },
+    { "\\ud83d\\ude00!",                "\xF0\x9F\x98\x80!",             5 },
+    { "\\ud83dx",                       "\xEF\xBF\xBDx",                 4 },
+    { "\\ude00",                        "\xEF\xBF\xBD",                  3 },
+    { "\\ud83d\\u0041",                 "\xEF\xBF\xBD" "A",              4 },
+    { "x\\u0000y",                      "x\0y",                          3 },
+    { "caf\xC3\xA9 \xE2\x82\xAC",       "caf\xC3\xA9 \xE2\x82\xAC",      9 },
+    { "\\\\\\\\\\\"",                   "\\\\\"",                        3 },
+};
+
+// NOTE: s is at the length bytes expected.
+static int test_equal(const char* s, unsigned int length, const char* expected, unsigned int expected_length)
+{
+    return length == expected_length && !memcmp(s, expected, length);
+}
+
+static int test_in_buffer(const char* s, const unsigned char* buffer, unsigned long long buffer_size)
+{
+    return (const unsigned char*)s > buffer && (const unsigned char*)s < buffer + buffer_size;
+}
+
+// NOTE: {"<input>":"<input>","a":["<input>"]} parsed the three ways.
+static void test_string(const char* input, const char* decoded, unsigned int decoded_length)
+{
+    unsigned long long length = 0;
+    char* document = (char*)malloc(3 * strlen(input) + 32);
+    unsigned char* copy = 0;
+    NUJHandle handles[3] = { 0 };
+    NUJElement* roots[3] = { 0 };
+    unsigned int i = 0;
+
+    length = (unsigned long long)sprintf(document, "{\"%s\":\"%s\",\"a\":[\"%s\"]}", input, input, input);
+    copy = (unsigned char*)malloc(length + 1);
+    memcpy(copy, document, length + 1);
+
+    for (i = 0; i < 3; ++i)
+    {
+        handles[i] = test_create_handle();
+    }
+
+    roots[0] = nuj_parse(handles[0], (const unsigned char*)document, length);
+    roots[1] = nuj_parse_flags(handles[1], (const unsigned char*)document, length, NUJ_PARSE_VIEWS);
+    roots[2] = nuj_parse_insitu(handles[2], copy, length, 0);
+
+    if (TEST_CHECK(roots[0] && roots[1] && roots[2]))
+    {
+        const char* s[3][3] = { { 0 } };
+        unsigned int s_length[3][3] = { { 0 } };
+        char* buffer = (char*)malloc(strlen(input) + 1);
+        unsigned int buffer_length = 0;
+        unsigned int j = 0;
+
+        for (i = 0; i < 3; ++i)
+        {
+            s[i][0] = nuj_get_name(NUJ_CHILD(roots[i], 0), &s_length[i][0]);
+            s[i][1] = nuj_get_string(NUJ_CHILD(roots[i], 0), &s_length[i][1]);
+            s[i][2] = nuj_get_string(NUJ_CHILD(NUJ_CHILD(roots[i], 1), 0), &s_length[i][2]);
+        }
+
+        for (j = 0; j < 3; ++j)
+        {
+            // NOTE: Copies are escaped and null terminated.
+            TEST_CHECK(test_equal(s[0][j], s_length[0][j], input, (unsigned int)strlen(input)));
+            TEST_CHECK(s[0][j][s_length[0][j]] == '\0');
+            TEST_CHECK(!test_in_buffer(s[0][j], (const unsigned char*)document, length));
+
+            buffer_length = nuj_decode_string(s[0][j], s_length[0][j], buffer);
+            TEST_CHECK(test_equal(buffer, buffer_length, decoded, decoded_length));
+
+            // NOTE: Views are the same bytes, in the input.
+            TEST_CHECK(test_equal(s[1][j], s_length[1][j], s[0][j], s_length[0][j]));
+            TEST_CHECK(test_in_buffer(s[1][j], (const unsigned char*)document, length));
+            TEST_CHECK(s[1][j][s_length[1][j]] == '"');
+
+            // NOTE: In place strings are decoded and terminated.
+            if (!TEST_CHECK(test_equal(s[2][j], s_length[2][j], buffer, buffer_length)))
+            {
+                fprintf(stderr, "  in place \"%s\" decoded to %u bytes\n", input, s_length[2][j]);
+            }
+
+            TEST_CHECK(test_in_buffer(s[2][j], copy, length));
+            TEST_CHECK(s[2][j][s_length[2][j]] == '\0');
+        }
+
+        // NOTE: Views and in place names take nothing from the handle.
+        TEST_CHECK(nuj_get_used_size(handles[1]) == nuj_get_used_size(handles[2]));
+        TEST_CHECK(nuj_get_used_size(handles[1]) == nuj_measure_flags((const unsigned char*)document, length, NUJ_PARSE_VIEWS));
+        TEST_CHECK(nuj_get_used_size(handles[0]) == nuj_measure_flags((const unsigned char*)document, length, 0));
+
+        free(buffer);
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        nuj_release(handles[i]);
+    }
+
+    free(copy);
+    free(document);
+}
+
+// NOTE: Escapes the parser doesn't validate are decoded as they are.
+static void test_decode(void)
+{
+    char buffer[32];
+    char string[32];
+    unsigned int length = 0;
+
+    length = nuj_decode_string("a\\qb", 4, buffer);
+    TEST_CHECK(test_equal(buffer, length, "a\\qb", 4));
+
+    length = nuj_decode_string("a\\", 2, buffer);
+    TEST_CHECK(test_equal(buffer, length, "a\\", 2));
+
+    length = nuj_decode_string("\\u12", 4, buffer);
+    TEST_CHECK(test_equal(buffer, length, "\\u12", 4));
+
+    length = nuj_decode_string("\\u00zz", 6, buffer);
+    TEST_CHECK(test_equal(buffer, length, "\\u00zz", 6));
+
+    // NOTE: The length ends the string, not a null.
+    length = nuj_decode_string("\\n\\t", 2, buffer);
+    TEST_CHECK(test_equal(buffer, length, "\n", 1));
+
+    // NOTE: In place.
+    memcpy(string, "x\\u00e9\\ud83d\\ude00\\\"y", 23);
+    length = nuj_decode_string(string, 22, string);
+    TEST_CHECK(test_equal(string, length, "x\xC3\xA9\xF0\x9F\x98\x80\"y", 9));
+}
+
+int main(void)
+{
+    char long_input[1024];
+    char long_decoded[1024];
+    unsigned int input_length = 0;
+    unsigned int decoded_length = 0;
+    unsigned int i = 0;
+
+    for (i = 0; i < sizeof(test_strings) / sizeof(*test_strings); ++i)
+    {
+        test_string(test_strings[i].input, test_strings[i].decoded, test_strings[i].decoded_length);
+    }
+
+    // NOTE: Long enough for several blocks of the structural index,
+    // with escapes across their boundaries.
+    for (i = 0; i < 200; ++i)
+    {
+        if (i % 7 == 3)
+        {
+            memcpy(long_input + input_length, "\\\"", 2);
+            input_length += 2;
+            long_decoded[decoded_length++] = '"';
+        }
+        else if (i % 11 == 5)
+        {
+            memcpy(long_input + input_length, "\\u00e9", 6);
+            input_length += 6;
+            memcpy(long_decoded + decoded_length, "\xC3\xA9", 2);
+            decoded_length += 2;
+        }
+        else
+        {
+            long_input[input_length++] = (char)('a' + i % 26);
+            long_decoded[decoded_length++] = (char)('a' + i % 26);
+        }
+    }
+
+    long_input[input_length] = '\0';
+    test_string(long_input, long_decoded, decoded_length);
+
+    test_decode();
+
+    return test_finish("nu_json_string_test");
+}
@@ -0,0 +1,240 @@
+// NOTE: A tape must hold the same tree as the elements nuj_parse makes
+// of the same input, also when the input outgrows the first guess of
+// its word and string sizes, and a failed tape must give back what it
+// took from the handle.
+
+#define TRUE 1
+#define FALSE 0
+#define NU_JSON_IMPLEMENTATION
+#include "nu_json.h"
+#include "nu_json_test.h"
+
+static int test_same_bytes(const char* a, unsigned int a_length, const char* b, unsigned int b_length)
+{
+    return a_length == b_length && !memcmp(a, b, a_length);
+}
+
+// NOTE: The entry of the first child of entry named name_length bytes
+// of name, what nuj_find_tape_child must find.
+static unsigned int test_first_named(const NUJTape* tape, unsigned int entry, const char* name, unsigned int name_length)
+{
+    unsigned int child = nuj_get_tape_first_child(tape, entry);
+    unsigned int found = 0;
+
+    while (!found && child)
+    {
+        unsigned int length = 0;
+        const char* child_name = nuj_get_tape_name(tape, child, &length);
+
+        found = test_same_bytes(child_name, length, name, name_length) ? child : 0;
+        child = nuj_get_tape_next_sibling(tape, child);
+    }
+
+    return found;
+}
+
+static int test_compare_entry(const NUJTape* tape, unsigned int entry, const NUJElement* element, int named)
+{
+    const char* name = 0;
+    const char* string = 0;
+    unsigned int length = 0;
+    int result = nuj_get_tape_type(tape, entry) == element->type;
+
+    name = nuj_get_tape_name(tape, entry, &length);
+    result = result && (named ? name && test_same_bytes(name, length, element->name, element->name_length) : !name && !length);
+
+    switch (result ? element->type : NUJNone_TYPE)
+    {
+        case NUJString_TYPE:
+        {
+            string = nuj_get_tape_string(tape, entry, &length);
+            result = test_same_bytes(string, length, NUJ_CSTRING(element)->value, NUJ_CSTRING(element)->length) && !string[length];
+        }
+        break;
+        case NUJInteger_TYPE:
+        {
+            result = nuj_get_tape_integer(tape, entry) == NUJ_CINTEGER(element)->value;
+        }
+        break;
+        case NUJDouble_TYPE:
+        {
+            double number = nuj_get_tape_double(tape, entry);
+
+            result = !memcmp(&number, &NUJ_CDOUBLE(element)->value, sizeof(number));
+        }
+        break;
+        case NUJBoolean_TYPE:
+        {
+            result = nuj_get_tape_boolean(tape, entry) == (NUJ_CBOOLEAN(element)->value != 0);
+        }
+        break;
+        case NUJObject_TYPE:
+        case NUJArray_TYPE:
+        {
+            unsigned int child = nuj_get_tape_first_child(tape, entry);
+            unsigned int i = 0;
+
+            result = nuj_get_tape_child_count(tape, entry) == NUJ_CHILD_COUNT(element) && (child != 0) == (NUJ_CHILD_COUNT(element) != 0);
+
+            for (i = 0; result && i < NUJ_CHILD_COUNT(element); ++i)
+            {
+                const NUJElement* element_child = NUJ_CHILD(element, i);
+                unsigned int next = nuj_get_tape_next_sibling(tape, child);
+
+                result = child && test_compare_entry(tape, child, element_child, element->type == NUJObject_TYPE);
+
+                // NOTE: Skipping a child lands on its next sibling, or
+                // on the close word after the last one.
+                result = result && (next ? nuj_skip_tape_element(tape, child) == next : i == NUJ_CHILD_COUNT(element) - 1);
+
+                // NOTE: Of duplicated names the first one is found.
+                if (result && element->type == NUJObject_TYPE)
+                {
+                    result = nuj_find_tape_child(tape, entry, element_child->name) ==
+                             test_first_named(tape, entry, element_child->name, element_child->name_length);
+                }
+
+                child = next;
+            }
+
+            if (result && element->type == NUJObject_TYPE)
+            {
+                result = !nuj_find_tape_child(tape, entry, "missing");
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+static void test_tape(const char* text)
+{
+    NUJHandle handle = test_create_handle();
+    NUJHandle tape_handle = test_create_handle();
+    unsigned long long used_size = nuj_get_used_size(tape_handle);
+    NUJElement* root = nuj_parse(handle, (const unsigned char*)text, 0);
+    NUJTape* tape = nuj_parse_tape(tape_handle, (const unsigned char*)text, 0);
+
+    if (TEST_CHECK(root && tape))
+    {
+        if (!TEST_CHECK(test_compare_entry(tape, 0, root, 0)))
+        {
+            fprintf(stderr, "  %.60s\n", text);
+        }
+
+        // NOTE: What the tape didn't use is given back.
+        TEST_CHECK(nuj_get_used_size(tape_handle) - used_size == nuj_get_tape_size(tape));
+        TEST_CHECK(nuj_skip_tape_element(tape, 0) == tape->word_count);
+    }
+
+    nuj_release(tape_handle);
+    nuj_release(handle);
+}
+
+// NOTE: Any value is a root of a tape, it is compared to the value of
+// {"v":<value>}.
+static void test_value(const char* value)
+{
+    NUJHandle handle = test_create_handle();
+    char* text = (char*)malloc(strlen(value) + 8);
+    NUJElement* root = 0;
+    NUJTape* tape = 0;
+
+    sprintf(text, "{\"v\":%s}", value);
+    root = nuj_parse(handle, (const unsigned char*)text, 0);
+    tape = nuj_parse_tape(handle, (const unsigned char*)value, 0);
+
+    if (TEST_CHECK(root && tape))
+    {
+        TEST_CHECK(test_compare_entry(tape, 0, NUJ_CHILD(root, 0), 0));
+    }
+
+    nuj_release(handle);
+    free(text);
+}
+
+// NOTE: Inputs of small values need more than a word per 8 bytes, and
+// of short strings more string bytes than half their size.
+static char* test_create_dense(unsigned int count, int strings)
+{
+    char* text = (char*)malloc(count * 4 + 16);
+    unsigned int length = 0;
+    unsigned int i = 0;
+
+    text[length++] = '[';
+
+    for (i = 0; i < count; ++i)
+    {
+        length += (unsigned int)sprintf(text + length, strings ? "%s\"%c\"" : "%s%c", i ? "," : "", (char)('0' + i % 10));
+    }
+
+    memcpy(text + length, "]", 2);
+
+    return text;
+}
+
+static void test_grow(void)
+{
+    static long long memory[1 << 12];
+    static const char* invalid[] = { "[1,2", "{\"a\":1,}", "[1] 2" };
+    char* numbers = test_create_dense(5000, 0);
+    char* strings = test_create_dense(5000, 1);
+    NUJHandle handle = 0;
+    NUJTape* tape = 0;
+    unsigned long long used_size = 0;
+    unsigned int i = 0;
+
+    test_value(numbers);
+    test_value(strings);
+
+    handle = test_create_handle();
+    tape = nuj_parse_tape(handle, (const unsigned char*)strings, 0);
+
+    if (TEST_CHECK(tape != 0))
+    {
+        TEST_CHECK(nuj_get_tape_child_count(tape, 0) == 5000);
+        TEST_CHECK(tape->word_count > strlen(strings) / 8 + 8);
+        TEST_CHECK(tape->string_size > strlen(strings) / 2 + 64);
+    }
+
+    nuj_release(handle);
+
+    // NOTE: A handle too small for the tape is left as it was, and
+    // invalid input takes nothing either.
+    handle = nuj_init(memory, sizeof(memory));
+    used_size = nuj_get_used_size(handle);
+    TEST_CHECK(!nuj_parse_tape(handle, (const unsigned char*)strings, 0));
+    TEST_CHECK(nuj_get_used_size(handle) == used_size);
+
+    for (i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+    {
+        TEST_CHECK(!nuj_parse_tape(handle, (const unsigned char*)invalid[i], 0));
+        TEST_CHECK(nuj_get_used_size(handle) == used_size);
+    }
+
+    TEST_CHECK(nuj_parse_tape(handle, (const unsigned char*)"[1,2]", 0) != 0);
+
+    free(strings);
+    free(numbers);
+}
+
+int main(void)
+{
+    static const char* values[] = { "[]", "[1,[2,{}],\"x\"]", "\"s\"", "\"\"", "0", "-12", "2.5", "true", "false", "null" };
+    unsigned int i = 0;
+
+    for (i = 0; test_get_document(i); ++i)
+    {
+        test_tape(test_get_document(i));
+    }
+
+    for (i = 0; i < sizeof(values) / sizeof(*values); ++i)
+    {
+        test_value(values[i]);
+    }
+
+    test_grow();
+
+    return test_finish("nu_json_tape_test");
+}
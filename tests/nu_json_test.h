@@ -0,0 +1,131 @@
+// NOTE: Checks shared by the tests.  Each test is one program that
+// includes the implementation, runs its checks and exits with 1 if any
+// of them failed, see tests/Makefile.
+
+#ifndef NU_JSON_TEST_H
+#define NU_JSON_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int test_check_count = 0;
+static unsigned int test_failure_count = 0;
+
+#define TEST_CHECK(x) test_check((x) != 0, #x, __FILE__, __LINE__)
+
+static int test_check(int passed, const char* text, const char* file, int line)
+{
+    ++test_check_count;
+
+    if (!passed)
+    {
+        ++test_failure_count;
+
+        // NOTE: Only the first failures are printed, a broken loop
+        // would print thousands.
+        if (test_failure_count <= 20)
+        {
+            fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+        }
+    }
+
+    return passed;
+}
+
+// NOTE: Prints the summary and returns the exit code of the test.
+static int test_finish(const char* name)
+{
+    printf("%s: %u checks, %u failed\n", name, test_check_count, test_failure_count);
+
+    return test_failure_count != 0;
+}
+
+static void* test_alloc(void* user_data, unsigned long long size)
+{
+    (void)user_data;
+
+    return malloc((size_t)size);
+}
+
+static void test_free(void* user_data, void* memory, unsigned long long size)
+{
+    (void)user_data;
+    (void)size;
+
+    free(memory);
+}
+
+// NOTE: Chained handles start small so the tests cross block
+// boundaries, and grow without a limit.
+static NUJHandle test_create_handle(void)
+{
+    return nuj_init_chained(test_alloc, test_free, 0, 4096, 0);
+}
+
+// NOTE: Serialized element, or "(null)" for 0.  The caller frees it.
+static char* test_write(const NUJElement* element)
+{
+    unsigned long long size = element ? nuj_write(element, 0, 0, 0) : 6;
+    char* text = (char*)malloc((size_t)size + 1);
+
+    if (element)
+    {
+        nuj_write(element, text, size + 1, 0);
+    }
+    else
+    {
+        memcpy(text, "(null)", 7);
+    }
+
+    return text;
+}
+
+// NOTE: Documents for the tests that read the same input through
+// another representation and compare it to the tree, or 0 after the
+// last one.
+static const char* test_get_document(unsigned int index)
+{
+    static const char* documents[] =
+    {
+        "{}",
+        "{\"s\":\"plain\",\"e\":\"\",\"t\":true,\"f\":false,\"n\":null,\"i\":-42,\"d\":1.5e-3}",
+        "{\"a\":[],\"b\":{},\"c\":[[]],\"d\":[{}],\"e\":[[1,[2,[3]]],{\"x\":{\"y\":{\"z\":[]}}}]}",
+        "{\"esc\":\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\",\"u\":\"\\u00e9\\ud83d\\ude00\",\"k\\u00e9y\":\"v\",\"q\\\"\":1,\"\":2}",
+        "{\"dup\":1,\"other\":2,\"dup\":3,\"obj\":{\"dup\":[4],\"dup\":5}}",
+        "{\"big\":9223372036854775807,\"small\":-9223372036854775808,\"zero\":0,\"neg\":-0.0,"
+        "\"exp\":1e300,\"tiny\":5e-324,\"pi\":3.141592653589793,\"list\":[1,-1,2.5,-2.5e-7,1E+2]}",
+        "{\"k0\":0,\"k1\":[1],\"k2\":{\"v\":2},\"k3\":\"3\",\"k4\":4,\"k5\":5,\"k6\":6,\"k7\":7,\"k8\":8,\"k9\":9,"
+        "\"k10\":10,\"k11\":11,\"k12\":12,\"k13\":13,\"k14\":14,\"k15\":15,\"k16\":16,\"k17\":17,\"k18\":18,\"k19\":19}",
+        "{\"deep\":[[[[[[[[[[[[[[[[[[[[\"x\",{\"y\":[[[[[[[[true]]]]]]]]}]]]]]]]]]]]]]]]]]]]]}",
+        " \t\n{ \"spaced\" : [ 1 , 2 , 3 ] , \"out\" : { \"in\" : null } } \n",
+        "{\"records\":[{\"id\":1,\"name\":\"a\",\"tags\":[\"x\",\"y\"]},{\"id\":2,\"name\":\"b\",\"tags\":[]},"
+        "{\"id\":3,\"name\":\"c\",\"tags\":[\"z\"],\"extra\":{\"deep\":[{},[],\"\"]}}]}",
+    };
+
+    return index < sizeof(documents) / sizeof(*documents) ? documents[index] : 0;
+}
+
+// NOTE: Every child of element and below it has its parent pointer
+// set to the container it is in.
+static int test_parents(const NUJElement* element)
+{
+    unsigned int i = 0;
+
+    if (element->type != NUJObject_TYPE && element->type != NUJArray_TYPE)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < NUJ_CHILD_COUNT(element); ++i)
+    {
+        if (NUJ_CHILD(element, i)->parent != element || !test_parents(NUJ_CHILD(element, i)))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+#endif // NU_JSON_TEST_H